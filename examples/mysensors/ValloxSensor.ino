@@ -120,6 +120,9 @@ Timer timer;
 
 #define SERIAL_BAUDRATE 115200
 
+// maximum number of telegrams decoded per loop (the 64 byte rx buffer holds 10)
+#define RECEIVE_BUDGET 10
+
 
 //-------------------------------------------------------------------------------------------------
 // Child sensor ids
@@ -361,9 +364,7 @@ static uint8_t PROPERTIES_TO_OBSERVE_COUNT = sizeof(PROPERTIES_TO_OBSERVE) / siz
 //-------------------------------------------------------------------------------------------------
 // The active mode makes only sense when a hardware serial is used
 static bool OBSERVE_PROPERTIES_ACTIVE = true;
-static unsigned long OBSERVE_PROPERTIES_INTERVAL_MS = 5000;
-uint8_t nextVariableToPollIndex = 0;
-unsigned long lastPollMillis = 0;
+static uint16_t OBSERVE_PROPERTIES_INTERVAL_MS = 5000;	// bus budget: minimum time between two polls
 
 
 ValloxSerial valloxSerial;
@@ -435,10 +436,24 @@ void setupVallox(Stream* pRxStream, Stream* pTxStream)
 
 	// serial
 	valloxSerial.setSenderId(VALLOX_ADDRESS_PANEL2);
+	valloxSerial.setResynchronize(true); // realign quickly after noise on the bus
+	valloxSerial.setNonBlockingTransmit(true); // setters return at once, receiveAll() sends the queued telegrams
+	valloxSerial.setListenBeforeTalk(3); // do not interrupt the master: wait for 3 idle characters
 
-	valloxSerial.attachPropertyChanged(onPropertyChanged);
+	valloxSerial.setNotificationMode(NotifyPerReceive); // one event per loop: a value changing twice is sent only once
+	valloxSerial.attachPropertiesChanged(onPropertiesChanged);
 	valloxSerial.attach(onStartSending, onStopSending);
 
+	// poll stale values in the background: broadcasted and unchanging values are polled less often
+	if (OBSERVE_PROPERTIES_ACTIVE)
+	{
+		valloxSerial.setScheduleInterval(OBSERVE_PROPERTIES_INTERVAL_MS);
+		for (uint8_t i = 0; i < PROPERTIES_TO_OBSERVE_COUNT; i++)
+		{
+			valloxSerial.schedule(PROPERTIES_TO_OBSERVE[i]);
+		}
+	}
+
 	// for debugging purposes
 	valloxSerial.attachLogger(onLog);
 	valloxSerial.attach(onTelegramReceived);
@@ -516,6 +531,17 @@ void updateBoostTime()
 
 
 
+//-------------------------------------------------------------------------------------------------
+void onPropertiesChanged(const ValloxPropertyMask& changedProperties, const ValloxPropertyStore& properties)
+{
+	uint8_t index = 0;
+	while (changedProperties.next(&index))
+	{
+		onPropertyChanged(ValloxPropertyStore::propertyAt(index), properties.get(index));
+		index++;
+	}
+}
+
 //-------------------------------------------------------------------------------------------------
 void onPropertyChanged(ValloxProperty propertyId, int8_t value)
 {
@@ -1204,9 +1230,6 @@ void presentation()
 	pinMode(SERIAL_TX_CONTROL_PIN, OUTPUT);
 	digitalWrite(SERIAL_TX_CONTROL_PIN, RS485_RX);
 
-	nextVariableToPollIndex = 0;
-	lastPollMillis = millis();
-
 	setupSensor();
 	setupVallox(pRxStream, pTxStream);
 	setupBoostButton();
@@ -1236,44 +1259,13 @@ void sendValuesTimerHandler()
 //-------------------------------------------------------------------------------------------------
 void loop()
 {
-	// Vallox RS485 RX
-	if (valloxSerial.receive())
+	// Vallox RS485 RX: drain all complete telegrams so that the rx buffer does not overflow
+	// while we are busy with radio traffic.
+	if (valloxSerial.receiveAll(RECEIVE_BUDGET) > 0)
 	{
 		valloxSerial.calculateResults();
 	}
 
-	// Vallox RS485 TX
-	if (OBSERVE_PROPERTIES_ACTIVE)
-	{
-		unsigned long now = millis();
-		if (now > lastPollMillis)
-		{
-			unsigned long delay = now - lastPollMillis;
-			if (delay >= OBSERVE_PROPERTIES_INTERVAL_MS)
-			{
-				ValloxProperty propertyId = PROPERTIES_TO_OBSERVE[nextVariableToPollIndex];
-
-#ifdef PRINT_TX_PROPERTIES
-				Serial.print("Polling ");
-				Serial.println(propertyId, DEC);
-#endif
-				valloxSerial.poll(propertyId);
-				
-				nextVariableToPollIndex++;
-				if (nextVariableToPollIndex == PROPERTIES_TO_OBSERVE_COUNT)
-				{
-					nextVariableToPollIndex = 0;
-				}
-
-				lastPollMillis = now;
-			}
-		}
-		else
-		{
-			lastPollMillis = now; // avoid problems when millis run over
-		}
-	}
-
 	// Vallox Button handling
 	BoostButton.Update();
 	if (BoostButton.clicks != 0)
@@ -0,0 +1,89 @@
+// Stream implementation backed by a byte buffer.
+//
+// Reads are served from a caller supplied buffer which is not copied, writes
+// are only counted. This keeps the stream itself out of the way when the
+// decoder is measured.
+
+#ifndef MemoryStream_h
+#define MemoryStream_h
+
+#include <Stream.h>
+#include <limits.h>
+
+class MemoryStream : public Stream
+{
+public:
+	MemoryStream()
+	{
+		m_pData = NULL;
+		m_Length = 0;
+		m_Position = 0;
+		m_WrittenBytes = 0;
+	}
+
+	void setInput(const uint8_t* pData, size_t length)
+	{
+		m_pData = pData;
+		m_Length = length;
+		m_Position = 0;
+	}
+
+	void rewind()
+	{
+		m_Position = 0;
+	}
+
+	size_t getPosition() const
+	{
+		return m_Position;
+	}
+
+	size_t getWrittenBytes() const
+	{
+		return m_WrittenBytes;
+	}
+
+	int available()
+	{
+		size_t remaining = m_Length - m_Position;
+		return remaining > INT_MAX ? INT_MAX : (int)remaining;
+	}
+
+	int read()
+	{
+		if (m_Position < m_Length)
+		{
+			return m_pData[m_Position++];
+		}
+		return -1;
+	}
+
+	int peek()
+	{
+		if (m_Position < m_Length)
+		{
+			return m_pData[m_Position];
+		}
+		return -1;
+	}
+
+	size_t write(uint8_t value)
+	{
+		m_WrittenBytes++;
+		return 1;
+	}
+
+	size_t write(const uint8_t* pBuffer, size_t size)
+	{
+		m_WrittenBytes += size;
+		return size;
+	}
+
+private:
+	const uint8_t* m_pData;
+	size_t m_Length;
+	size_t m_Position;
+	size_t m_WrittenBytes;
+};
+
+#endif // MemoryStream_h
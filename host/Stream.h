@@ -0,0 +1,35 @@
+// Host replacement for the Arduino Stream class.
+//
+// Only the subset used by the library is provided so that ValloxSerial can be
+// compiled and exercised on Linux without an Arduino core.
+
+#ifndef Stream_h
+#define Stream_h
+
+#include <stddef.h>
+#include <inttypes.h>
+
+class Stream
+{
+public:
+	virtual ~Stream() {}
+
+	virtual int available() = 0;
+	virtual int read() = 0;
+	virtual int peek() = 0;
+
+	virtual size_t write(uint8_t value) = 0;
+	virtual size_t write(const uint8_t* pBuffer, size_t size)
+	{
+		size_t written = 0;
+		while (written < size && write(pBuffer[written]))
+		{
+			written++;
+		}
+		return written;
+	}
+
+	virtual void flush() {}
+};
+
+#endif // Stream_h
@@ -0,0 +1,419 @@
+// Virtual vallox bus with a simulated mainboard and control panels.
+//
+// The simulator is the Stream of the device under test: whatever it writes is
+// put on the bus, everything on the bus including the own telegrams comes back
+// to it. The bus runs on virtual time in us which only moves by advance(), each
+// byte takes one character time at 9600 baud.
+//
+// The master (0x11) broadcasts its variables to the panels 0x20-0x29 and the
+// simulated panels poll its settings, both at the configured rate or back to
+// back on a saturated bus. Polls and writes of the device are answered and
+// taken by the master. From time to time the master suspends the bus for the
+// CO2 sensors with the SUSPEND and RESUME bursts. Telegrams of the device which
+// overlap with traffic of the master are garbled on the bus for both sides.
+// Noise, bit errors and dropped bytes are injected on the way to the device.
+
+#ifndef ValloxBusSimulator_h
+#define ValloxBusSimulator_h
+
+#include <ValloxProtocol.h>
+#include <Stream.h>
+
+#include <algorithm>
+#include <deque>
+#include <random>
+#include <vector>
+#include <string.h>
+
+struct ValloxSimulatorConfig
+{
+	uint16_t telegramsPerSecond = 40;		// traffic of the master and the panels, 0 = saturated bus
+	uint8_t panelCount = 2;					// simulated panels polling the master, starting with 0x21
+	uint32_t suspendIntervalMs = 30000;		// time between two suspensions, 0 = never
+	uint32_t suspendDurationMs = 1500;
+	uint32_t replyDelayUs = 5000;			// the master answers a poll after this time
+	double changeProbability = 0.05;		// a measured value changes before it is broadcast
+	double noiseProbability = 0;			// per byte: a random byte is inserted before it
+	double bitErrorProbability = 0;			// per byte: a single bit is flipped
+	double dropProbability = 0;				// per byte: the byte is lost
+	bool pollsAnswered = true;				// the master answers the polls of the device
+	bool writesTaken = true;				// the master takes the writes of the device
+	uint32_t seed = 4711;
+};
+
+struct ValloxSimulatorStatistics
+{
+	uint32_t sentTelegrams;			// by the simulated master and panels
+	uint32_t receivedTelegrams;		// valid telegrams of the device
+	uint32_t answeredPolls;
+	uint32_t acceptedWrites;
+	uint32_t collidedBytes;			// bytes of the device which met other traffic on the bus
+	uint32_t suspendedTelegrams;	// telegrams of the device sent while the bus was suspended
+	uint32_t suspensions;
+
+	uint32_t noiseBytes;
+	uint32_t corruptedBytes;
+	uint32_t droppedBytes;
+};
+
+class ValloxBusSimulator : public Stream
+{
+public:
+	ValloxBusSimulator(const ValloxSimulatorConfig& config) : m_Config(config), m_Random(config.seed), m_Chance(0.0, 1.0)
+	{
+		memset(m_Variables, 0, sizeof(m_Variables));
+		memset(&m_Statistics, 0, sizeof(m_Statistics));
+
+		m_Variables[VALLOX_VARIABLE_FAN_SPEED] = 0x07;
+		m_Variables[VALLOX_VARIABLE_TEMP_OUTSIDE] = 0x70;
+		m_Variables[VALLOX_VARIABLE_TEMP_EXHAUST] = 0x90;
+		m_Variables[VALLOX_VARIABLE_TEMP_INSIDE] = 0x9C;
+		m_Variables[VALLOX_VARIABLE_TEMP_INCOMMING] = 0x94;
+		m_Variables[VALLOX_VARIABLE_HUMIDITY] = 0x80;
+		m_Variables[VALLOX_VARIABLE_HUMIDITY_SENSOR1] = 0x80;
+		m_Variables[VALLOX_VARIABLE_CO2_LOW] = 0x90;
+		m_Variables[VALLOX_VARIABLE_SELECT] = 0x09;
+		m_Variables[VALLOX_VARIABLE_HEATING_SET_POINT] = 0x99;
+		m_Variables[VALLOX_VARIABLE_FAN_SPEED_MAX] = 0x7F;
+		m_Variables[VALLOX_VARIABLE_FAN_SPEED_MIN] = 0x01;
+		m_Variables[VALLOX_VARIABLE_PRE_HEATING_SET_POINT] = 0x83;
+		m_Variables[VALLOX_VARIABLE_INPUT_FAN_STOP] = 0x64;
+		m_Variables[VALLOX_VARIABLE_HRC_BYPASS] = 0xA0;
+		m_Variables[VALLOX_VARIABLE_CELL_DEFROSTING] = 0x0A;
+
+		m_NowUs = 0;
+		m_BusFreeUs = 0;
+		m_DeviceFreeUs = 0;
+		m_NextTrafficUs = 0;
+		m_NextSuspendUs = (uint64_t)config.suspendIntervalMs * 1000;
+		m_SuspendedUntilUs = 0;
+		m_SuspendStartUs = 0;
+		m_TrafficIndex = 0;
+		m_WindowLength = 0;
+		m_pRecording = NULL;
+	}
+
+	// moves the virtual time on, schedules the traffic due until then and delivers the bytes on the bus
+	void advance(uint32_t us)
+	{
+		m_NowUs += us;
+
+		if (m_Config.suspendIntervalMs != 0 && m_NowUs >= m_NextSuspendUs)
+		{
+			suspend();
+		}
+
+		while (m_NowUs >= m_NextTrafficUs && m_NowUs >= m_SuspendedUntilUs)
+		{
+			scheduleTraffic();
+		}
+
+		deliver();
+	}
+
+	uint64_t getTimeUs() const
+	{
+		return m_NowUs;
+	}
+
+	unsigned long getTimeMs() const
+	{
+		return (unsigned long)(m_NowUs / 1000);
+	}
+
+	bool isSuspended() const
+	{
+		return m_NowUs >= m_SuspendStartUs && m_NowUs < m_SuspendedUntilUs;
+	}
+
+	uint8_t getVariable(uint8_t variable) const
+	{
+		return m_Variables[variable];
+	}
+
+	void setVariable(uint8_t variable, uint8_t value)
+	{
+		m_Variables[variable] = value;
+	}
+
+	// keeps a copy of every byte handed to the device, e.g. as a capture for ValloxReplay
+	void record(std::vector<uint8_t>* pBytes)
+	{
+		m_pRecording = pBytes;
+	}
+
+	// a telegram of the master to all panels, e.g. an outdated value which is still on its way
+	void broadcast(uint8_t variable, uint8_t value)
+	{
+		send(VALLOX_ADDRESS_MASTER, VALLOX_ADDRESS_PANELS, variable, value, m_NowUs);
+	}
+
+	const ValloxSimulatorStatistics& getStatistics() const
+	{
+		return m_Statistics;
+	}
+
+	int available()
+	{
+		return (int)m_Received.size();
+	}
+
+	int read()
+	{
+		if (m_Received.empty())
+		{
+			return -1;
+		}
+		uint8_t value = m_Received.front();
+		m_Received.pop_front();
+		return value;
+	}
+
+	int peek()
+	{
+		return m_Received.empty() ? -1 : m_Received.front();
+	}
+
+	using Stream::write;
+
+	// the UART of the device sends one byte after the other, starting now
+	size_t write(uint8_t value)
+	{
+		uint64_t start = std::max(m_NowUs, m_DeviceFreeUs);
+		m_DeviceFreeUs = start + VALLOX_CHARACTER_TIME_US;
+		m_BusFreeUs = std::max(m_BusFreeUs, m_DeviceFreeUs);
+
+		// a byte overlapping with one of the master garbles both
+		for (size_t i = 0; i < m_Bus.size(); i++)
+		{
+			BusByte& other = m_Bus[i];
+			if (other.startUs + VALLOX_CHARACTER_TIME_US > start && start + VALLOX_CHARACTER_TIME_US > other.startUs)
+			{
+				other.value &= value;
+				other.fromDevice = true;
+				m_Statistics.collidedBytes++;
+				return 1;
+			}
+		}
+
+		BusByte busByte = { start, value, true };
+		m_Bus.insert(std::upper_bound(m_Bus.begin(), m_Bus.end(), busByte), busByte);
+		return 1;
+	}
+
+private:
+	struct BusByte
+	{
+		uint64_t startUs;
+		uint8_t value;
+		bool fromDevice;
+
+		bool operator<(const BusByte& other) const
+		{
+			return startUs < other.startUs;
+		}
+	};
+
+	bool chance(double probability)
+	{
+		return probability > 0 && m_Chance(m_Random) < probability;
+	}
+
+	// puts a telegram on the bus as soon as it is free, but not before the given time
+	void send(uint8_t sender, uint8_t receiver, uint8_t variable, uint8_t value, uint64_t notBeforeUs)
+	{
+		uint8_t telegram[VALLOX_LENGTH] = { VALLOX_DOMAIN, sender, receiver, variable, value, 0 };
+		telegram[5] = Vallox::calculateChecksum(telegram);
+
+		uint64_t start = std::max(notBeforeUs, m_BusFreeUs);
+		for (uint8_t i = 0; i < VALLOX_LENGTH; i++)
+		{
+			BusByte busByte = { start + (uint64_t)i * VALLOX_CHARACTER_TIME_US, telegram[i], false };
+			m_Bus.push_back(busByte);
+		}
+		m_BusFreeUs = start + (uint64_t)VALLOX_LENGTH * VALLOX_CHARACTER_TIME_US;
+		m_Statistics.sentTelegrams++;
+	}
+
+	// alternately a broadcast of a measured value and a poll of a setting by one of the panels
+	void scheduleTraffic()
+	{
+		static const uint8_t BROADCASTS[] =
+		{
+			VALLOX_VARIABLE_FAN_SPEED, VALLOX_VARIABLE_TEMP_OUTSIDE, VALLOX_VARIABLE_TEMP_EXHAUST,
+			VALLOX_VARIABLE_TEMP_INSIDE, VALLOX_VARIABLE_TEMP_INCOMMING, VALLOX_VARIABLE_HUMIDITY,
+			VALLOX_VARIABLE_HUMIDITY_SENSOR1, VALLOX_VARIABLE_CO2_HIGH, VALLOX_VARIABLE_CO2_LOW,
+			VALLOX_VARIABLE_SELECT, VALLOX_VARIABLE_IOPORT_MULTI_PURPOSE_2, VALLOX_VARIABLE_IOPORT_FANSPEED_RELAYS
+		};
+		static const uint8_t SETTINGS[] =
+		{
+			VALLOX_VARIABLE_HEATING_SET_POINT, VALLOX_VARIABLE_FAN_SPEED_MAX, VALLOX_VARIABLE_FAN_SPEED_MIN,
+			VALLOX_VARIABLE_PRE_HEATING_SET_POINT, VALLOX_VARIABLE_INPUT_FAN_STOP, VALLOX_VARIABLE_HRC_BYPASS,
+			VALLOX_VARIABLE_CELL_DEFROSTING, VALLOX_VARIABLE_PROGRAM
+		};
+
+		uint32_t index = m_TrafficIndex++;
+		uint8_t telegrams = 1;
+
+		if (m_Config.panelCount == 0 || (index & 1) == 0)
+		{
+			uint8_t variable = BROADCASTS[(index / 2) % sizeof(BROADCASTS)];
+			if (variable >= VALLOX_VARIABLE_HUMIDITY && variable <= VALLOX_VARIABLE_TEMP_INCOMMING && chance(m_Config.changeProbability))
+			{
+				m_Variables[variable] += chance(0.5) ? 1 : -1;
+			}
+
+			// all panels at once or one after the other
+			uint8_t receiver = VALLOX_ADDRESS_PANELS + (index / 2) % 10;
+			send(VALLOX_ADDRESS_MASTER, receiver, variable, m_Variables[variable], m_NowUs);
+		}
+		else
+		{
+			uint8_t panel = VALLOX_ADDRESS_PANEL1 + (index / 2) % m_Config.panelCount;
+			uint8_t variable = SETTINGS[(index / 2) % sizeof(SETTINGS)];
+			send(panel, VALLOX_ADDRESS_MASTER, VALLOX_VARIABLE_POLL, variable, m_NowUs);
+			send(VALLOX_ADDRESS_MASTER, panel, variable, m_Variables[variable], m_BusFreeUs + m_Config.replyDelayUs);
+			telegrams = 2;
+		}
+
+		// more than the bus can carry saturates it
+		if (m_Config.telegramsPerSecond == 0)
+		{
+			m_NextTrafficUs = m_BusFreeUs;
+		}
+		else
+		{
+			m_NextTrafficUs = std::max(m_NextTrafficUs + (uint64_t)telegrams * 1000000 / m_Config.telegramsPerSecond, m_BusFreeUs);
+		}
+	}
+
+	// both bursts are sent twice, the bus is quiet in between
+	void suspend()
+	{
+		send(VALLOX_ADDRESS_MASTER, VALLOX_ADDRESS_PANELS, VALLOX_VARIABLE_SUSPEND, 0, m_NowUs);
+		send(VALLOX_ADDRESS_MASTER, VALLOX_ADDRESS_PANELS, VALLOX_VARIABLE_SUSPEND, 0, m_NowUs);
+
+		m_SuspendStartUs = m_BusFreeUs;
+		m_SuspendedUntilUs = m_SuspendStartUs + (uint64_t)m_Config.suspendDurationMs * 1000;
+		send(VALLOX_ADDRESS_MASTER, VALLOX_ADDRESS_PANELS, VALLOX_VARIABLE_RESUME, 0, m_SuspendedUntilUs);
+		send(VALLOX_ADDRESS_MASTER, VALLOX_ADDRESS_PANELS, VALLOX_VARIABLE_RESUME, 0, m_SuspendedUntilUs);
+
+		m_NextSuspendUs = m_SuspendedUntilUs + (uint64_t)m_Config.suspendIntervalMs * 1000;
+		m_NextTrafficUs = std::max(m_NextTrafficUs, m_BusFreeUs);
+		m_Statistics.suspensions++;
+	}
+
+	// bytes which are completely on the wire go to the device, those of the device to the master as well
+	void deliver()
+	{
+		while (!m_Bus.empty() && m_Bus.front().startUs + VALLOX_CHARACTER_TIME_US <= m_NowUs)
+		{
+			BusByte busByte = m_Bus.front();
+			m_Bus.pop_front();
+
+			if (busByte.fromDevice)
+			{
+				receiveFromDevice(busByte.value, busByte.startUs);
+			}
+
+			if (chance(m_Config.noiseProbability))
+			{
+				m_Received.push_back((uint8_t)m_Random());
+				m_Statistics.noiseBytes++;
+				if (m_pRecording)
+				{
+					m_pRecording->push_back(m_Received.back());
+				}
+			}
+			if (chance(m_Config.dropProbability))
+			{
+				m_Statistics.droppedBytes++;
+				continue;
+			}
+			if (chance(m_Config.bitErrorProbability))
+			{
+				busByte.value ^= 1 << (m_Random() % 8);
+				m_Statistics.corruptedBytes++;
+			}
+			m_Received.push_back(busByte.value);
+			if (m_pRecording)
+			{
+				m_pRecording->push_back(busByte.value);
+			}
+		}
+	}
+
+	// the master looks for telegrams in the bytes of the device
+	void receiveFromDevice(uint8_t value, uint64_t startUs)
+	{
+		if (m_WindowLength == VALLOX_LENGTH)
+		{
+			memmove(m_Window, m_Window + 1, VALLOX_LENGTH - 1);
+			m_WindowLength--;
+		}
+		m_Window[m_WindowLength++] = value;
+
+		if (m_WindowLength < VALLOX_LENGTH || m_Window[0] != VALLOX_DOMAIN ||
+			Vallox::calculateChecksum(m_Window) != m_Window[VALLOX_LENGTH - 1])
+		{
+			return;
+		}
+		m_WindowLength = 0;
+		m_Statistics.receivedTelegrams++;
+
+		if (startUs >= m_SuspendStartUs && startUs < m_SuspendedUntilUs)
+		{
+			m_Statistics.suspendedTelegrams++;
+		}
+
+		uint8_t sender = m_Window[1];
+		uint8_t receiver = m_Window[2];
+		uint8_t variable = m_Window[3];
+		uint8_t arg = m_Window[4];
+		if (receiver != VALLOX_ADDRESS_MASTER && receiver != VALLOX_ADDRESS_MAINBOARDS)
+		{
+			return;
+		}
+
+		if (variable == VALLOX_VARIABLE_POLL)
+		{
+			if (m_Config.pollsAnswered)
+			{
+				send(VALLOX_ADDRESS_MASTER, sender, arg, m_Variables[arg], startUs + VALLOX_CHARACTER_TIME_US + m_Config.replyDelayUs);
+				m_Statistics.answeredPolls++;
+			}
+		}
+		else if (m_Config.writesTaken)
+		{
+			// the indicators of the select status are set by the master only
+			m_Variables[variable] = variable == VALLOX_VARIABLE_SELECT ? (m_Variables[variable] & 0xF0) | (arg & 0x0F) : arg;
+			m_Statistics.acceptedWrites++;
+		}
+	}
+
+	ValloxSimulatorConfig m_Config;
+	ValloxSimulatorStatistics m_Statistics;
+	std::mt19937 m_Random;
+	std::uniform_real_distribution<double> m_Chance;
+
+	uint8_t m_Variables[256];
+
+	uint64_t m_NowUs;
+	uint64_t m_BusFreeUs;			// end of the last byte on the bus
+	uint64_t m_DeviceFreeUs;		// end of the last byte sent by the device
+	uint64_t m_NextTrafficUs;
+	uint64_t m_NextSuspendUs;
+	uint64_t m_SuspendStartUs;
+	uint64_t m_SuspendedUntilUs;
+	uint32_t m_TrafficIndex;
+
+	std::deque<BusByte> m_Bus;		// bytes on the wire, ordered by their start
+	std::deque<uint8_t> m_Received;	// bytes waiting in the receive buffer of the device
+
+	uint8_t m_Window[VALLOX_LENGTH];	// receiver of the master
+	uint8_t m_WindowLength;
+
+	std::vector<uint8_t>* m_pRecording;
+};
+
+#endif // ValloxBusSimulator_h
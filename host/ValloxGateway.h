@@ -0,0 +1,289 @@
+// Gateway for several vallox buses in one process.
+//
+// Every bus is a ValloxSerial on its own serial device. run() multiplexes all
+// of them with epoll on the calling thread, or spreads them over a few worker
+// threads with an epoll instance each. A bus is only ever touched by its own
+// worker, so the library needs no locking. Property changes are reported with
+// the number of the bus and a user context, they come in through a subscription
+// of every property with the bus as its context. With more than one worker the
+// callback is called from several threads at once.
+//
+// The statistics of a bus are kept by its worker, read them after run() has
+// returned or from within the callback. A bus whose device is gone is closed
+// and dropped by its worker, the other buses carry on.
+
+#ifndef ValloxGateway_h
+#define ValloxGateway_h
+
+#include <ValloxSerial.h>
+#include <ValloxPosixSerial.h>
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <errno.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+extern "C" {
+	typedef void(*GatewayPropertyChangedFunction)(void* pContext, uint8_t bus, ValloxProperty propertyId, int8_t value);
+}
+
+struct ValloxGatewayStatistics
+{
+	uint32_t wakeups;				// the device was readable
+	uint32_t telegrams;
+	uint32_t changes;
+	double totalLatencyUs;			// from the wakeup to the property change callback, divide by changes
+	double maxLatencyUs;
+};
+
+class ValloxGateway
+{
+public:
+	ValloxGateway()
+	{
+		m_PropertyChangedCallback = NULL;
+		m_pPropertyChangedContext = NULL;
+		m_StopEvent = eventfd(0, EFD_NONBLOCK);
+		m_StopError = m_StopEvent < 0 ? errno : 0;
+	}
+
+	~ValloxGateway()
+	{
+		if (m_StopEvent >= 0)
+		{
+			close(m_StopEvent);
+		}
+	}
+
+	// opens the device and returns the number of the bus, -1 with errno set if it can not be opened
+	int addBus(const char* pDevice, bool rs485 = false)
+	{
+		std::unique_ptr<Bus> pBus(new Bus());
+		if (!pBus->port.open(pDevice, rs485))
+		{
+			return -1;
+		}
+
+		pBus->pGateway = this;
+		pBus->index = (uint8_t)m_Buses.size();
+		memset(&pBus->statistics, 0, sizeof(ValloxGatewayStatistics));
+
+		pBus->port.attach(pBus->vallox);
+		pBus->vallox.setResynchronize(true);
+		pBus->vallox.setNonBlockingTransmit(true);
+
+		ValloxPropertyMask properties;
+		for (uint8_t index = 0; index < VALLOX_PROPERTY_COUNT; index++)
+		{
+			properties.set(index);
+		}
+		pBus->vallox.subscribe(onPropertyChanged, pBus.get(), properties);
+
+		m_Buses.push_back(std::move(pBus));
+		return m_Buses.size() - 1;
+	}
+
+	uint8_t getBusCount() const
+	{
+		return (uint8_t)m_Buses.size();
+	}
+
+	// for the setup of a bus before run(), e.g. its sender id or scheduled properties
+	ValloxSerial& getBus(uint8_t bus)
+	{
+		return m_Buses[bus]->vallox;
+	}
+
+	const ValloxGatewayStatistics& getStatistics(uint8_t bus) const
+	{
+		return m_Buses[bus]->statistics;
+	}
+
+	void attachPropertyChanged(GatewayPropertyChangedFunction callbackFunction, void* pContext = NULL)
+	{
+		m_PropertyChangedCallback = callbackFunction;
+		m_pPropertyChangedContext = pContext;
+	}
+
+	// serves the buses until stop() is called, bus n is handled by worker n % workers,
+	// returns false with errno set if the stop event or an epoll instance could not be created
+	bool run(uint8_t workers = 1)
+	{
+		if (m_StopEvent < 0)
+		{
+			errno = m_StopError;
+			return false;
+		}
+
+		int error = 0;
+		if (workers <= 1)
+		{
+			serve(0, 1, &error);
+		}
+		else
+		{
+			// a worker which can not start stops the others and leaves its error
+			std::vector<int> errors(workers, 0);
+			std::vector<std::thread> threads;
+			for (uint8_t worker = 0; worker < workers; worker++)
+			{
+				threads.push_back(std::thread(&ValloxGateway::serve, this, worker, workers, &errors[worker]));
+			}
+			for (size_t i = 0; i < threads.size(); i++)
+			{
+				threads[i].join();
+				error = error ? error : errors[i];
+			}
+		}
+
+		// all workers have seen the stop, the next run starts afresh
+		uint64_t value;
+		if (read(m_StopEvent, &value, sizeof(value)) < 0)
+		{
+			// nothing to reset
+		}
+
+		errno = error;
+		return error == 0;
+	}
+
+	// may be called from any thread or a signal handler
+	void stop()
+	{
+		uint64_t value = 1;
+		if (write(m_StopEvent, &value, sizeof(value)) < 0)
+		{
+			// the counter is already set
+		}
+	}
+
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	struct Bus
+	{
+		ValloxPosixSerial port;
+		ValloxSerial vallox;
+		ValloxGateway* pGateway;
+		uint8_t index;
+		Clock::time_point wakeup;
+		ValloxGatewayStatistics statistics;
+	};
+
+	static void onPropertyChanged(void* pContext, ValloxProperty propertyId, int8_t value)
+	{
+		Bus* pBus = (Bus*)pContext;
+		ValloxGatewayStatistics& statistics = pBus->statistics;
+
+		double latency = std::chrono::duration<double, std::micro>(Clock::now() - pBus->wakeup).count();
+		statistics.changes++;
+		statistics.totalLatencyUs += latency;
+		statistics.maxLatencyUs = latency > statistics.maxLatencyUs ? latency : statistics.maxLatencyUs;
+
+		ValloxGateway* pGateway = pBus->pGateway;
+		if (pGateway->m_PropertyChangedCallback)
+		{
+			(*pGateway->m_PropertyChangedCallback)(pGateway->m_pPropertyChangedContext, pBus->index, propertyId, value);
+		}
+	}
+
+	void serve(uint8_t worker, uint8_t workers, int* pError)
+	{
+		int epoll = epoll_create1(0);
+		struct epoll_event event;
+		memset(&event, 0, sizeof(event));
+
+		// the stop event is level triggered, so it wakes every worker
+		event.events = EPOLLIN;
+		event.data.ptr = NULL;
+		if (epoll < 0 || epoll_ctl(epoll, EPOLL_CTL_ADD, m_StopEvent, &event) != 0)
+		{
+			*pError = errno;
+			if (epoll >= 0)
+			{
+				close(epoll);
+			}
+			stop();
+			return;
+		}
+
+		// buses closed by an earlier run are left out
+		std::vector<Bus*> buses;
+		for (size_t i = worker; i < m_Buses.size(); i += workers)
+		{
+			Bus* pBus = m_Buses[i].get();
+			event.data.ptr = pBus;
+			if (pBus->port.getFd() >= 0 && epoll_ctl(epoll, EPOLL_CTL_ADD, pBus->port.getFd(), &event) == 0)
+			{
+				buses.push_back(pBus);
+			}
+		}
+
+		const int MAX_EVENTS = 16;
+		struct epoll_event events[MAX_EVENTS];
+		Clock::time_point lastTick = Clock::now();
+		bool running = true;
+
+		while (running)
+		{
+			int timeout = VALLOX_POSIX_IDLE_TIMEOUT_MS;
+			for (size_t i = 0; i < buses.size(); i++)
+			{
+				int busTimeout = buses[i]->port.getTimeout();
+				timeout = busTimeout < timeout ? busTimeout : timeout;
+			}
+
+			int ready = epoll_wait(epoll, events, MAX_EVENTS, timeout);
+			Clock::time_point now = Clock::now();
+
+			for (int i = 0; i < ready; i++)
+			{
+				Bus* pBus = (Bus*)events[i].data.ptr;
+				if (pBus == NULL)
+				{
+					running = false;
+					continue;
+				}
+
+				pBus->wakeup = now;
+				pBus->statistics.wakeups++;
+
+				uint16_t telegrams = 0;
+				if (!pBus->port.onReadable(&telegrams))
+				{
+					// the device is gone, the other buses carry on without it
+					epoll_ctl(epoll, EPOLL_CTL_DEL, pBus->port.getFd(), NULL);
+					pBus->port.close();
+					buses.erase(std::find(buses.begin(), buses.end(), pBus));
+				}
+				pBus->statistics.telegrams += telegrams;
+			}
+
+			// buses without traffic still have to send and expire their polls and writes
+			if (now - lastTick >= std::chrono::milliseconds(timeout))
+			{
+				for (size_t i = 0; i < buses.size(); i++)
+				{
+					buses[i]->port.onTimeout();
+				}
+				lastTick = now;
+			}
+		}
+
+		close(epoll);
+	}
+
+	std::vector<std::unique_ptr<Bus> > m_Buses;
+	GatewayPropertyChangedFunction m_PropertyChangedCallback;
+	void* m_pPropertyChangedContext;
+	int m_StopEvent;
+	int m_StopError;				// errno of the stop event if it could not be created
+};
+
+#endif // ValloxGateway_h
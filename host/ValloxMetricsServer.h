@@ -0,0 +1,327 @@
+// Serves the OpenMetrics text of a ValloxSerial over HTTP on Linux.
+//
+// The listening socket and the connections are non blocking and kept in an
+// epoll instance of the server. The owner waits for getFd() to become readable
+// with poll() or epoll together with the serial device, at most getTimeout()
+// ms, and then calls onReadable() or onTimeout(). Neither of them ever waits
+// for a client. A request is read as far as it has arrived, once it is
+// complete it is answered with a freshly rendered text and the connection is
+// closed, so a scrape never waits for the bus. The answer has to fit into the
+// send buffer of the socket at once. GET /metrics and GET / are answered,
+// everything else with 404. Connections which are not answered within
+// VALLOX_METRICS_CLIENT_TIMEOUT_MS are closed, as are new ones while
+// VALLOX_METRICS_CLIENTS are open. Binds to localhost by default.
+
+#ifndef ValloxMetricsServer_h
+#define ValloxMetricsServer_h
+
+#include <ValloxMetrics.h>
+#include <ValloxSerial.h>
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+const int VALLOX_METRICS_CLIENT_TIMEOUT_MS = 200;
+const int VALLOX_METRICS_REQUEST_SIZE = 1024;
+const int VALLOX_METRICS_CLIENTS = 8;
+const int VALLOX_METRICS_SEND_BUFFER = 64 * 1024;
+
+class ValloxMetricsServer
+{
+public:
+	ValloxMetricsServer()
+	{
+		m_Fd = -1;
+		m_Epoll = -1;
+		m_Requests = 0;
+		for (int slot = 0; slot < VALLOX_METRICS_CLIENTS; slot++)
+		{
+			m_Clients[slot].fd = -1;
+		}
+	}
+
+	~ValloxMetricsServer()
+	{
+		close();
+	}
+
+	// returns false with errno set if the port can not be bound
+	bool open(uint16_t port, const char* pAddress = "127.0.0.1")
+	{
+		close();
+
+		m_Epoll = epoll_create1(EPOLL_CLOEXEC);
+		m_Fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+		if (m_Epoll < 0 || m_Fd < 0)
+		{
+			return fail();
+		}
+
+		int reuse = 1;
+		setsockopt(m_Fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+		struct sockaddr_in address;
+		memset(&address, 0, sizeof(address));
+		address.sin_family = AF_INET;
+		address.sin_port = htons(port);
+		if (inet_pton(AF_INET, pAddress, &address.sin_addr) != 1)
+		{
+			errno = EINVAL;
+			return fail();
+		}
+
+		if (bind(m_Fd, (struct sockaddr*)&address, sizeof(address)) != 0 || listen(m_Fd, 8) != 0)
+		{
+			return fail();
+		}
+
+		// the listening socket is the slot after the clients
+		struct epoll_event event;
+		memset(&event, 0, sizeof(event));
+		event.events = EPOLLIN;
+		event.data.u32 = VALLOX_METRICS_CLIENTS;
+		if (epoll_ctl(m_Epoll, EPOLL_CTL_ADD, m_Fd, &event) != 0)
+		{
+			return fail();
+		}
+		return true;
+	}
+
+	void close()
+	{
+		for (int slot = 0; slot < VALLOX_METRICS_CLIENTS; slot++)
+		{
+			disconnect(slot);
+		}
+		if (m_Fd >= 0)
+		{
+			::close(m_Fd);
+			m_Fd = -1;
+		}
+		if (m_Epoll >= 0)
+		{
+			::close(m_Epoll);
+			m_Epoll = -1;
+		}
+	}
+
+	// readable when a connection or a part of a request is waiting
+	int getFd() const
+	{
+		return m_Epoll;
+	}
+
+	// ms until the next connection times out, -1 without connections
+	int getTimeout() const
+	{
+		int timeout = -1;
+		unsigned long now = millis();
+		for (int slot = 0; slot < VALLOX_METRICS_CLIENTS; slot++)
+		{
+			if (m_Clients[slot].fd >= 0)
+			{
+				long left = (long)(m_Clients[slot].deadline - now);
+				int clientTimeout = left > 0 ? (int)left : 0;
+				timeout = timeout < 0 || clientTimeout < timeout ? clientTimeout : timeout;
+			}
+		}
+		return timeout;
+	}
+
+	uint32_t getRequests() const
+	{
+		return m_Requests;
+	}
+
+	// accepts waiting connections and answers the requests which are complete
+	void onReadable(ValloxMetrics& metrics, const ValloxSerial& vallox)
+	{
+		struct epoll_event events[VALLOX_METRICS_CLIENTS + 1];
+		int ready = epoll_wait(m_Epoll, events, VALLOX_METRICS_CLIENTS + 1, 0);
+		for (int i = 0; i < ready; i++)
+		{
+			int slot = events[i].data.u32;
+			if (slot == VALLOX_METRICS_CLIENTS)
+			{
+				accept();
+			}
+			else if (m_Clients[slot].fd >= 0)
+			{
+				receive(slot, metrics, vallox);
+			}
+		}
+		onTimeout();
+	}
+
+	// closes the connections which were not answered in time
+	void onTimeout()
+	{
+		unsigned long now = millis();
+		for (int slot = 0; slot < VALLOX_METRICS_CLIENTS; slot++)
+		{
+			if (m_Clients[slot].fd >= 0 && (long)(now - m_Clients[slot].deadline) >= 0)
+			{
+				disconnect(slot);
+			}
+		}
+	}
+
+private:
+	struct Client
+	{
+		int fd;
+		unsigned long deadline;
+		size_t length;
+		char request[VALLOX_METRICS_REQUEST_SIZE];
+	};
+
+	void accept()
+	{
+		int client;
+		while ((client = accept4(m_Fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0)
+		{
+			int slot = 0;
+			while (slot < VALLOX_METRICS_CLIENTS && m_Clients[slot].fd >= 0)
+			{
+				slot++;
+			}
+
+			struct epoll_event event;
+			memset(&event, 0, sizeof(event));
+			event.events = EPOLLIN;
+			event.data.u32 = slot;
+			if (slot == VALLOX_METRICS_CLIENTS || epoll_ctl(m_Epoll, EPOLL_CTL_ADD, client, &event) != 0)
+			{
+				// too many connections
+				::close(client);
+				continue;
+			}
+
+			int sendBuffer = VALLOX_METRICS_SEND_BUFFER;
+			setsockopt(client, SOL_SOCKET, SO_SNDBUF, &sendBuffer, sizeof(sendBuffer));
+
+			m_Clients[slot].fd = client;
+			m_Clients[slot].deadline = millis() + VALLOX_METRICS_CLIENT_TIMEOUT_MS;
+			m_Clients[slot].length = 0;
+		}
+	}
+
+	void receive(int slot, ValloxMetrics& metrics, const ValloxSerial& vallox)
+	{
+		// the request line is all we need, the rest of the header is read and ignored
+		Client& client = m_Clients[slot];
+		while (client.length < sizeof(client.request) - 1)
+		{
+			ssize_t count = recv(client.fd, client.request + client.length, sizeof(client.request) - 1 - client.length, 0);
+			if (count < 0 && (errno == EAGAIN || errno == EINTR))
+			{
+				// the rest comes later or the connection times out
+				return;
+			}
+			if (count <= 0)
+			{
+				disconnect(slot);
+				return;
+			}
+			client.length += count;
+			client.request[client.length] = '\0';
+			if (strstr(client.request, "\r\n\r\n") || strstr(client.request, "\n\n"))
+			{
+				break;
+			}
+		}
+
+		serve(client.fd, client.request, metrics, vallox);
+		disconnect(slot);
+	}
+
+	void serve(int client, const char* pRequest, ValloxMetrics& metrics, const ValloxSerial& vallox)
+	{
+		m_Requests++;
+
+		if (strncmp(pRequest, "GET /metrics ", 13) != 0 && strncmp(pRequest, "GET / ", 6) != 0)
+		{
+			static const char NOT_FOUND[] = "HTTP/1.0 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+			sendAll(client, NOT_FOUND, sizeof(NOT_FOUND) - 1);
+			return;
+		}
+
+		ValloxPropertyStore properties;
+		vallox.snapshot(properties);
+		uint16_t bodyLength = metrics.render(properties, vallox.getStatistics());
+		if (bodyLength == 0)
+		{
+			static const char TOO_LARGE[] = "HTTP/1.0 500 Internal Server Error\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+			sendAll(client, TOO_LARGE, sizeof(TOO_LARGE) - 1);
+			return;
+		}
+
+		char header[160];
+		int headerLength = snprintf(header, sizeof(header),
+			"HTTP/1.0 200 OK\r\nContent-Type: application/openmetrics-text; version=1.0.0; charset=utf-8\r\n"
+			"Content-Length: %u\r\nConnection: close\r\n\r\n", bodyLength);
+		if (sendAll(client, header, headerLength))
+		{
+			sendAll(client, metrics.getText(), bodyLength);
+		}
+	}
+
+	// gives up instead of waiting when the send buffer is full
+	static bool sendAll(int client, const char* pData, size_t length)
+	{
+		while (length > 0)
+		{
+			ssize_t count = send(client, pData, length, MSG_NOSIGNAL);
+			if (count < 0 && errno == EINTR)
+			{
+				continue;
+			}
+			if (count <= 0)
+			{
+				return false;
+			}
+			pData += count;
+			length -= count;
+		}
+		return true;
+	}
+
+	void disconnect(int slot)
+	{
+		if (m_Clients[slot].fd >= 0)
+		{
+			// closing removes it from the epoll instance as well
+			::close(m_Clients[slot].fd);
+			m_Clients[slot].fd = -1;
+		}
+	}
+
+	static unsigned long millis()
+	{
+		struct timespec now;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		return (unsigned long)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+	}
+
+	bool fail()
+	{
+		int error = errno;
+		close();
+		errno = error;
+		return false;
+	}
+
+	int m_Fd;
+	int m_Epoll;
+	uint32_t m_Requests;
+	Client m_Clients[VALLOX_METRICS_CLIENTS];
+};
+
+#endif // ValloxMetricsServer_h
@@ -0,0 +1,250 @@
+// Stream on a serial device or pseudo terminal for Linux gateways.
+//
+// The device is opened non blocking in raw mode at VALLOX_BAUDRATE. Instead of
+// spinning on available() the owner waits for getFd() to become readable with
+// poll() or epoll and calls onReadable(), which fetches all waiting bytes with
+// a single read() and decodes them with receiveAll() of the attached
+// ValloxSerial. onTimeout() keeps polls, writes and the scheduler going while
+// the bus is quiet, getTimeout() tells how long the owner may sleep.
+//
+// With RS485 the kernel switches the driver direction via RTS (TIOCSRS485),
+// so no StartSendingFunction and StopSendingFunction GPIO callbacks are needed.
+
+#ifndef ValloxPosixSerial_h
+#define ValloxPosixSerial_h
+
+#include <ValloxSerial.h>
+#include <Stream.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/serial.h>
+
+// bytes buffered between two reads, a multiple of the telegram length
+#ifndef VALLOX_POSIX_BUFFER_SIZE
+#define VALLOX_POSIX_BUFFER_SIZE 252
+#endif
+
+// longest sleep while nothing is queued, shorter while telegrams wait to be sent
+const int VALLOX_POSIX_IDLE_TIMEOUT_MS = 100;
+const int VALLOX_POSIX_BUSY_TIMEOUT_MS = 2;
+
+class ValloxPosixSerial : public Stream
+{
+public:
+	ValloxPosixSerial()
+	{
+		m_Fd = -1;
+		m_Start = 0;
+		m_End = 0;
+		m_pVallox = NULL;
+	}
+
+	~ValloxPosixSerial()
+	{
+		close();
+	}
+
+	// returns false with errno set if the device can not be opened or configured
+	bool open(const char* pPath, bool rs485 = false)
+	{
+		close();
+
+		m_Fd = ::open(pPath, O_RDWR | O_NOCTTY | O_NONBLOCK);
+		if (m_Fd < 0)
+		{
+			return false;
+		}
+
+		struct termios settings;
+		if (tcgetattr(m_Fd, &settings) != 0)
+		{
+			return fail();
+		}
+		cfmakeraw(&settings);
+		settings.c_cflag |= CLOCAL | CREAD;
+		settings.c_cflag &= ~(CSTOPB | CRTSCTS);
+		settings.c_cc[VMIN] = 0;
+		settings.c_cc[VTIME] = 0;
+		cfsetispeed(&settings, B9600);
+		cfsetospeed(&settings, B9600);
+		static_assert(VALLOX_BAUDRATE == 9600, "the termios speed has to match VALLOX_BAUDRATE");
+
+		if (tcsetattr(m_Fd, TCSANOW, &settings) != 0)
+		{
+			return fail();
+		}
+
+		if (rs485)
+		{
+			struct serial_rs485 configuration;
+			memset(&configuration, 0, sizeof(configuration));
+			configuration.flags = SER_RS485_ENABLED | SER_RS485_RTS_ON_SEND;
+			if (ioctl(m_Fd, TIOCSRS485, &configuration) != 0)
+			{
+				return fail();
+			}
+		}
+
+		tcflush(m_Fd, TCIOFLUSH);
+		m_Start = 0;
+		m_End = 0;
+		return true;
+	}
+
+	void close()
+	{
+		if (m_Fd >= 0)
+		{
+			::close(m_Fd);
+			m_Fd = -1;
+		}
+	}
+
+	int getFd() const
+	{
+		return m_Fd;
+	}
+
+	// uses this stream for receiving and sending, the clock is set to the monotonic clock
+	void attach(ValloxSerial& vallox)
+	{
+		m_pVallox = &vallox;
+		vallox.setRxSerial(*this);
+		vallox.setTxSerial(*this);
+		vallox.attachClock(millis);
+	}
+
+	// reads what is waiting and decodes it, returns false when the device is gone
+	bool onReadable(uint16_t* pTelegrams = NULL)
+	{
+		if (m_Start == m_End)
+		{
+			m_Start = 0;
+			m_End = 0;
+		}
+		else if (m_End == VALLOX_POSIX_BUFFER_SIZE)
+		{
+			// a partial telegram is left over, move it to the front
+			memmove(m_Buffer, m_Buffer + m_Start, m_End - m_Start);
+			m_End -= m_Start;
+			m_Start = 0;
+		}
+
+		if (m_End < VALLOX_POSIX_BUFFER_SIZE)
+		{
+			ssize_t length = ::read(m_Fd, m_Buffer + m_End, VALLOX_POSIX_BUFFER_SIZE - m_End);
+			if (length == 0 || (length < 0 && errno != EAGAIN && errno != EINTR))
+			{
+				return false;
+			}
+			if (length > 0)
+			{
+				m_End += length;
+			}
+		}
+
+		uint16_t telegrams = m_pVallox ? m_pVallox->receiveAll() : 0;
+		if (pTelegrams)
+		{
+			*pTelegrams = telegrams;
+		}
+		return true;
+	}
+
+	// sends queued telegrams and expires polls and writes
+	void onTimeout()
+	{
+		if (m_pVallox)
+		{
+			m_pVallox->tick();
+		}
+	}
+
+	// ms to wait for the device to become readable before onTimeout() is due
+	int getTimeout() const
+	{
+		if (m_pVallox && (m_pVallox->getQueuedTelegrams() > 0 || m_pVallox->isTransmitting()))
+		{
+			return VALLOX_POSIX_BUSY_TIMEOUT_MS;
+		}
+		return VALLOX_POSIX_IDLE_TIMEOUT_MS;
+	}
+
+	static unsigned long millis()
+	{
+		struct timespec now;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		return (unsigned long)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+	}
+
+	int available()
+	{
+		return (int)(m_End - m_Start);
+	}
+
+	int read()
+	{
+		return m_Start < m_End ? m_Buffer[m_Start++] : -1;
+	}
+
+	int peek()
+	{
+		return m_Start < m_End ? m_Buffer[m_Start] : -1;
+	}
+
+	size_t write(uint8_t value)
+	{
+		return write(&value, 1);
+	}
+
+	// usually written at once, otherwise waits a little for room in the transmit buffer of the driver
+	size_t write(const uint8_t* pBuffer, size_t size)
+	{
+		size_t written = 0;
+		while (written < size)
+		{
+			ssize_t length = ::write(m_Fd, pBuffer + written, size - written);
+			if (length < 0)
+			{
+				struct pollfd writable = { m_Fd, POLLOUT, 0 };
+				if (errno == EINTR || (errno == EAGAIN && ::poll(&writable, 1, VALLOX_TELEGRAM_DURATION_MS) > 0))
+				{
+					continue;
+				}
+				break;
+			}
+			written += length;
+		}
+		return written;
+	}
+
+	void flush()
+	{
+		tcdrain(m_Fd);
+	}
+
+private:
+	bool fail()
+	{
+		int error = errno;
+		close();
+		errno = error;
+		return false;
+	}
+
+	int m_Fd;
+	ValloxSerial* m_pVallox;
+
+	uint8_t m_Buffer[VALLOX_POSIX_BUFFER_SIZE];
+	uint16_t m_Start;
+	uint16_t m_End;
+};
+
+#endif // ValloxPosixSerial_h
@@ -0,0 +1,194 @@
+// Verifies the codec against the former linear search conversions and
+// compares their speed.
+//
+// Every possible input of every conversion is checked first, the benchmark
+// only runs if all of them match. Returns 1 on the first mismatch. With 0
+// iterations only the conversions are checked, that is how ctest runs it.
+//
+// usage: ValloxCodecBenchmark [iterations]
+
+#include <ValloxProtocol.h>
+
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// the conversions as they were implemented before the codec, with their own
+// copy of the table so that a change of the codec table shows up as a mismatch
+static const int8_t LEGACY_TEMPERATURE_MAPPING[256] =
+{
+	-74, -70, -66, -62, -59, -56, -54, -52,
+	-50, -48, -47, -46, -44, -43, -42, -41,
+	-40, -39, -38, -37, -36, -35, -34, -33,
+	-33, -32, -31, -30, -30, -29, -28, -28,
+	-27, -27, -26, -25, -25, -24, -24, -23,
+	-23, -22, -22, -21, -21, -20, -20, -19,
+	-19, -19, -18, -18, -17, -17, -16, -16,
+	-16, -15, -15, -14, -14, -14, -13, -13,
+	-12, -12, -12, -11, -11, -11, -10, -10,
+	-9,  -9,  -9,  -8,  -8,  -8,  -7,  -7,
+	-7,  -6,  -6,  -6,  -5,  -5,  -5,  -4,
+	-4,  -4,  -3,  -3,  -3,  -2,  -2,  -2,
+	-1,  -1,  -1,  -1,  0,   0,   0,   1,
+	1,   1,   2,   2,   2,   3,   3,   3,
+	4,   4,   4,   5,   5,   5,   5,   6,
+	6,   6,   7,   7,   7,   8,   8,   8,
+	9,   9,   9,   10,  10,  10,  11,  11,
+	11,  12,  12,  12,  13,  13,  13,  14,
+	14,  14,  15,  15,  15,  16,  16,  16,
+	17,  17,  18,  18,  18,  19,  19,  19,
+	20,  20,  21,  21,  21,  22,  22,  22,
+	23,  23,  24,  24,  24,  25,  25,  26,
+	26,  27,  27,  27,  28,  28,  29,  29,
+	30,  30,  31,  31,  32,  32,  33,  33,
+	34,  34,  35,  35,  36,  36,  37,  37,
+	38,  38,  39,  40,  40,  41,  41,  42,
+	43,  43,  44,  45,  45,  46,  47,  48,
+	49,  49,  50,  51,  52,  53,  53,  54,
+	55,  56,  57,  59,  60,  61,  62,  63,
+	65,  66,  68,  69,  71,  73,  75,  77,
+	79,  81,  82,  86,  90,  93,  97,  100,
+	100, 100, 100, 100, 100, 100, 100, 100
+};
+static uint8_t LEGACY_FAN_SPEED_MAPPING[] = { 0x01, 0x03, 0x07, 0x0F, 0x1F, 0x3F, 0x7F, 0xFF };
+
+static uint8_t legacyConvertBackTemperature(int8_t temperature)
+{
+	uint8_t value = 100;
+
+	for (uint8_t i = 0; i < 255; i++)
+	{
+		int8_t valueFromTable = LEGACY_TEMPERATURE_MAPPING[i];
+		if (valueFromTable >= temperature)
+		{
+			value = i;
+			break;
+		}
+	}
+
+	return value;
+}
+
+static uint8_t legacyConvertFanSpeed(uint8_t value)
+{
+	uint8_t fanSpeed = 0;
+
+	for (uint8_t i = 0; i < 8; i++)
+	{
+		if (LEGACY_FAN_SPEED_MAPPING[i] == value)
+		{
+			fanSpeed = i + 1;
+			break;
+		}
+	}
+
+	return fanSpeed;
+}
+
+static int failures = 0;
+
+static void check(bool condition, const char* conversion, int input, int expected, int actual)
+{
+	if (!condition && failures++ < 10)
+	{
+		printf("%s(%d): expected %d, got %d\n", conversion, input, expected, actual);
+	}
+}
+
+static void verify()
+{
+	for (int code = 0; code < 256; code++)
+	{
+		check(Vallox::convertTemperature(code) == LEGACY_TEMPERATURE_MAPPING[code],
+			"convertTemperature", code, LEGACY_TEMPERATURE_MAPPING[code], Vallox::convertTemperature(code));
+	}
+
+	for (int temperature = -128; temperature < 128; temperature++)
+	{
+		uint8_t expected = legacyConvertBackTemperature(temperature);
+		uint8_t actual = Vallox::convertBackTemperature(temperature);
+		check(actual == expected, "convertBackTemperature", temperature, expected, actual);
+
+		// every temperature the sensor can report survives the round trip
+		if (temperature >= LEGACY_TEMPERATURE_MAPPING[0] && temperature <= LEGACY_TEMPERATURE_MAPPING[255])
+		{
+			int8_t decoded = Vallox::convertTemperature(actual);
+			bool reported = false;
+			for (int code = 0; code < 256; code++)
+			{
+				reported |= LEGACY_TEMPERATURE_MAPPING[code] == temperature;
+			}
+			check(reported ? decoded == temperature : decoded > temperature,
+				"round trip temperature", temperature, temperature, decoded);
+		}
+	}
+
+	for (int value = 0; value < 256; value++)
+	{
+		check(Vallox::convertFanSpeed(value) == legacyConvertFanSpeed(value),
+			"convertFanSpeed", value, legacyConvertFanSpeed(value), Vallox::convertFanSpeed(value));
+
+		int expected = (int)floor((value > 51 ? value - 51 : 0) / 2.04 + 0.5);
+		check(Vallox::convertHumidity(value) == expected,
+			"convertHumidity", value, expected, Vallox::convertHumidity(value));
+	}
+
+	for (int index = 0; index < 8; index++)
+	{
+		check(Vallox::convertBackFanSpeed(index) == LEGACY_FAN_SPEED_MAPPING[index],
+			"convertBackFanSpeed", index, LEGACY_FAN_SPEED_MAPPING[index], Vallox::convertBackFanSpeed(index));
+		check(Vallox::convertFanSpeed(Vallox::convertBackFanSpeed(index)) == index + 1,
+			"round trip fan speed", index + 1, index + 1, Vallox::convertFanSpeed(Vallox::convertBackFanSpeed(index)));
+	}
+}
+
+static volatile uint32_t sink = 0;
+
+template<typename Conversion>
+static double measure(size_t iterations, Conversion conversion)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	uint32_t sum = 0;
+	for (size_t i = 0; i < iterations; i++)
+	{
+		// the volatile read keeps the compiler from hoisting the conversion out of the loop
+		sum += conversion((uint8_t)(i + sink));
+	}
+	sink = sum;
+	std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+	return std::chrono::duration<double>(end - start).count() * 1e9 / iterations;
+}
+
+int main(int argc, char** argv)
+{
+	size_t iterations = argc > 1 ? strtoul(argv[1], NULL, 10) : 50000000;
+
+	verify();
+	if (failures > 0)
+	{
+		printf("%d mismatches\n", failures);
+		return 1;
+	}
+	printf("all conversions verified\n");
+	if (iterations == 0)
+	{
+		return 0;
+	}
+
+	printf("%zu conversions with uniformly distributed inputs\n", iterations);
+
+	double legacy = measure(iterations, [](uint8_t v) { return legacyConvertBackTemperature((int8_t)v); });
+	double codec = measure(iterations, [](uint8_t v) { return Vallox::convertBackTemperature((int8_t)v); });
+	printf("%-24s %8.2f ns linear search %8.2f ns codec\n", "convertBackTemperature", legacy, codec);
+
+	legacy = measure(iterations, [](uint8_t v) { return legacyConvertFanSpeed(v); });
+	codec = measure(iterations, [](uint8_t v) { return Vallox::convertFanSpeed(v); });
+	printf("%-24s %8.2f ns linear search %8.2f ns codec\n", "convertFanSpeed", legacy, codec);
+
+	legacy = measure(iterations, [](uint8_t v) { return (uint8_t)legacyConvertFanSpeed(LEGACY_FAN_SPEED_MAPPING[v & 0x07]); });
+	codec = measure(iterations, [](uint8_t v) { return Vallox::convertFanSpeed(Vallox::convertBackFanSpeed(v & 0x07)); });
+	printf("%-24s %8.2f ns linear search %8.2f ns codec\n", "fan speed round trip", legacy, codec);
+
+	return 0;
+}
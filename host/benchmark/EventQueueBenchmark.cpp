@@ -0,0 +1,172 @@
+// Stress test and benchmark of the event queue.
+//
+// One thread decodes a capture in a loop, as fast as it can or at the given
+// rate of telegrams per second. Every other telegram changes the select
+// status and with it several bits. A consumer thread pops the events meanwhile,
+// pausing after every event if asked to so that the queue overflows. Every
+// popped event must continue the values popped before for its property, a gap
+// is only allowed where an event was dropped.
+// Reports the events per second and the overflows, exits with 1 if an event
+// got lost without being counted, came out of order or was corrupted.
+//
+// usage: ValloxEventQueueBenchmark [seconds] [telegrams/s, 0 saturates] [consumer pause us]
+
+#include <ValloxSerial.h>
+#include <MemoryStream.h>
+#include "TelegramCapture.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef std::chrono::steady_clock Clock;
+
+struct ConsumerResult
+{
+	uint64_t events;
+	uint64_t gaps;			// previous value differs from the last popped value of the property
+	uint64_t disorders;		// time went backwards
+};
+
+static std::atomic<bool> running(true);
+static std::atomic<bool> consuming(true);
+static uint64_t changes = 0;		// decoding thread only
+static unsigned long ticks = 0;		// decoding thread only
+
+// strictly increasing, so that the consumer can check the order
+static unsigned long tick()
+{
+	return ++ticks;
+}
+
+static void countChange(ValloxProperty propertyId, int8_t value)
+{
+	changes++;
+}
+
+// as fast as possible or paced to the given rate, one telegram at a time
+static void decode(const std::vector<uint8_t>& capture, int rate, uint64_t* pTelegrams, ValloxSerial* pVallox)
+{
+	MemoryStream stream;
+	stream.setInput(capture.data(), capture.size());
+	pVallox->setRxSerial(stream);
+	pVallox->setTxSerial(stream);
+
+	uint64_t telegrams = 0;
+	Clock::time_point next = Clock::now();
+	while (running.load(std::memory_order_relaxed))
+	{
+		if (rate == 0)
+		{
+			stream.rewind();
+			telegrams += pVallox->receiveAll();
+			continue;
+		}
+
+		stream.setInput(&capture[(telegrams % (capture.size() / VALLOX_LENGTH)) * VALLOX_LENGTH], VALLOX_LENGTH);
+		telegrams += pVallox->receiveAll();
+		next += std::chrono::microseconds(1000000 / rate);
+		std::this_thread::sleep_until(next);
+	}
+	*pTelegrams = telegrams;
+}
+
+static void consume(ValloxEventQueue* pQueue, int pauseUs, ConsumerResult* pResult)
+{
+	// the values the decoder starts with
+	ValloxPropertyStore initial;
+	int8_t lastValues[VALLOX_PROPERTY_COUNT];
+	for (uint8_t i = 0; i < VALLOX_PROPERTY_COUNT; i++)
+	{
+		lastValues[i] = initial.get(i);
+	}
+	uint32_t lastTime = 0;
+	ConsumerResult result = { 0, 0, 0 };
+
+	ValloxEvent event;
+	while (consuming.load(std::memory_order_relaxed))
+	{
+		if (!pQueue->pop(&event))
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		result.events++;
+		uint8_t index = ValloxPropertyStore::indexOf((ValloxProperty)event.property);
+		if (event.previousValue != lastValues[index])
+		{
+			result.gaps++;
+		}
+		if (event.time <= lastTime)
+		{
+			result.disorders++;
+		}
+		lastValues[index] = event.value;
+		lastTime = event.time;
+
+		if (pauseUs > 0)
+		{
+			std::this_thread::sleep_for(std::chrono::microseconds(pauseUs));
+		}
+	}
+	*pResult = result;
+}
+
+int main(int argc, char** argv)
+{
+	int seconds = argc > 1 ? atoi(argv[1]) : 3;
+	int rate = argc > 2 ? atoi(argv[2]) : 0;
+	int pauseUs = argc > 3 ? atoi(argv[3]) : 0;
+
+	// every select value once, between the telegrams of the recorded session
+	std::vector<uint8_t> capture;
+	for (int i = 0; i < 256; i++)
+	{
+		CapturedTelegram select = { VALLOX_ADDRESS_MASTER, VALLOX_ADDRESS_PANELS, VALLOX_VARIABLE_SELECT, (uint8_t)(i * 37 + 1) };
+		appendTelegram(capture, select);
+		appendTelegram(capture, CAPTURED_SESSION[i % CAPTURED_SESSION_LENGTH]);
+	}
+
+	ValloxSerial vallox;
+	ValloxEventQueue queue;
+	vallox.attachClock(tick);
+	vallox.attachPropertyChanged(countChange);
+	vallox.attachEventQueue(&queue);
+
+	uint64_t telegrams = 0;
+	ConsumerResult result;
+
+	Clock::time_point start = Clock::now();
+	std::thread consumer(consume, &queue, pauseUs, &result);
+	std::thread producer(decode, std::cref(capture), rate, &telegrams, &vallox);
+
+	std::this_thread::sleep_for(std::chrono::seconds(seconds));
+	running = false;
+	producer.join();
+	double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+	// the rest of the queue
+	while (queue.size() > 0)
+	{
+		std::this_thread::yield();
+	}
+	consuming = false;
+	consumer.join();
+
+	uint32_t overflows = queue.getOverflows();
+	printf("decoded %.0f telegrams/s, %.0f changes/s\n", telegrams / elapsed, changes / elapsed);
+	printf("popped %.0f events/s, %u overflows (%.1f%%), %llu gaps, %llu out of order\n", result.events / elapsed, overflows,
+		changes ? 100.0 * overflows / changes : 0.0, (unsigned long long)result.gaps, (unsigned long long)result.disorders);
+
+	// every dropped event breaks the chain of its property once at most
+	bool lost = result.events + overflows != changes || result.gaps > overflows;
+	if (lost)
+	{
+		printf("events lost: %llu changes, %llu popped\n", (unsigned long long)changes, (unsigned long long)result.events);
+	}
+	return lost || result.disorders > 0 ? 1 : 0;
+}
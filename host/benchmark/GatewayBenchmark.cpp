@@ -0,0 +1,180 @@
+// Measures how many buses one gateway can serve.
+//
+// Every bus is a simulated mainboard behind its own pseudo terminal, all of
+// them are fed in real time by one feeder thread. The gateway serves them with
+// the given number of workers, with one worker pinned to the first CPU. The
+// telegrams received are compared with those sent, the CPU time of the gateway
+// is the CPU time of the process without the feeder.
+//
+// usage: ValloxGatewayBenchmark [buses] [seconds] [workers] [telegrams/s per bus]
+
+#include <ValloxGateway.h>
+#include <ValloxBusSimulator.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
+
+typedef std::chrono::steady_clock Clock;
+
+struct SimulatedBus
+{
+	std::unique_ptr<ValloxBusSimulator> pSimulator;
+	int pty;
+};
+
+static double threadCpuSeconds()
+{
+	struct timespec time;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+	return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+static double processCpuSeconds()
+{
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+static void pin(std::thread::native_handle_type thread, int cpu)
+{
+	cpu_set_t cpus;
+	CPU_ZERO(&cpus);
+	CPU_SET(cpu % std::thread::hardware_concurrency(), &cpus);
+	pthread_setaffinity_np(thread, sizeof(cpus), &cpus);
+}
+
+// moves the bytes between the simulators and their pseudo terminals every ms
+static void feed(std::vector<SimulatedBus>& buses, int seconds, ValloxGateway& gateway, double* pCpuSeconds)
+{
+	Clock::time_point start = Clock::now();
+	uint64_t elapsedUs = 0;
+
+	while (elapsedUs < seconds * 1000000ULL)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		uint64_t nowUs = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count();
+
+		for (size_t i = 0; i < buses.size(); i++)
+		{
+			ValloxBusSimulator& simulator = *buses[i].pSimulator;
+			simulator.advance((uint32_t)(nowUs - elapsedUs));
+
+			uint8_t buffer[64];
+			ssize_t length;
+			while ((length = read(buses[i].pty, buffer, sizeof(buffer))) > 0)
+			{
+				simulator.write(buffer, length);
+			}
+
+			size_t count = 0;
+			while (simulator.available() && count < sizeof(buffer))
+			{
+				buffer[count++] = (uint8_t)simulator.read();
+			}
+			if (count > 0 && write(buses[i].pty, buffer, count) < 0)
+			{
+				perror("pseudo terminal");
+			}
+		}
+		elapsedUs = nowUs;
+	}
+
+	*pCpuSeconds = threadCpuSeconds();
+	gateway.stop();
+}
+
+int main(int argc, char** argv)
+{
+	int busCount = argc > 1 ? atoi(argv[1]) : 32;
+	int seconds = argc > 2 ? atoi(argv[2]) : 10;
+	int workers = argc > 3 ? atoi(argv[3]) : 1;
+
+	ValloxSimulatorConfig config;
+	config.telegramsPerSecond = argc > 4 ? atoi(argv[4]) : 100;
+	config.suspendIntervalMs = 0;
+
+	std::vector<SimulatedBus> buses(busCount);
+	ValloxGateway gateway;
+
+	for (int i = 0; i < busCount; i++)
+	{
+		config.seed = 4711 + i;
+		buses[i].pSimulator.reset(new ValloxBusSimulator(config));
+		buses[i].pty = posix_openpt(O_RDWR | O_NOCTTY);
+		if (buses[i].pty < 0 || grantpt(buses[i].pty) != 0 || unlockpt(buses[i].pty) != 0)
+		{
+			perror("pseudo terminal");
+			return 2;
+		}
+		fcntl(buses[i].pty, F_SETFL, fcntl(buses[i].pty, F_GETFL) | O_NONBLOCK);
+
+		if (gateway.addBus(ptsname(buses[i].pty)) < 0)
+		{
+			perror(ptsname(buses[i].pty));
+			return 2;
+		}
+		gateway.getBus(i).schedule(HeatingSetPointProperty);
+	}
+
+	pin(pthread_self(), 0);
+
+	double feederCpu = 0;
+	double startCpu = processCpuSeconds();
+	std::thread feeder(feed, std::ref(buses), seconds, std::ref(gateway), &feederCpu);
+	pin(feeder.native_handle(), 1);
+
+	bool served = gateway.run(workers);
+	int error = errno;
+	feeder.join();
+	if (!served)
+	{
+		errno = error;
+		perror("gateway");
+		return 2;
+	}
+	double gatewayCpu = processCpuSeconds() - startCpu - feederCpu;
+
+	uint64_t sent = 0;
+	uint64_t received = 0;
+	uint64_t wakeups = 0;
+	uint64_t changes = 0;
+	double totalLatencyUs = 0;
+	double maxLatencyUs = 0;
+
+	printf("bus  sent  received  wakeups  changes  latency avg/max us\n");
+	for (int i = 0; i < busCount; i++)
+	{
+		const ValloxGatewayStatistics& statistics = gateway.getStatistics(i);
+		const ValloxSimulatorStatistics& busStatistics = buses[i].pSimulator->getStatistics();
+
+		printf("%3d %5u %9u %8u %8u  %.1f/%.1f\n", i, busStatistics.sentTelegrams, statistics.telegrams, statistics.wakeups, statistics.changes,
+			statistics.changes ? statistics.totalLatencyUs / statistics.changes : 0.0, statistics.maxLatencyUs);
+
+		sent += busStatistics.sentTelegrams;
+		received += statistics.telegrams;
+		wakeups += statistics.wakeups;
+		changes += statistics.changes;
+		totalLatencyUs += statistics.totalLatencyUs;
+		maxLatencyUs = statistics.maxLatencyUs > maxLatencyUs ? statistics.maxLatencyUs : maxLatencyUs;
+		close(buses[i].pty);
+	}
+
+	// received telegrams include the echoes of our own polls
+	printf("%d buses, %d workers, %d s: %llu sent %llu received %llu wakeups %llu changes, latency avg %.1f us max %.1f us\n",
+		busCount, workers, seconds, (unsigned long long)sent, (unsigned long long)received, (unsigned long long)wakeups,
+		(unsigned long long)changes, changes ? totalLatencyUs / changes : 0.0, maxLatencyUs);
+	printf("gateway cpu %.3f s (%.1f%% of one core)\n", gatewayCpu, 100.0 * gatewayCpu / seconds);
+	return 0;
+}
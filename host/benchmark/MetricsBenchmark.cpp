@@ -0,0 +1,170 @@
+// Measures the cost of a scrape and checks the patched text.
+//
+// A capture is decoded in slices of the given number of telegrams, after every
+// slice the metrics are rendered like a scrape would. The text patched in
+// place has to be identical to one written from scratch, every sample line
+// has to end in a number, exactly the received properties have a sample and
+// the text has to end in "# EOF". Reports the time of a patching and of a
+// complete render and exits with 1 on a difference.
+//
+// usage: ValloxMetricsBenchmark [scrapes] [telegrams per scrape]
+
+#include <ValloxSerial.h>
+#include <ValloxMetrics.h>
+#include <MemoryStream.h>
+#include "TelegramCapture.h"
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef std::chrono::steady_clock Clock;
+
+static unsigned long busTimeMs = 0;
+
+static unsigned long busClock()
+{
+	return busTimeMs;
+}
+
+// every sample is "name[{labels}] value" with a plain number
+static bool isWellFormed(const char* pText, uint16_t length)
+{
+	std::string text(pText, length);
+	if (text.size() < 6 || text.compare(text.size() - 6, 6, "# EOF\n") != 0)
+	{
+		return false;
+	}
+
+	size_t start = 0;
+	while (start < text.size())
+	{
+		size_t end = text.find('\n', start);
+		std::string line = text.substr(start, end - start);
+		start = end + 1;
+		if (line[0] == '#')
+		{
+			continue;
+		}
+
+		size_t space = line.rfind(' ');
+		if (space == std::string::npos || line.compare(0, 7, "vallox_") != 0)
+		{
+			return false;
+		}
+		char* pEnd = NULL;
+		strtol(line.c_str() + space + 1, &pEnd, 10);
+		if (*pEnd != '\0' || space + 1 == line.size())
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+// properties which were not received yet have no sample
+static bool listsKnownProperties(const char* pText, uint16_t length, const ValloxPropertyStore& properties)
+{
+	std::string text(pText, length);
+	for (uint8_t index = 0; index < VALLOX_PROPERTY_COUNT; index++)
+	{
+		char name[48];
+		ValloxMetrics::getPropertyName(ValloxPropertyStore::propertyAt(index), name, sizeof(name));
+		std::string label = std::string("{property=\"") + name + "\"}";
+		if ((text.find(label) != std::string::npos) != properties.isKnown(index))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	int scrapes = argc > 1 ? atoi(argv[1]) : 10000;
+	int telegramsPerScrape = argc > 2 ? atoi(argv[2]) : 20;
+
+	// the recorded session with drifting values and a few other panels
+	std::vector<uint8_t> capture;
+	for (int i = 0; i < 64; i++)
+	{
+		for (size_t j = 0; j < CAPTURED_SESSION_LENGTH; j++)
+		{
+			CapturedTelegram telegram = CAPTURED_SESSION[j];
+			telegram.arg += (uint8_t)(i % 5);
+			appendTelegram(capture, telegram);
+		}
+		CapturedTelegram panel = { (uint8_t)(VALLOX_ADDRESS_PANEL2 + i % 4), VALLOX_ADDRESS_MASTER, VALLOX_VARIABLE_POLL, VALLOX_VARIABLE_FAN_SPEED };
+		appendTelegram(capture, panel);
+	}
+	size_t telegramCount = capture.size() / VALLOX_LENGTH;
+
+	MemoryStream stream;
+	ValloxSerial vallox;
+	vallox.setRxSerial(stream);
+	vallox.setTxSerial(stream);
+	vallox.attachClock(busClock);
+
+	static char patchedText[8192];
+	static char freshText[8192];
+	ValloxMetrics patched(patchedText, sizeof(patchedText));
+	ValloxMetrics fresh(freshText, sizeof(freshText));
+
+	ValloxPropertyStore properties;
+	double patchSeconds = 0;
+	double renderSeconds = 0;
+	uint64_t patchedFields = 0;
+	int rebuilds = 0;
+	int mismatches = 0;
+	size_t next = 0;
+
+	for (int scrape = 0; scrape < scrapes; scrape++)
+	{
+		for (int i = 0; i < telegramsPerScrape; i++)
+		{
+			stream.setInput(&capture[next * VALLOX_LENGTH], VALLOX_LENGTH);
+			busTimeMs += 20 + (next % 7) * 13;
+			vallox.receiveAll();
+			next = (next + 1) % telegramCount;
+		}
+		vallox.calculateResults();
+		if (scrape % 1000 == 999)
+		{
+			vallox.resetStatistics();
+		}
+
+		vallox.snapshot(properties);
+		const ValloxStatistics& statistics = vallox.getStatistics();
+
+		Clock::time_point start = Clock::now();
+		uint16_t length = patched.render(properties, statistics);
+		patchSeconds += std::chrono::duration<double>(Clock::now() - start).count();
+		patchedFields += patched.getPatchedFields();
+
+		fresh.invalidate();
+		start = Clock::now();
+		uint16_t freshLength = fresh.render(properties, statistics);
+		renderSeconds += std::chrono::duration<double>(Clock::now() - start).count();
+
+		if (patched.getPatchedFields() == fresh.getPatchedFields())
+		{
+			rebuilds++;
+		}
+		if (length == 0 || length != freshLength || memcmp(patchedText, freshText, length) != 0 || !isWellFormed(patchedText, length) ||
+			!listsKnownProperties(patchedText, length, properties))
+		{
+			if (mismatches++ == 0)
+			{
+				printf("scrape %d: patched text differs\n%.*s\n", scrape + 1, (int)length, patchedText);
+			}
+		}
+	}
+
+	printf("%d scrapes of %u bytes: patched %.0f ns (%.1f values, %d complete), complete render %.0f ns, %d mismatches\n",
+		scrapes, patched.getLength(), patchSeconds * 1e9 / scrapes, (double)patchedFields / scrapes, rebuilds,
+		renderSeconds * 1e9 / scrapes, mismatches);
+	return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,191 @@
+// Throughput benchmark for ValloxSerial::receive().
+//
+// Feeds a capture of recorded telegrams through the decoder and reports the
+// cost per telegram with and without the user callbacks attached and when
+// the capture is drained by receiveAll() in large batches. The batch
+// notification modes report how many callbacks they save, the subscriber mode
+// shows the cost of several filtered listeners.
+//
+// usage: ValloxReceiveBenchmark [telegrams] [runs]
+
+#include <ValloxSerial.h>
+#include <MemoryStream.h>
+#include "TelegramCapture.h"
+
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+
+static volatile uint32_t propertyChanges = 0;
+static volatile uint32_t telegramCallbacks = 0;
+
+static void onPropertyChanged(ValloxProperty propertyId, int8_t value)
+{
+	propertyChanges = propertyChanges + 1;
+}
+
+static void onPropertiesChanged(const ValloxPropertyMask& changedProperties, const ValloxPropertyStore& properties)
+{
+	propertyChanges = propertyChanges + 1;
+}
+
+static void onSubscribedPropertyChanged(void* pContext, ValloxProperty propertyId, int8_t value)
+{
+	uint32_t* pChanges = (uint32_t*)pContext;
+	(*pChanges)++;
+	propertyChanges = propertyChanges + 1;
+}
+
+static bool onTelegramReceived(uint8_t sender, uint8_t receiver, uint8_t command, uint8_t arg)
+{
+	telegramCallbacks = telegramCallbacks + 1;
+	return true;
+}
+
+enum CallbackMode
+{
+	NoCallbacks,
+	PropertyCallback,
+	AllCallbacks,
+	Drain,
+	TelegramBatch,
+	ReceiveBatch,
+	Subscribers
+};
+
+static const char* CALLBACK_MODE_NAMES[] =
+{
+	"no callbacks",
+	"property callback",
+	"property + telegram callback",
+	"receiveAll, no callbacks",
+	"batch per telegram",
+	"batch per receiveAll",
+	"4 filtered subscribers"
+};
+
+struct Result
+{
+	double seconds;
+	size_t telegrams;
+	size_t received;
+	size_t callbacks;
+};
+
+static Result run(const std::vector<uint8_t>& capture, CallbackMode mode)
+{
+	MemoryStream rxStream;
+	MemoryStream txStream;
+	rxStream.setInput(capture.data(), capture.size());
+
+	ValloxSerial vallox;
+	vallox.setRxSerial(rxStream);
+	vallox.setTxSerial(txStream);
+
+	if (mode == PropertyCallback || mode == AllCallbacks)
+	{
+		vallox.attachPropertyChanged(onPropertyChanged);
+	}
+	if (mode == AllCallbacks)
+	{
+		vallox.attach(onTelegramReceived);
+	}
+	if (mode == TelegramBatch || mode == ReceiveBatch)
+	{
+		vallox.setNotificationMode(mode == TelegramBatch ? NotifyPerTelegram : NotifyPerReceive);
+		vallox.attachPropertiesChanged(onPropertiesChanged);
+	}
+
+	// temperatures, fan speed, select bits and a setting which never changes
+	uint32_t subscriberChanges[4] = { 0, 0, 0, 0 };
+	if (mode == Subscribers)
+	{
+		ValloxPropertyMask interests[4];
+		interests[0].add(TempInsideProperty);
+		interests[0].add(TempOutsideProperty);
+		interests[0].add(TempExhaustProperty);
+		interests[0].add(TempIncommingProperty);
+		interests[1].add(FanSpeedProperty);
+		interests[2].add(PowerStateProperty);
+		interests[2].add(FaultIndicatorProperty);
+		interests[3].add(HeatingSetPointProperty);
+		for (int i = 0; i < 4; i++)
+		{
+			vallox.subscribe(onSubscribedPropertyChanged, &subscriberChanges[i], interests[i]);
+		}
+	}
+	propertyChanges = 0;
+
+	Result result;
+	result.telegrams = capture.size() / VALLOX_LENGTH;
+	result.received = 0;
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	if (mode == Drain || mode == ReceiveBatch)
+	{
+		int pendingBytes = rxStream.available();
+		while (pendingBytes >= VALLOX_LENGTH)
+		{
+			result.received += vallox.receiveAll(10000, &pendingBytes);
+		}
+	}
+	else
+	{
+		while (rxStream.available() >= VALLOX_LENGTH)
+		{
+			if (vallox.receive())
+			{
+				result.received++;
+			}
+		}
+	}
+	std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+	result.seconds = std::chrono::duration<double>(end - start).count();
+	result.callbacks = propertyChanges;
+	return result;
+}
+
+int main(int argc, char** argv)
+{
+	size_t telegramCount = argc > 1 ? strtoul(argv[1], NULL, 10) : 5000000;
+	int runs = argc > 2 ? std::max(1, atoi(argv[2])) : 5;
+
+	std::vector<uint8_t> capture = buildCapture(telegramCount);
+
+	printf("%zu telegrams, best of %d runs\n", telegramCount, runs);
+
+	// warm up caches and page in the capture before measuring
+	run(capture, NoCallbacks);
+
+	double baseline = 0;
+	for (int mode = NoCallbacks; mode <= Subscribers; mode++)
+	{
+		Result best = run(capture, (CallbackMode)mode);
+		for (int i = 1; i < runs; i++)
+		{
+			Result result = run(capture, (CallbackMode)mode);
+			if (result.seconds < best.seconds)
+			{
+				best = result;
+			}
+		}
+
+		double nsPerTelegram = best.seconds * 1e9 / best.telegrams;
+		if (mode == NoCallbacks)
+		{
+			baseline = nsPerTelegram;
+		}
+
+		printf("%-30s %12.0f telegrams/s %8.2f ns/telegram %+8.2f ns callback overhead (%zu handled, %zu change callbacks)\n",
+			CALLBACK_MODE_NAMES[mode],
+			best.telegrams / best.seconds,
+			nsPerTelegram,
+			nsPerTelegram - baseline,
+			best.received,
+			best.callbacks);
+	}
+
+	return 0;
+}
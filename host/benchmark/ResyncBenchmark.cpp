@@ -0,0 +1,139 @@
+// Compares the block parser with the resynchronizing sliding window parser on
+// captures with injected noise.
+//
+// Noise is injected as random stray bytes between telegrams and as single bit
+// errors or dropped bytes inside telegrams, both with the given probability
+// per telegram.
+//
+// usage: ValloxResyncBenchmark [telegrams] [noise probability]
+
+#include <ValloxSerial.h>
+#include <MemoryStream.h>
+#include "TelegramCapture.h"
+
+#include <chrono>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+
+static uint32_t validTelegrams = 0;
+
+static bool onTelegramReceived(uint8_t sender, uint8_t receiver, uint8_t command, uint8_t arg)
+{
+	validTelegrams++;
+	return true;
+}
+
+static std::vector<uint8_t> injectNoise(const std::vector<uint8_t>& capture, double probability, size_t* pCorrupted)
+{
+	std::mt19937 random(4711);
+	std::uniform_real_distribution<double> chance(0.0, 1.0);
+	std::uniform_int_distribution<int> anyByte(0, 255);
+	std::uniform_int_distribution<int> strayCount(1, 3);
+	std::uniform_int_distribution<int> anyBit(0, VALLOX_LENGTH * 8 - 1);
+
+	std::vector<uint8_t> noisy;
+	noisy.reserve(capture.size() + capture.size() / 2);
+	*pCorrupted = 0;
+
+	for (size_t offset = 0; offset + VALLOX_LENGTH <= capture.size(); offset += VALLOX_LENGTH)
+	{
+		if (chance(random) < probability)
+		{
+			int count = strayCount(random);
+			for (int i = 0; i < count; i++)
+			{
+				noisy.push_back((uint8_t)anyByte(random));
+			}
+		}
+
+		size_t start = noisy.size();
+		noisy.insert(noisy.end(), capture.begin() + offset, capture.begin() + offset + VALLOX_LENGTH);
+
+		if (chance(random) < probability)
+		{
+			int bit = anyBit(random);
+			if (bit % 2)
+			{
+				noisy[start + bit / 8] ^= (uint8_t)(1 << (bit % 8));
+			}
+			else
+			{
+				noisy.erase(noisy.begin() + start + bit / 8);
+			}
+			(*pCorrupted)++;
+		}
+	}
+
+	return noisy;
+}
+
+static double run(const std::vector<uint8_t>& capture, bool resynchronize, uint32_t* pValid, ValloxStatistics* pStatistics)
+{
+	MemoryStream rxStream;
+	MemoryStream txStream;
+	rxStream.setInput(capture.data(), capture.size());
+
+	ValloxSerial vallox;
+	vallox.setRxSerial(rxStream);
+	vallox.setTxSerial(txStream);
+	vallox.setResynchronize(resynchronize);
+	vallox.attach(onTelegramReceived);
+
+	validTelegrams = 0;
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	if (resynchronize)
+	{
+		while (rxStream.available() > 0)
+		{
+			vallox.receive();
+		}
+	}
+	else
+	{
+		while (rxStream.available() >= VALLOX_LENGTH)
+		{
+			vallox.receive();
+		}
+	}
+	std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+	*pValid = validTelegrams;
+	*pStatistics = vallox.getStatistics();
+	return std::chrono::duration<double>(end - start).count();
+}
+
+int main(int argc, char** argv)
+{
+	size_t telegramCount = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+	double probability = argc > 2 ? atof(argv[2]) : 0.01;
+
+	std::vector<uint8_t> clean = buildCapture(telegramCount);
+	size_t corrupted = 0;
+	std::vector<uint8_t> noisy = injectNoise(clean, probability, &corrupted);
+
+	printf("%zu telegrams, noise probability %.4f, %zu telegrams corrupted, %zu bytes captured\n",
+		telegramCount, probability, corrupted, noisy.size());
+
+	const char* names[] = { "block parser", "sliding window parser" };
+	for (int resynchronize = 0; resynchronize <= 1; resynchronize++)
+	{
+		uint32_t valid = 0;
+		ValloxStatistics statistics;
+		double seconds = run(noisy, resynchronize != 0, &valid, &statistics);
+
+		size_t expected = telegramCount - corrupted;
+		size_t lost = expected > valid ? expected - valid : 0;
+		printf("%-22s %8u decoded %8zu lost (%6.3f%%) %8.2f ns/telegram skipped=%u recovered=%u\n",
+			names[resynchronize],
+			valid,
+			lost,
+			100.0 * lost / telegramCount,
+			seconds * 1e9 / telegramCount,
+			statistics.skippedBytes,
+			statistics.recoveredTelegrams);
+	}
+
+	return 0;
+}
@@ -0,0 +1,145 @@
+// Stress test and benchmark of the shared store under a saturated bus.
+//
+// One thread decodes a capture in a loop as fast as it can, every other
+// telegram changes the select status. The reader threads take snapshots of the
+// shared store meanwhile and check that the select status and its eight bits
+// always belong to the same telegram. Reports the decoded telegrams, the
+// snapshots per second and exits with 1 if a reader saw a torn snapshot.
+//
+// usage: ValloxSnapshotBenchmark [seconds] [readers]
+
+#include <ValloxSerial.h>
+#include <MemoryStream.h>
+#include "TelegramCapture.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef std::chrono::steady_clock Clock;
+
+static const ValloxProperty SELECT_BITS[] =
+{
+	PowerStateProperty, CO2AdjustStateProperty, HumidityAdjustStateProperty, HeatingStateProperty,
+	FilterGuardIndicatorProperty, HeatingIndicatorProperty, FaultIndicatorProperty, ServiceReminderIndicatorProperty
+};
+
+struct ReaderResult
+{
+	uint64_t snapshots;
+	uint64_t torn;
+	uint64_t publishes;		// different sequences seen
+};
+
+static std::atomic<bool> running(true);
+
+static bool isConsistent(const ValloxPropertyStore& store)
+{
+	uint8_t select = (uint8_t)store.getValue(SelectStatusProperty);
+	for (uint8_t bit = 0; bit < 8; bit++)
+	{
+		if (store.getValue(SELECT_BITS[bit]) != ((select >> bit) & 1))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+static void decode(const std::vector<uint8_t>& capture, uint64_t* pTelegrams, ValloxSerial* pVallox)
+{
+	MemoryStream stream;
+	stream.setInput(capture.data(), capture.size());
+	pVallox->setRxSerial(stream);
+	pVallox->setTxSerial(stream);
+
+	uint64_t telegrams = 0;
+	while (running.load(std::memory_order_relaxed))
+	{
+		stream.rewind();
+		telegrams += pVallox->receiveAll();
+		pVallox->calculateResults();
+	}
+	*pTelegrams = telegrams;
+}
+
+static void readSnapshots(const ValloxSharedStore* pShared, ReaderResult* pResult)
+{
+	ValloxPropertyStore store;
+	uint32_t lastSequence = 0;
+	ReaderResult result = { 0, 0, 0 };
+
+	while (running.load(std::memory_order_relaxed))
+	{
+		uint32_t sequence = pShared->getSequence();
+		pShared->read(store);
+		result.snapshots++;
+		if (sequence != lastSequence)
+		{
+			result.publishes++;
+			lastSequence = sequence;
+		}
+
+		// the initial store knows none of the bits yet
+		if (store.getValue(SelectStatusProperty) != VALLOX_UNKNOWN_VALUE || store.getValue(PowerStateProperty) != VALLOX_UNKNOWN_VALUE)
+		{
+			if (!isConsistent(store))
+			{
+				result.torn++;
+			}
+		}
+	}
+	*pResult = result;
+}
+
+int main(int argc, char** argv)
+{
+	int seconds = argc > 1 ? atoi(argv[1]) : 3;
+	int readers = argc > 2 ? atoi(argv[2]) : 3;
+
+	// every select value once, between the telegrams of the recorded session
+	std::vector<uint8_t> capture;
+	for (int i = 0; i < 256; i++)
+	{
+		CapturedTelegram select = { VALLOX_ADDRESS_MASTER, VALLOX_ADDRESS_PANELS, VALLOX_VARIABLE_SELECT, (uint8_t)(i * 37 + 1) };
+		appendTelegram(capture, select);
+		appendTelegram(capture, CAPTURED_SESSION[i % CAPTURED_SESSION_LENGTH]);
+	}
+
+	ValloxSerial vallox;
+	uint64_t telegrams = 0;
+	std::vector<ReaderResult> results(readers);
+	std::vector<std::thread> threads;
+
+	Clock::time_point start = Clock::now();
+	threads.push_back(std::thread(decode, std::cref(capture), &telegrams, &vallox));
+	for (int i = 0; i < readers; i++)
+	{
+		threads.push_back(std::thread(readSnapshots, &vallox.getSharedStore(), &results[i]));
+	}
+
+	std::this_thread::sleep_for(std::chrono::seconds(seconds));
+	running = false;
+	for (size_t i = 0; i < threads.size(); i++)
+	{
+		threads[i].join();
+	}
+	double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+	uint64_t snapshots = 0;
+	uint64_t torn = 0;
+	printf("decoded %.0f telegrams/s, %u publishes\n", telegrams / elapsed, vallox.getSharedStore().getSequence() / 2);
+	for (int i = 0; i < readers; i++)
+	{
+		printf("reader %d: %.0f snapshots/s, %llu publishes seen, %llu torn\n", i + 1, results[i].snapshots / elapsed,
+			(unsigned long long)results[i].publishes, (unsigned long long)results[i].torn);
+		snapshots += results[i].snapshots;
+		torn += results[i].torn;
+	}
+	printf("%d readers: %.0f snapshots/s, %llu torn\n", readers, snapshots / elapsed, (unsigned long long)torn);
+
+	return torn == 0 ? 0 : 1;
+}
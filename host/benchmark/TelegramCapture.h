@@ -0,0 +1,83 @@
+// Bus traffic used by the host benchmarks.
+//
+// The sequence below follows a recorded session of a Vallox Digit SE: the
+// master broadcasts its sensor values to all panels, answers the polls of
+// panel 1 and the panels acknowledge. Temperatures drift slowly over the
+// cycles so that a realistic share of the telegrams changes a property.
+
+#ifndef TelegramCapture_h
+#define TelegramCapture_h
+
+#include <ValloxProtocol.h>
+#include <vector>
+
+struct CapturedTelegram
+{
+	uint8_t sender;
+	uint8_t receiver;
+	uint8_t command;
+	uint8_t arg;
+};
+
+static const CapturedTelegram CAPTURED_SESSION[] =
+{
+	{ VALLOX_ADDRESS_MASTER, VALLOX_ADDRESS_PANELS, VALLOX_VARIABLE_TEMP_OUTSIDE, 0x8C },
+	{ VALLOX_ADDRESS_MASTER, VALLOX_ADDRESS_PANELS, VALLOX_VARIABLE_TEMP_EXHAUST, 0x98 },
+	{ VALLOX_ADDRESS_MASTER, VALLOX_ADDRESS_PANELS, VALLOX_VARIABLE_TEMP_INSIDE, 0xAD },
+	{ VALLOX_ADDRESS_MASTER, VALLOX_ADDRESS_PANELS, VALLOX_VARIABLE_TEMP_INCOMMING, 0xA6 },
+	{ VALLOX_ADDRESS_PANEL1, VALLOX_ADDRESS_MASTER, VALLOX_VARIABLE_POLL, VALLOX_VARIABLE_FAN_SPEED },
+	{ VALLOX_ADDRESS_MASTER, VALLOX_ADDRESS_PANEL1, VALLOX_VARIABLE_FAN_SPEED, 0x07 },
+	{ VALLOX_ADDRESS_PANEL1, VALLOX_ADDRESS_MASTER, VALLOX_VARIABLE_POLL, VALLOX_VARIABLE_SELECT },
+	{ VALLOX_ADDRESS_MASTER, VALLOX_ADDRESS_PANEL1, VALLOX_VARIABLE_SELECT, 0x09 },
+	{ VALLOX_ADDRESS_PANEL1, VALLOX_ADDRESS_MASTER, VALLOX_VARIABLE_POLL, VALLOX_VARIABLE_HEATING_SET_POINT },
+	{ VALLOX_ADDRESS_MASTER, VALLOX_ADDRESS_PANEL1, VALLOX_VARIABLE_HEATING_SET_POINT, 0xA5 },
+	{ VALLOX_ADDRESS_PANEL1, VALLOX_ADDRESS_MASTER, VALLOX_VARIABLE_POLL, VALLOX_VARIABLE_PROGRAM },
+	{ VALLOX_ADDRESS_MASTER, VALLOX_ADDRESS_PANEL1, VALLOX_VARIABLE_PROGRAM, 0x0A },
+	{ VALLOX_ADDRESS_PANEL1, VALLOX_ADDRESS_MASTER, VALLOX_VARIABLE_POLL, VALLOX_VARIABLE_IOPORT_MULTI_PURPOSE_2 },
+	{ VALLOX_ADDRESS_MASTER, VALLOX_ADDRESS_PANEL1, VALLOX_VARIABLE_IOPORT_MULTI_PURPOSE_2, 0x02 },
+	{ VALLOX_ADDRESS_MASTER, VALLOX_ADDRESS_PANELS, VALLOX_VARIABLE_HUMIDITY, 0x6E },
+	{ VALLOX_ADDRESS_MASTER, VALLOX_ADDRESS_PANELS, VALLOX_VARIABLE_CO2_HIGH, 0x02 },
+	{ VALLOX_ADDRESS_MASTER, VALLOX_ADDRESS_PANELS, VALLOX_VARIABLE_CO2_LOW, 0x58 },
+	{ VALLOX_ADDRESS_MASTER, VALLOX_ADDRESS_PANELS, VALLOX_VARIABLE_FLAGS_2, 0x00 },
+	{ VALLOX_ADDRESS_MASTER, VALLOX_ADDRESS_PANEL2, VALLOX_VARIABLE_FAN_SPEED, 0x07 },
+	{ VALLOX_ADDRESS_MASTER, VALLOX_ADDRESS_PANELS, VALLOX_VARIABLE_LAST_ERROR_NUMBER, 0x00 },
+};
+static const size_t CAPTURED_SESSION_LENGTH = sizeof(CAPTURED_SESSION) / sizeof(CapturedTelegram);
+
+// appends one telegram including domain and checksum
+static inline void appendTelegram(std::vector<uint8_t>& capture, const CapturedTelegram& telegram)
+{
+	uint8_t bytes[VALLOX_LENGTH];
+	bytes[0] = VALLOX_DOMAIN;
+	bytes[1] = telegram.sender;
+	bytes[2] = telegram.receiver;
+	bytes[3] = telegram.command;
+	bytes[4] = telegram.arg;
+	bytes[5] = Vallox::calculateChecksum(bytes);
+	capture.insert(capture.end(), bytes, bytes + VALLOX_LENGTH);
+}
+
+// builds a capture with the given number of telegrams by replaying the session
+// while letting the temperatures drift by one step every few cycles.
+static inline std::vector<uint8_t> buildCapture(size_t telegramCount)
+{
+	std::vector<uint8_t> capture;
+	capture.reserve(telegramCount * VALLOX_LENGTH);
+
+	for (size_t i = 0; i < telegramCount; i++)
+	{
+		size_t cycle = i / CAPTURED_SESSION_LENGTH;
+		CapturedTelegram telegram = CAPTURED_SESSION[i % CAPTURED_SESSION_LENGTH];
+
+		if (telegram.command >= VALLOX_VARIABLE_TEMP_OUTSIDE && telegram.command <= VALLOX_VARIABLE_TEMP_INCOMMING)
+		{
+			telegram.arg = (uint8_t)(telegram.arg + ((cycle / 4) % 8));
+		}
+
+		appendTelegram(capture, telegram);
+	}
+
+	return capture;
+}
+
+#endif // TelegramCapture_h
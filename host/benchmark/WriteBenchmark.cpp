@@ -0,0 +1,234 @@
+// Checks the write confirmation against a simulated master.
+//
+// Every case changes the fan speed on a virtual bus and looks at the outcome
+// of the write, its retries and at the fan speed property meanwhile:
+//
+//   accepted   the master takes the write, it is confirmed without a retry
+//   rejected   the master keeps its value, the write fails after the retries
+//              which are at least the timeout apart
+//   silent     the master neither takes the write nor answers polls, the
+//              optimistic value is restored after the last retry
+//   stale      broadcasts of the old value meet the write on the bus, they
+//              neither fail nor repeat the write and the optimistic value
+//              does not flap
+//   in flight  the write follows a poll of the same variable which is still
+//              waiting for its reply, a read back after the write confirms
+//              it without a retry
+//   indicators the select status is written with an indicator the master set
+//              meanwhile missing, the master keeps it and the write is
+//              confirmed by the bits it sets
+//
+// Reports the latency of every case and exits with 1 if one of them behaved
+// otherwise.
+//
+// usage: ValloxWriteBenchmark
+
+#include <ValloxSerial.h>
+#include <ValloxBusSimulator.h>
+
+#include <vector>
+#include <stdio.h>
+
+const uint32_t STEP_US = 250;
+
+static ValloxBusSimulator* pBus = NULL;
+static std::vector<int8_t> fanSpeeds;	// changes of the fan speed property since the write
+static int completions = 0;
+static bool confirmed = false;
+static uint16_t latency = 0;
+static int pollReplies = 0;
+static int failures = 0;
+
+static unsigned long busClock()
+{
+	return pBus->getTimeMs();
+}
+
+static void onPropertyChanged(ValloxProperty propertyId, int8_t value)
+{
+	if (propertyId == FanSpeedProperty)
+	{
+		fanSpeeds.push_back(value);
+	}
+}
+
+static void onWriteCompleted(void* pContext, uint8_t variable, bool writeConfirmed, uint8_t value, uint16_t latencyMs)
+{
+	completions++;
+	confirmed = writeConfirmed;
+	latency = latencyMs;
+}
+
+static void onPollCompleted(void* pContext, uint8_t variable, bool replied, uint8_t value, uint16_t latencyMs)
+{
+	pollReplies++;
+}
+
+static void run(ValloxBusSimulator& bus, ValloxSerial& vallox, uint32_t ms)
+{
+	for (uint32_t i = 0; i < ms * 1000 / STEP_US; i++)
+	{
+		bus.advance(STEP_US);
+		vallox.receiveAll();
+	}
+}
+
+static void expect(const char* name, bool condition, const char* description)
+{
+	if (!condition)
+	{
+		printf("%s: %s\n", name, description);
+		failures++;
+	}
+}
+
+static std::vector<int8_t> only(int8_t value)
+{
+	return std::vector<int8_t>(1, value);
+}
+
+enum WriteCase
+{
+	Accepted,
+	Rejected,
+	Silent,
+	Stale,
+	InFlight,
+	Indicators
+};
+
+static void check(const char* name, WriteCase writeCase)
+{
+	ValloxSimulatorConfig config;
+	config.suspendIntervalMs = 0;
+	config.writesTaken = writeCase != Rejected && writeCase != Silent;
+	config.pollsAnswered = writeCase != Silent;
+	if (writeCase == InFlight)
+	{
+		// the write gets out before the reply to the poll and meets no other traffic
+		config.replyDelayUs = 30000;
+		config.telegramsPerSecond = 5;
+	}
+
+	ValloxBusSimulator bus(config);
+	pBus = &bus;
+	bus.setVariable(VALLOX_VARIABLE_FAN_SPEED, Vallox::convertBackFanSpeed(2 - 1));
+
+	ValloxSerial vallox;
+	vallox.setRxSerial(bus);
+	vallox.setTxSerial(bus);
+	vallox.setResynchronize(true);
+	vallox.setNonBlockingTransmit(true);
+	vallox.setListenBeforeTalk(2, true);
+	vallox.attachClock(busClock);
+	vallox.attachPropertyChanged(onPropertyChanged);
+	vallox.attachWriteCompleted(onWriteCompleted);
+	vallox.setWriteMode(writeCase == Rejected ? WriteVerified : WriteOptimistic);
+
+	// learn the fan speed from the broadcasts first
+	run(bus, vallox, 2000);
+	expect(name, vallox.getValue(FanSpeedProperty) == 2, "fan speed not received");
+
+	fanSpeeds.clear();
+	completions = 0;
+	if (writeCase == Stale)
+	{
+		// one broadcast of the old value is on its way already, two more follow within 15 ms
+		bus.broadcast(VALLOX_VARIABLE_FAN_SPEED, Vallox::convertBackFanSpeed(2 - 1));
+		vallox.setFanSpeed(5);
+		for (int i = 0; i < 2; i++)
+		{
+			run(bus, vallox, 7);
+			bus.broadcast(VALLOX_VARIABLE_FAN_SPEED, Vallox::convertBackFanSpeed(2 - 1));
+		}
+	}
+	else if (writeCase == InFlight)
+	{
+		// the poll is on the bus and the reply of the master still to come
+		uint32_t transmitted = vallox.getStatistics().transmittedTelegrams;
+		pollReplies = 0;
+		vallox.pollVariable(VALLOX_VARIABLE_FAN_SPEED, onPollCompleted);
+		for (int i = 0; i < 400 && vallox.getStatistics().transmittedTelegrams == transmitted; i++)
+		{
+			bus.advance(STEP_US);
+			vallox.receiveAll();
+		}
+		expect(name, pollReplies == 0, "poll answered before the write");
+		vallox.setFanSpeed(5);
+	}
+	else if (writeCase == Indicators)
+	{
+		// the filter guard comes on at the master while the device switches the power on
+		bus.setVariable(VALLOX_VARIABLE_SELECT, 0x10);
+		vallox.setSelectStatus(0x01);
+	}
+	else
+	{
+		vallox.setFanSpeed(5);
+	}
+	run(bus, vallox, 3000);
+
+	uint8_t variable = writeCase == Indicators ? VALLOX_VARIABLE_SELECT : VALLOX_VARIABLE_FAN_SPEED;
+	ValloxWriteStatistics statistics;
+	vallox.getWriteStatistics(variable, &statistics);
+	uint16_t minimumLatency = VALLOX_WRITE_TIMEOUT_MS * (VALLOX_WRITE_RETRIES + 1);
+
+	expect(name, completions == 1, "not completed once");
+	switch (writeCase)
+	{
+	case Accepted:
+	case Stale:
+	case InFlight:
+	{
+		expect(name, confirmed && statistics.retries == 0, "not confirmed at the first try");
+		expect(name, bus.getVariable(VALLOX_VARIABLE_FAN_SPEED) == Vallox::convertBackFanSpeed(5 - 1), "master does not hold the value");
+		expect(name, fanSpeeds == only(5), "fan speed did not change to 5 at once");
+		break;
+	}
+	case Indicators:
+	{
+		expect(name, confirmed && statistics.retries == 0, "not confirmed at the first try");
+		expect(name, bus.getVariable(VALLOX_VARIABLE_SELECT) == 0x11, "master does not hold the power and its indicator");
+		expect(name, vallox.getValue(PowerStateProperty) == 1 && vallox.getValue(FilterGuardIndicatorProperty) == 1,
+			"properties do not show the select status of the master");
+		break;
+	}
+	case Rejected:
+	{
+		expect(name, !confirmed && statistics.retries == VALLOX_WRITE_RETRIES, "did not fail after the retries");
+		expect(name, latency >= minimumLatency, "retried before the timeout");
+		expect(name, vallox.getValue(FanSpeedProperty) == 2, "fan speed does not show the value of the master");
+		break;
+	}
+	case Silent:
+	{
+		expect(name, !confirmed && statistics.retries == VALLOX_WRITE_RETRIES, "did not fail after the retries");
+		expect(name, latency >= minimumLatency, "retried before the timeout");
+		std::vector<int8_t> restored;
+		restored.push_back(5);
+		restored.push_back(2);
+		expect(name, fanSpeeds == restored, "fan speed not restored once");
+		break;
+	}
+	}
+
+	printf("%-10s %s after %u writes, %u ms, %zu fan speed changes\n", name,
+		confirmed ? "confirmed" : "failed", statistics.retries + 1, latency, fanSpeeds.size());
+}
+
+int main(int argc, char** argv)
+{
+	check("accepted", Accepted);
+	check("rejected", Rejected);
+	check("silent", Silent);
+	check("stale", Stale);
+	check("in flight", InFlight);
+	check("indicators", Indicators);
+
+	if (failures > 0)
+	{
+		printf("%d expectations failed\n", failures);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,146 @@
+// Exports the properties and bus statistics of a serial device for Prometheus.
+//
+// One epoll loop decodes the bus like ValloxMonitor and answers scrapes of
+// http://127.0.0.1:<port>/metrics with the OpenMetrics text, a slow client
+// never holds up the bus. The text is
+// rendered into a static buffer, a scrape only patches the values which
+// changed since the previous one.
+//
+// usage: ValloxExporter [--rs485] [--port n] [--seconds s] device
+
+#include <ValloxSerial.h>
+#include <ValloxMetrics.h>
+#include <ValloxMetricsServer.h>
+#include <ValloxPosixSerial.h>
+
+#include <chrono>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+
+typedef std::chrono::steady_clock Clock;
+
+static volatile sig_atomic_t running = 1;
+static char text[8192];
+
+static void onSignal(int signal)
+{
+	running = 0;
+}
+
+int main(int argc, char** argv)
+{
+	bool rs485 = false;
+	int port = 9710;
+	unsigned long seconds = 0;
+	const char* pDevice = NULL;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--rs485") == 0)
+		{
+			rs485 = true;
+		}
+		else if (strcmp(argv[i], "--port") == 0 && i + 1 < argc)
+		{
+			port = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc)
+		{
+			seconds = atoi(argv[++i]);
+		}
+		else
+		{
+			pDevice = argv[i];
+		}
+	}
+
+	if (!pDevice)
+	{
+		fprintf(stderr, "usage: ValloxExporter [--rs485] [--port n] [--seconds s] device\n");
+		return 2;
+	}
+
+	ValloxPosixSerial serial;
+	if (!serial.open(pDevice, rs485))
+	{
+		perror(pDevice);
+		return 2;
+	}
+
+	ValloxMetricsServer server;
+	if (!server.open(port))
+	{
+		perror("metrics port");
+		return 2;
+	}
+
+	ValloxSerial vallox;
+	serial.attach(vallox);
+	vallox.setResynchronize(true);
+	vallox.setNonBlockingTransmit(true);
+
+	ValloxMetrics metrics(text, sizeof(text));
+
+	int epoll = epoll_create1(0);
+	if (epoll < 0)
+	{
+		perror("epoll");
+		return 2;
+	}
+	struct epoll_event event;
+	memset(&event, 0, sizeof(event));
+	event.events = EPOLLIN;
+	event.data.fd = serial.getFd();
+	epoll_ctl(epoll, EPOLL_CTL_ADD, serial.getFd(), &event);
+	event.data.fd = server.getFd();
+	epoll_ctl(epoll, EPOLL_CTL_ADD, server.getFd(), &event);
+
+	signal(SIGINT, onSignal);
+	signal(SIGTERM, onSignal);
+
+	fprintf(stderr, "serving http://127.0.0.1:%d/metrics\n", port);
+	Clock::time_point start = Clock::now();
+	Clock::time_point lastTick = start;
+
+	while (running && (seconds == 0 || Clock::now() - start < std::chrono::seconds(seconds)))
+	{
+		// the bus is ticked every getTimeout() ms even while scrapes and traffic wake the loop,
+		// slow clients are closed by their deadline
+		long sinceTick = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - lastTick).count();
+		int timeout = sinceTick < serial.getTimeout() ? serial.getTimeout() - (int)sinceTick : 0;
+		int serverTimeout = server.getTimeout();
+		timeout = serverTimeout >= 0 && serverTimeout < timeout ? serverTimeout : timeout;
+
+		struct epoll_event events[2];
+		int ready = epoll_wait(epoll, events, 2, timeout);
+		for (int i = 0; i < ready; i++)
+		{
+			if (events[i].data.fd == server.getFd())
+			{
+				server.onReadable(metrics, vallox);
+			}
+			else if (!serial.onReadable())
+			{
+				fprintf(stderr, "%s closed\n", pDevice);
+				running = 0;
+			}
+		}
+
+		Clock::time_point now = Clock::now();
+		if (now - lastTick >= std::chrono::milliseconds(serial.getTimeout()))
+		{
+			serial.onTimeout();
+			lastTick = now;
+		}
+		server.onTimeout();
+	}
+
+	fprintf(stderr, "%u scrapes, %u bytes of text, %u values patched by the last one\n",
+		server.getRequests(), metrics.getLength(), metrics.getPatchedFields());
+
+	close(epoll);
+	return 0;
+}
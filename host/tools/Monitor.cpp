@@ -0,0 +1,206 @@
+// Prints the property changes seen on a serial device or pseudo terminal.
+//
+// The receive loop sleeps in epoll_wait() until bytes arrive and decodes them
+// in one go, so an idle bus costs next to no CPU. At the end the number of
+// wakeups, the decode latency from the wakeup to the property change callback
+// and the CPU time used are reported, followed by the bus statistics of the
+// library. SIGUSR1 prints the statistics and resets them.
+//
+// usage: ValloxMonitor [--rs485] [--seconds s] [--quiet] device
+
+#include <ValloxSerial.h>
+#include <ValloxPosixSerial.h>
+
+#include <chrono>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+
+typedef std::chrono::steady_clock Clock;
+
+static volatile sig_atomic_t running = 1;
+static volatile sig_atomic_t reportRequested = 0;
+static bool quiet = false;
+static Clock::time_point wakeup;
+static uint32_t changes = 0;
+static double totalLatencyUs = 0;
+static double maxLatencyUs = 0;
+
+static void onSignal(int signal)
+{
+	running = 0;
+}
+
+static void onReportSignal(int signal)
+{
+	reportRequested = 1;
+}
+
+static void onPropertyChanged(ValloxProperty propertyId, int8_t value)
+{
+	double latency = std::chrono::duration<double, std::micro>(Clock::now() - wakeup).count();
+	totalLatencyUs += latency;
+	maxLatencyUs = latency > maxLatencyUs ? latency : maxLatencyUs;
+	changes++;
+
+	if (!quiet)
+	{
+		printf("%lu %d %d\n", ValloxPosixSerial::millis(), (int)propertyId, (int)value);
+	}
+}
+
+static void printStatistics(const ValloxStatistics& statistics)
+{
+	fprintf(stderr, "received %u bytes %u telegrams, %u checksum failures %u unexpected bytes, %u bytes/s peak %u bytes/s\n",
+		statistics.receivedBytes, statistics.receivedTelegrams, statistics.checksumFailures, statistics.unexpectedBytes,
+		statistics.bytesPerSecond, statistics.peakBytesPerSecond);
+	fprintf(stderr, "sent %u telegrams, %u collisions %u dropped, writes %u queued %u coalesced %u dropped\n",
+		statistics.transmittedTelegrams, statistics.collisions, statistics.droppedTelegrams,
+		statistics.queuedWrites, statistics.coalescedWrites, statistics.droppedWrites);
+	fprintf(stderr, "%u suspensions, %u ms suspended, longest %u ms, %u missed resumes\n",
+		statistics.suspensions, statistics.suspendedMs, statistics.longestSuspensionMs, statistics.missedResumes);
+
+	fprintf(stderr, "gaps:");
+	for (uint8_t i = 0; i < VALLOX_GAP_BUCKETS; i++)
+	{
+		if (i < VALLOX_GAP_BUCKETS - 1)
+		{
+			fprintf(stderr, " <%ums %u", (unsigned)VALLOX_GAP_FIRST_LIMIT_MS << i, statistics.gaps[i]);
+		}
+		else
+		{
+			fprintf(stderr, " longer %u\n", statistics.gaps[i]);
+		}
+	}
+
+#if VALLOX_STATISTICS_TABLES
+	fprintf(stderr, "pairs:");
+	for (uint8_t i = 0; i < VALLOX_STATISTICS_PAIRS; i++)
+	{
+		if (statistics.pairs[i].telegrams != 0)
+		{
+			fprintf(stderr, " %02X>%02X %u", statistics.pairs[i].sender, statistics.pairs[i].receiver, statistics.pairs[i].telegrams);
+		}
+	}
+	fprintf(stderr, " other %u\n", statistics.otherPairTelegrams);
+
+	fprintf(stderr, "variables:");
+	for (uint8_t i = 0; i < VALLOX_STATISTICS_VARIABLES; i++)
+	{
+		if (statistics.variables[i].telegrams != 0)
+		{
+			fprintf(stderr, " %02X %u", statistics.variables[i].variable, statistics.variables[i].telegrams);
+		}
+	}
+	fprintf(stderr, " other %u\n", statistics.otherVariableTelegrams);
+#endif
+}
+
+static double cpuSeconds()
+{
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+int main(int argc, char** argv)
+{
+	bool rs485 = false;
+	unsigned long seconds = 0;
+	const char* pDevice = NULL;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--rs485") == 0)
+		{
+			rs485 = true;
+		}
+		else if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc)
+		{
+			seconds = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--quiet") == 0)
+		{
+			quiet = true;
+		}
+		else
+		{
+			pDevice = argv[i];
+		}
+	}
+
+	if (!pDevice)
+	{
+		fprintf(stderr, "usage: ValloxMonitor [--rs485] [--seconds s] [--quiet] device\n");
+		return 2;
+	}
+
+	ValloxPosixSerial port;
+	if (!port.open(pDevice, rs485))
+	{
+		perror(pDevice);
+		return 2;
+	}
+
+	ValloxSerial vallox;
+	port.attach(vallox);
+	vallox.setResynchronize(true);
+	vallox.setNonBlockingTransmit(true);
+	vallox.attachPropertyChanged(onPropertyChanged);
+
+	int epoll = epoll_create1(0);
+	struct epoll_event event;
+	memset(&event, 0, sizeof(event));
+	event.events = EPOLLIN;
+	epoll_ctl(epoll, EPOLL_CTL_ADD, port.getFd(), &event);
+
+	signal(SIGINT, onSignal);
+	signal(SIGTERM, onSignal);
+	signal(SIGUSR1, onReportSignal);
+
+	uint32_t wakeups = 0;
+	Clock::time_point start = Clock::now();
+	double startCpu = cpuSeconds();
+
+	while (running && (seconds == 0 || Clock::now() - start < std::chrono::seconds(seconds)))
+	{
+		int ready = epoll_wait(epoll, &event, 1, port.getTimeout());
+		if (ready > 0)
+		{
+			wakeup = Clock::now();
+			wakeups++;
+			if (!port.onReadable())
+			{
+				fprintf(stderr, "%s closed\n", pDevice);
+				break;
+			}
+		}
+		else if (ready == 0)
+		{
+			port.onTimeout();
+		}
+
+		if (reportRequested)
+		{
+			reportRequested = 0;
+			printStatistics(vallox.getStatistics());
+			vallox.resetStatistics();
+		}
+		fflush(stdout);
+	}
+
+	double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+	double cpu = cpuSeconds() - startCpu;
+	const ValloxStatistics& statistics = vallox.getStatistics();
+
+	fprintf(stderr, "%.1f s: %u wakeups %u changes %u skipped bytes, latency avg %.1f us max %.1f us, cpu %.3f s (%.2f%%)\n",
+		elapsed, wakeups, changes, statistics.skippedBytes,
+		changes ? totalLatencyUs / changes : 0.0, maxLatencyUs, cpu, elapsed > 0 ? 100.0 * cpu / elapsed : 0.0);
+	printStatistics(statistics);
+
+	close(epoll);
+	return 0;
+}
@@ -0,0 +1,439 @@
+// Replays recorded bus traffic through ValloxSerial and reports the decoded
+// property changes together with throughput and latency numbers.
+//
+// A capture is either a raw dump of the received bytes or a trace written by
+// ValloxTrace::dump(). Raw bytes are timed as if they arrived at 9600 baud,
+// traces keep their recorded timestamps. The bytes are handed to the library
+// in the chunks they were received in and the library clock follows the bus
+// time, so the event stream does not depend on the replay speed:
+//
+//   <bus time in ms> <property id> <value>
+//
+// By default the capture is replayed as fast as possible, with --realtime at
+// the recorded timing. The latency is measured from handing a chunk over to
+// the property change callback. With --golden the event stream is compared
+// against a file written by --events before, the exit code is 1 on a difference.
+// A library built with VALLOX_PROFILING prints the latency histograms of the
+// probed sections after every run, callbacks slower than --slow ns are counted.
+//
+// usage: ValloxReplay [--realtime] [--resynchronize] [--runs count] [--events file] [--golden file] [--slow ns] capture
+
+#include <ValloxSerial.h>
+#include <ValloxTrace.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef std::chrono::steady_clock Clock;
+
+// bytes which arrived together on the bus
+struct Chunk
+{
+	uint64_t timeUs;
+	size_t offset;
+	size_t length;
+};
+
+struct Capture
+{
+	std::vector<uint8_t> bytes;
+	std::vector<Chunk> chunks;
+	uint32_t droppedRecords;
+};
+
+// stream which only exposes the bytes released so far
+class ReplayStream : public Stream
+{
+public:
+	ReplayStream(const std::vector<uint8_t>& bytes) : m_Bytes(bytes)
+	{
+		m_Position = 0;
+		m_Released = 0;
+	}
+
+	void release(size_t end)
+	{
+		m_Released = end;
+	}
+
+	int available()
+	{
+		return (int)(m_Released - m_Position);
+	}
+
+	int read()
+	{
+		return m_Position < m_Released ? m_Bytes[m_Position++] : -1;
+	}
+
+	int peek()
+	{
+		return m_Position < m_Released ? m_Bytes[m_Position] : -1;
+	}
+
+	size_t write(uint8_t value)
+	{
+		return 1;
+	}
+
+private:
+	const std::vector<uint8_t>& m_Bytes;
+	size_t m_Position;
+	size_t m_Released;
+};
+
+class NullStream : public Stream
+{
+public:
+	int available() { return 0; }
+	int read() { return -1; }
+	int peek() { return -1; }
+	size_t write(uint8_t value) { return 1; }
+};
+
+static unsigned long busTimeMs = 0;
+static Clock::time_point chunkReleased;
+static std::vector<std::string>* pEvents = NULL;
+static double totalLatencyUs = 0;
+static double maxLatencyUs = 0;
+static size_t eventCount = 0;
+static size_t checksumFailures = 0;
+
+static unsigned long busClock()
+{
+	return busTimeMs;
+}
+
+static void onPropertyChanged(ValloxProperty propertyId, int8_t value)
+{
+	double latency = std::chrono::duration<double, std::micro>(Clock::now() - chunkReleased).count();
+	totalLatencyUs += latency;
+	maxLatencyUs = std::max(maxLatencyUs, latency);
+	eventCount++;
+
+	if (pEvents)
+	{
+		char line[32];
+		snprintf(line, sizeof(line), "%lu %d %d", busTimeMs, (int)propertyId, (int)value);
+		pEvents->push_back(line);
+	}
+}
+
+static void onTelegramChecksumFailure(uint8_t sender, uint8_t receiver, uint8_t command, uint8_t arg, uint8_t checksum)
+{
+	checksumFailures++;
+}
+
+static uint32_t readUint32(const uint8_t* pData)
+{
+	return (uint32_t)pData[0] | ((uint32_t)pData[1] << 8) | ((uint32_t)pData[2] << 16) | ((uint32_t)pData[3] << 24);
+}
+
+// raw dumps are handed over in telegram sized chunks, timed at 9600 baud
+static void parseRaw(const std::vector<uint8_t>& file, Capture* pCapture)
+{
+	pCapture->bytes = file;
+	for (size_t offset = 0; offset < file.size(); offset += VALLOX_LENGTH)
+	{
+		Chunk chunk;
+		chunk.offset = offset;
+		chunk.length = std::min((size_t)VALLOX_LENGTH, file.size() - offset);
+		chunk.timeUs = (uint64_t)(offset + chunk.length) * VALLOX_CHARACTER_TIME_US;
+		pCapture->chunks.push_back(chunk);
+	}
+}
+
+// received records of a trace, our own telegrams come back as received ones anyway
+static bool parseTrace(const std::vector<uint8_t>& file, Capture* pCapture)
+{
+	if (file[4] != VALLOX_TRACE_VERSION || file[5] != sizeof(ValloxTraceRecord))
+	{
+		fprintf(stderr, "unsupported trace version %u\n", file[4]);
+		return false;
+	}
+
+	size_t count = file[6] | (file[7] << 8);
+	if (file.size() < VALLOX_TRACE_HEADER_LENGTH + count * sizeof(ValloxTraceRecord))
+	{
+		fprintf(stderr, "trace truncated\n");
+		return false;
+	}
+
+	uint64_t timeUs = (uint64_t)readUint32(&file[8]) * 1000;
+	pCapture->droppedRecords = readUint32(&file[12]);
+
+	for (size_t i = 0; i < count; i++)
+	{
+		const uint8_t* pRecord = &file[VALLOX_TRACE_HEADER_LENGTH + i * sizeof(ValloxTraceRecord)];
+		uint8_t kind = pRecord[0] & VALLOX_TRACE_KIND_MASK;
+		const uint8_t* pData = pRecord + 2;
+
+		if (kind == TraceGap)
+		{
+			timeUs += (uint64_t)readUint32(pData) * 1000;
+			continue;
+		}
+		timeUs += (uint64_t)pRecord[1] * 1000;
+
+		if (pRecord[0] & VALLOX_TRACE_TRANSMITTED)
+		{
+			continue;
+		}
+
+		Chunk chunk;
+		chunk.timeUs = timeUs;
+		chunk.offset = pCapture->bytes.size();
+		chunk.length = kind == TraceStrayBytes ? (pRecord[0] & VALLOX_TRACE_COUNT_MASK) >> VALLOX_TRACE_COUNT_SHIFT : VALLOX_LENGTH;
+		pCapture->bytes.insert(pCapture->bytes.end(), pData, pData + chunk.length);
+		pCapture->chunks.push_back(chunk);
+	}
+
+	return true;
+}
+
+static bool loadCapture(const char* pPath, Capture* pCapture)
+{
+	std::ifstream input(pPath, std::ios::binary);
+	if (!input)
+	{
+		fprintf(stderr, "can not open %s\n", pPath);
+		return false;
+	}
+
+	std::vector<uint8_t> file((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+	pCapture->droppedRecords = 0;
+
+	if (file.size() >= VALLOX_TRACE_HEADER_LENGTH && memcmp(file.data(), "VXTR", 4) == 0)
+	{
+		return parseTrace(file, pCapture);
+	}
+
+	parseRaw(file, pCapture);
+	return true;
+}
+
+#if VALLOX_PROFILING
+static const char* SECTION_NAMES[ProfileSectionCount] =
+{
+	"receive", "telegram", "update property", "update bitfields", "update efficiencies",
+	"telegram callback", "property callback", "subscriber callback", "write callback"
+};
+
+// one line per section: count, average and maximum and the populated buckets as upper limit:count
+static void printProfile(const ValloxProfiler& profiler)
+{
+	for (uint8_t section = 0; section < ProfileSectionCount; section++)
+	{
+		const ValloxProfileHistogram& histogram = profiler.getHistogram((ValloxProfileSection)section);
+		if (histogram.count == 0)
+		{
+			continue;
+		}
+
+		printf("  %-20s %9u calls avg %8.1f ns max %8u ns |", SECTION_NAMES[section], histogram.count,
+			(double)histogram.totalTicks / histogram.count, histogram.maxTicks);
+		for (uint8_t bucket = 0; bucket < VALLOX_PROFILE_BUCKETS; bucket++)
+		{
+			if (histogram.buckets[bucket] != 0)
+			{
+				printf(" <%llu:%u", 1ULL << bucket, histogram.buckets[bucket]);
+			}
+		}
+		printf("\n");
+	}
+	printf("  %u slow callbacks\n", profiler.getSlowCallbacks());
+}
+#endif
+
+// returns the seconds spent in the library
+static double replay(const Capture& capture, bool realtime, bool resynchronize, uint32_t slowNs, uint32_t* pTelegrams, ValloxStatistics* pStatistics)
+{
+	ReplayStream rxStream(capture.bytes);
+	NullStream txStream;
+
+	ValloxSerial vallox;
+	vallox.setRxSerial(rxStream);
+	vallox.setTxSerial(txStream);
+	vallox.setResynchronize(resynchronize);
+	vallox.attachClock(busClock);
+	vallox.attachPropertyChanged(onPropertyChanged);
+	vallox.attach(onTelegramChecksumFailure);
+#if VALLOX_PROFILING
+	vallox.getProfiler().setSlowCallbackThreshold(slowNs);
+#endif
+
+	uint32_t telegrams = 0;
+	double seconds = 0;
+	Clock::time_point start = Clock::now();
+	uint64_t firstTimeUs = capture.chunks.empty() ? 0 : capture.chunks[0].timeUs;
+
+	for (size_t i = 0; i < capture.chunks.size(); i++)
+	{
+		const Chunk& chunk = capture.chunks[i];
+		if (realtime)
+		{
+			std::this_thread::sleep_until(start + std::chrono::microseconds(chunk.timeUs - firstTimeUs));
+		}
+
+		busTimeMs = (unsigned long)(chunk.timeUs / 1000);
+		rxStream.release(chunk.offset + chunk.length);
+
+		chunkReleased = Clock::now();
+		telegrams += vallox.receiveAll();
+		seconds += std::chrono::duration<double>(Clock::now() - chunkReleased).count();
+	}
+
+#if VALLOX_PROFILING
+	printProfile(vallox.getProfiler());
+#endif
+
+	*pTelegrams = telegrams;
+	*pStatistics = vallox.getStatistics();
+	return seconds;
+}
+
+static bool compareGolden(const char* pPath, const std::vector<std::string>& events)
+{
+	std::ifstream input(pPath);
+	if (!input)
+	{
+		fprintf(stderr, "can not open %s\n", pPath);
+		return false;
+	}
+
+	std::string line;
+	size_t index = 0;
+	while (std::getline(input, line))
+	{
+		if (index >= events.size())
+		{
+			printf("golden: event %zu missing, expected \"%s\"\n", index + 1, line.c_str());
+			return false;
+		}
+		if (line != events[index])
+		{
+			printf("golden: event %zu is \"%s\", expected \"%s\"\n", index + 1, events[index].c_str(), line.c_str());
+			return false;
+		}
+		index++;
+	}
+
+	if (index < events.size())
+	{
+		printf("golden: unexpected event %zu \"%s\"\n", index + 1, events[index].c_str());
+		return false;
+	}
+
+	printf("golden: %zu events match\n", events.size());
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	bool realtime = false;
+	bool resynchronize = false;
+	int runs = 1;
+	uint32_t slowNs = 0;
+	const char* pEventsPath = NULL;
+	const char* pGoldenPath = NULL;
+	const char* pCapturePath = NULL;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--realtime") == 0)
+		{
+			realtime = true;
+		}
+		else if (strcmp(argv[i], "--resynchronize") == 0)
+		{
+			resynchronize = true;
+		}
+		else if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc)
+		{
+			runs = std::max(1, atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "--events") == 0 && i + 1 < argc)
+		{
+			pEventsPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--golden") == 0 && i + 1 < argc)
+		{
+			pGoldenPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--slow") == 0 && i + 1 < argc)
+		{
+			slowNs = atoi(argv[++i]);
+		}
+		else
+		{
+			pCapturePath = argv[i];
+		}
+	}
+
+	if (!pCapturePath)
+	{
+		fprintf(stderr, "usage: ValloxReplay [--realtime] [--resynchronize] [--runs count] [--events file] [--golden file] [--slow ns] capture\n");
+		return 2;
+	}
+
+	Capture capture;
+	if (!loadCapture(pCapturePath, &capture))
+	{
+		return 2;
+	}
+
+	printf("%zu bytes in %zu chunks over %.3f s bus time", capture.bytes.size(), capture.chunks.size(),
+		capture.chunks.empty() ? 0.0 : (capture.chunks.back().timeUs - capture.chunks.front().timeUs) / 1e6);
+	if (capture.droppedRecords)
+	{
+		printf(", %u trace records were dropped before the dump", capture.droppedRecords);
+	}
+	printf("\n");
+
+	std::vector<std::string> events;
+	bool matches = true;
+
+	for (int run = 0; run < runs; run++)
+	{
+		// the event stream of the first run is the one to keep
+		pEvents = run == 0 ? &events : NULL;
+		totalLatencyUs = 0;
+		maxLatencyUs = 0;
+		eventCount = 0;
+		checksumFailures = 0;
+
+		uint32_t telegrams = 0;
+		ValloxStatistics statistics;
+		double seconds = replay(capture, realtime, resynchronize, slowNs, &telegrams, &statistics);
+
+		printf("run %d: %u telegrams %zu events %zu checksum failures %u skipped bytes, %.0f telegrams/s %.2f ns/byte, latency avg %.2f us max %.2f us\n",
+			run + 1, telegrams, eventCount, checksumFailures, statistics.skippedBytes,
+			seconds > 0 ? telegrams / seconds : 0.0,
+			capture.bytes.empty() ? 0.0 : seconds * 1e9 / capture.bytes.size(),
+			eventCount ? totalLatencyUs / eventCount : 0.0, maxLatencyUs);
+	}
+
+	if (pEventsPath)
+	{
+		std::ofstream output(pEventsPath);
+		for (size_t i = 0; i < events.size(); i++)
+		{
+			output << events[i] << '\n';
+		}
+	}
+
+	if (pGoldenPath)
+	{
+		matches = compareGolden(pGoldenPath, events);
+	}
+
+	return matches ? 0 : 1;
+}
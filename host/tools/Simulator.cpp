@@ -0,0 +1,341 @@
+// Load test of ValloxSerial against the virtual bus.
+//
+// The device under test listens as panel 1, sends as panel 8, keeps a few
+// properties fresh with the scheduler, polls a setting and changes the fan
+// speed with verified writes at the given intervals. The run takes the given
+// number of seconds of virtual time, which passes as fast as the host allows.
+// The report shows the loss of the traffic of the master, the success rate and
+// latency of the polls and writes and how often the device talked into other
+// traffic or into a suspension.
+//
+// With --capture the bytes the device received are written to a file, which
+// ValloxReplay takes as a raw capture.
+//
+// With --pty no device is simulated, the bus is served in real time on a
+// pseudo terminal instead, whose name is printed at the start, e.g. to test a
+// gateway against it.
+//
+// usage: ValloxSimulator [--seconds s] [--rate telegrams/s] [--noise p] [--bit-errors p] [--drops p]
+//                        [--suspend interval ms] [--polls interval ms] [--writes interval ms] [--lbt] [--seed n]
+//                        [--capture file] [--pty]
+
+#include <ValloxSerial.h>
+#include <ValloxBusSimulator.h>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <termios.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+typedef std::chrono::steady_clock Clock;
+
+// the device checks the bus every 250 us of virtual time
+const uint32_t STEP_US = 250;
+
+static ValloxBusSimulator* pBus = NULL;
+
+static uint32_t masterTelegrams = 0;
+static uint32_t polls = 0;
+static uint32_t rejectedPolls = 0;
+static uint32_t repliedPolls = 0;
+static uint32_t failedPolls = 0;
+static uint32_t totalPollLatency = 0;
+static uint16_t maxPollLatency = 0;
+static uint32_t writes = 0;
+static uint32_t confirmedWrites = 0;
+static uint32_t failedWrites = 0;
+static uint32_t totalWriteLatency = 0;
+static uint16_t maxWriteLatency = 0;
+
+static unsigned long busClock()
+{
+	return pBus->getTimeMs();
+}
+
+static bool onTelegramReceived(uint8_t sender, uint8_t receiver, uint8_t command, uint8_t arg)
+{
+	if (sender != VALLOX_ADDRESS_PANEL8)
+	{
+		masterTelegrams++;
+	}
+	return true;
+}
+
+static void onPollCompleted(void* pContext, uint8_t variable, bool replied, uint8_t value, uint16_t latencyMs)
+{
+	if (replied)
+	{
+		repliedPolls++;
+		totalPollLatency += latencyMs;
+		maxPollLatency = latencyMs > maxPollLatency ? latencyMs : maxPollLatency;
+	}
+	else
+	{
+		failedPolls++;
+	}
+}
+
+static void onWriteCompleted(void* pContext, uint8_t variable, bool confirmed, uint8_t value, uint16_t latencyMs)
+{
+	if (confirmed)
+	{
+		confirmedWrites++;
+		totalWriteLatency += latencyMs;
+		maxWriteLatency = latencyMs > maxWriteLatency ? latencyMs : maxWriteLatency;
+	}
+	else
+	{
+		failedWrites++;
+	}
+}
+
+static void printBusStatistics(const ValloxSimulatorStatistics& statistics)
+{
+	printf("bus: %u telegrams sent, %u suspensions, %u noise %u corrupted %u dropped bytes\n",
+		statistics.sentTelegrams, statistics.suspensions, statistics.noiseBytes, statistics.corruptedBytes, statistics.droppedBytes);
+	printf("master: %u telegrams received, %u polls answered, %u writes taken, %u collided bytes, %u telegrams while suspended\n",
+		statistics.receivedTelegrams, statistics.answeredPolls, statistics.acceptedWrites, statistics.collidedBytes, statistics.suspendedTelegrams);
+}
+
+static void simulate(ValloxBusSimulator& bus, uint32_t seconds, uint32_t pollInterval, uint32_t writeInterval, bool listenBeforeTalk)
+{
+	static const uint8_t POLLED[] =
+	{
+		VALLOX_VARIABLE_HEATING_SET_POINT, VALLOX_VARIABLE_FAN_SPEED_MAX, VALLOX_VARIABLE_FAN_SPEED_MIN, VALLOX_VARIABLE_HRC_BYPASS
+	};
+
+	ValloxSerial vallox;
+	vallox.setRxSerial(bus);
+	vallox.setTxSerial(bus);
+	vallox.setResynchronize(true);
+	vallox.setNonBlockingTransmit(true);
+	vallox.attachClock(busClock);
+	vallox.attach(onTelegramReceived);
+	vallox.setWriteMode(WriteVerified);
+	vallox.attachWriteCompleted(onWriteCompleted);
+	if (listenBeforeTalk)
+	{
+		vallox.setListenBeforeTalk(2, true);
+	}
+
+	vallox.schedule(FanSpeedProperty);
+	vallox.schedule(TempInsideProperty);
+	vallox.schedule(HeatingSetPointProperty);
+	vallox.schedule(PowerStateProperty);
+
+	unsigned long nextPoll = pollInterval;
+	unsigned long nextWrite = writeInterval;
+	uint8_t fanSpeed = 2;
+
+	Clock::time_point start = Clock::now();
+	while (bus.getTimeMs() < seconds * 1000UL)
+	{
+		bus.advance(STEP_US);
+		vallox.receiveAll();
+
+		unsigned long now = bus.getTimeMs();
+		if (pollInterval != 0 && now >= nextPoll)
+		{
+			if (vallox.pollVariable(POLLED[polls % sizeof(POLLED)], onPollCompleted))
+			{
+				polls++;
+			}
+			else
+			{
+				rejectedPolls++;
+			}
+			nextPoll += pollInterval;
+		}
+		if (writeInterval != 0 && now >= nextWrite)
+		{
+			vallox.setFanSpeed(fanSpeed);
+			fanSpeed = fanSpeed == 2 ? 5 : 2;
+			writes++;
+			nextWrite += writeInterval;
+		}
+	}
+	double wallSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+	const ValloxSimulatorStatistics& busStatistics = bus.getStatistics();
+	const ValloxStatistics& statistics = vallox.getStatistics();
+
+	printf("%u s virtual time in %.3f s, %.0fx real time\n", seconds, wallSeconds, wallSeconds > 0 ? seconds / wallSeconds : 0.0);
+	printBusStatistics(busStatistics);
+	printf("device: %u of %u telegrams of the master received, %.2f%% loss, %u skipped bytes\n",
+		masterTelegrams, busStatistics.sentTelegrams,
+		busStatistics.sentTelegrams ? 100.0 * (busStatistics.sentTelegrams - std::min(masterTelegrams, busStatistics.sentTelegrams)) / busStatistics.sentTelegrams : 0.0,
+		statistics.skippedBytes);
+	printf("device: %u telegrams %u checksum failures %u unexpected bytes received, peak %u bytes/s\n",
+		statistics.receivedTelegrams, statistics.checksumFailures, statistics.unexpectedBytes, statistics.peakBytesPerSecond);
+	printf("device: %u sent %u deferred %u collisions %u retransmitted %u dropped telegrams\n",
+		statistics.transmittedTelegrams, statistics.deferredTelegrams, statistics.collisions, statistics.retransmittedTelegrams, statistics.droppedTelegrams);
+	printf("device: %u suspensions, longest %u ms, %u missed resumes\n",
+		statistics.suspensions, statistics.longestSuspensionMs, statistics.missedResumes);
+	printf("polls: %u sent %u rejected, %u replied %u failed (%.1f%%), latency avg %.1f ms max %u ms\n",
+		polls, rejectedPolls, repliedPolls, failedPolls, polls ? 100.0 * repliedPolls / polls : 0.0,
+		repliedPolls ? (double)totalPollLatency / repliedPolls : 0.0, maxPollLatency);
+	printf("writes: %u sent, %u confirmed %u failed (%.1f%%), latency avg %.1f ms max %u ms\n",
+		writes, confirmedWrites, failedWrites, writes ? 100.0 * confirmedWrites / writes : 0.0,
+		confirmedWrites ? (double)totalWriteLatency / confirmedWrites : 0.0, maxWriteLatency);
+}
+
+// the bus in real time on the master side of a pseudo terminal
+static int servePty(ValloxBusSimulator& bus, uint32_t seconds)
+{
+	int pty = posix_openpt(O_RDWR | O_NOCTTY);
+	if (pty < 0 || grantpt(pty) != 0 || unlockpt(pty) != 0)
+	{
+		perror("pseudo terminal");
+		return 2;
+	}
+	fcntl(pty, F_SETFL, fcntl(pty, F_GETFL) | O_NONBLOCK);
+
+	// raw mode without echo, the other side is kept open so that reads do not fail until it is opened
+	int terminal = open(ptsname(pty), O_RDWR | O_NOCTTY);
+	struct termios settings;
+	if (terminal < 0 || tcgetattr(terminal, &settings) != 0)
+	{
+		perror("pseudo terminal");
+		return 2;
+	}
+	cfmakeraw(&settings);
+	tcsetattr(terminal, TCSANOW, &settings);
+
+	printf("serving the bus on %s\n", ptsname(pty));
+	fflush(stdout);
+
+	Clock::time_point start = Clock::now();
+	uint64_t elapsedUs = 0;
+	while (seconds == 0 || elapsedUs < seconds * 1000000ULL)
+	{
+		std::this_thread::sleep_for(std::chrono::microseconds(STEP_US));
+		uint64_t nowUs = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count();
+		bus.advance((uint32_t)(nowUs - elapsedUs));
+		elapsedUs = nowUs;
+
+		uint8_t buffer[64];
+		ssize_t length;
+		while ((length = ::read(pty, buffer, sizeof(buffer))) > 0)
+		{
+			bus.write(buffer, length);
+		}
+
+		size_t count = 0;
+		while (bus.available() && count < sizeof(buffer))
+		{
+			buffer[count++] = (uint8_t)bus.read();
+		}
+		if (count > 0 && ::write(pty, buffer, count) < 0)
+		{
+			// nobody has opened the other side yet, the bytes are lost like on an open bus
+		}
+	}
+
+	printBusStatistics(bus.getStatistics());
+	close(terminal);
+	close(pty);
+	return 0;
+}
+
+int main(int argc, char** argv)
+{
+	ValloxSimulatorConfig config;
+	uint32_t seconds = 600;
+	uint32_t pollInterval = 1000;
+	uint32_t writeInterval = 5000;
+	bool listenBeforeTalk = false;
+	bool pty = false;
+	const char* pCapturePath = NULL;
+
+	for (int i = 1; i < argc; i++)
+	{
+		bool hasValue = i + 1 < argc;
+		if (strcmp(argv[i], "--seconds") == 0 && hasValue)
+		{
+			seconds = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--rate") == 0 && hasValue)
+		{
+			config.telegramsPerSecond = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--noise") == 0 && hasValue)
+		{
+			config.noiseProbability = atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--bit-errors") == 0 && hasValue)
+		{
+			config.bitErrorProbability = atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--drops") == 0 && hasValue)
+		{
+			config.dropProbability = atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--suspend") == 0 && hasValue)
+		{
+			config.suspendIntervalMs = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--polls") == 0 && hasValue)
+		{
+			pollInterval = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--writes") == 0 && hasValue)
+		{
+			writeInterval = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--seed") == 0 && hasValue)
+		{
+			config.seed = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--lbt") == 0)
+		{
+			listenBeforeTalk = true;
+		}
+		else if (strcmp(argv[i], "--capture") == 0 && hasValue)
+		{
+			pCapturePath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--pty") == 0)
+		{
+			pty = true;
+		}
+		else
+		{
+			fprintf(stderr, "usage: ValloxSimulator [--seconds s] [--rate telegrams/s] [--noise p] [--bit-errors p] [--drops p]\n"
+				"                       [--suspend interval ms] [--polls interval ms] [--writes interval ms] [--lbt] [--seed n]\n"
+				"                       [--capture file] [--pty]\n");
+			return 2;
+		}
+	}
+
+	ValloxBusSimulator bus(config);
+	pBus = &bus;
+
+	if (pty)
+	{
+		return servePty(bus, seconds);
+	}
+
+	std::vector<uint8_t> capture;
+	if (pCapturePath)
+	{
+		bus.record(&capture);
+	}
+
+	simulate(bus, seconds, pollInterval, writeInterval, listenBeforeTalk);
+
+	if (pCapturePath)
+	{
+		FILE* pFile = fopen(pCapturePath, "wb");
+		if (!pFile || fwrite(capture.data(), 1, capture.size(), pFile) != capture.size() || fclose(pFile) != 0)
+		{
+			perror(pCapturePath);
+			return 2;
+		}
+	}
+	return 0;
+}
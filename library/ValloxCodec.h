@@ -0,0 +1,167 @@
+// Conversion between raw telegram values and physical units.
+//
+// Temperatures are encoded as NTC sensor codes. The code to temperature table
+// is taken from the protocol description, the inverse table is generated from
+// it at compile time, so both directions are a single table lookup. Both
+// tables are placed in flash on AVR.
+//
+// Fan speeds are encoded as a bitmap with one bit per speed (0x01..0xFF), so
+// the speed is the population count of a valid bitmap.
+
+#ifndef ValloxCodec_h
+#define ValloxCodec_h
+
+#include <ValloxPlatform.h>
+
+static constexpr int8_t VALLOX_TEMPERATURE_MAPPING[256] PROGMEM =
+{
+	-74, -70, -66, -62, -59, -56, -54, -52,
+	-50, -48, -47, -46, -44, -43, -42, -41,
+	-40, -39, -38, -37, -36, -35, -34, -33,
+	-33, -32, -31, -30, -30, -29, -28, -28,
+	-27, -27, -26, -25, -25, -24, -24, -23,
+	-23, -22, -22, -21, -21, -20, -20, -19,
+	-19, -19, -18, -18, -17, -17, -16, -16,
+	-16, -15, -15, -14, -14, -14, -13, -13,
+	-12, -12, -12, -11, -11, -11, -10, -10,
+	-9,  -9,  -9,  -8,  -8,  -8,  -7,  -7,
+	-7,  -6,  -6,  -6,  -5,  -5,  -5,  -4,
+	-4,  -4,  -3,  -3,  -3,  -2,  -2,  -2,
+	-1,  -1,  -1,  -1,  0,   0,   0,   1,
+	1,   1,   2,   2,   2,   3,   3,   3,
+	4,   4,   4,   5,   5,   5,   5,   6,
+	6,   6,   7,   7,   7,   8,   8,   8,
+	9,   9,   9,   10,  10,  10,  11,  11,
+	11,  12,  12,  12,  13,  13,  13,  14,
+	14,  14,  15,  15,  15,  16,  16,  16,
+	17,  17,  18,  18,  18,  19,  19,  19,
+	20,  20,  21,  21,  21,  22,  22,  22,
+	23,  23,  24,  24,  24,  25,  25,  26,
+	26,  27,  27,  27,  28,  28,  29,  29,
+	30,  30,  31,  31,  32,  32,  33,  33,
+	34,  34,  35,  35,  36,  36,  37,  37,
+	38,  38,  39,  40,  40,  41,  41,  42,
+	43,  43,  44,  45,  45,  46,  47,  48,
+	49,  49,  50,  51,  52,  53,  53,  54,
+	55,  56,  57,  59,  60,  61,  62,  63,
+	65,  66,  68,  69,  71,  73,  75,  77,
+	79,  81,  82,  86,  90,  93,  97,  100,
+	100, 100, 100, 100, 100, 100, 100, 100
+};
+
+static constexpr uint8_t VALLOX_FAN_SPEED_MAPPING[8] PROGMEM =
+{
+	0x01,
+	0x03,
+	0x07,
+	0x0F,
+	0x1F,
+	0x3F,
+	0x7F,
+	0xFF
+};
+
+// the first code whose temperature is not below the given one, 100 if none is
+constexpr uint8_t valloxFindTemperatureCode(int temperature, uint8_t code)
+{
+	return code == 255 ? 100 :
+		VALLOX_TEMPERATURE_MAPPING[code] >= temperature ? code :
+		valloxFindTemperatureCode(temperature, code + 1);
+}
+
+// compile time index list 0..N-1 to expand the inverse table from
+template<uint8_t... Indices> struct ValloxIndexSequence {};
+
+template<uint16_t Count, uint8_t... Indices>
+struct ValloxMakeIndexSequence : ValloxMakeIndexSequence<Count - 1, Count - 1, Indices...> {};
+
+template<uint8_t... Indices>
+struct ValloxMakeIndexSequence<0, Indices...>
+{
+	typedef ValloxIndexSequence<Indices...> Type;
+};
+
+// indexed by temperature + 128
+template<typename Sequence> struct ValloxInverseTemperatureMapping;
+
+template<uint8_t... Indices>
+struct ValloxInverseTemperatureMapping<ValloxIndexSequence<Indices...> >
+{
+	static constexpr uint8_t CODES[sizeof...(Indices)] PROGMEM =
+	{
+		valloxFindTemperatureCode((int)Indices - 128, 0)...
+	};
+};
+
+template<uint8_t... Indices>
+constexpr uint8_t ValloxInverseTemperatureMapping<ValloxIndexSequence<Indices...> >::CODES[sizeof...(Indices)];
+
+typedef ValloxInverseTemperatureMapping<ValloxMakeIndexSequence<256>::Type> ValloxInverseTemperatures;
+
+class ValloxCodec
+{
+public:
+	// NTC code --> degrees celsius
+	static int8_t decodeTemperature(uint8_t code)
+	{
+		return (int8_t)pgm_read_byte(&VALLOX_TEMPERATURE_MAPPING[code]);
+	}
+
+	// degrees celsius --> NTC code
+	static uint8_t encodeTemperature(int8_t temperature)
+	{
+		return pgm_read_byte(&ValloxInverseTemperatures::CODES[(uint8_t)(temperature + 128)]);
+	}
+
+	// branch free population count
+	static constexpr uint8_t countBits(uint8_t value)
+	{
+		return addNibbles(addPairs(addBits(value)));
+	}
+
+	// 0xFF --> 8, 0 for bitmaps which are not a valid fan speed
+	static constexpr uint8_t decodeFanSpeed(uint8_t value)
+	{
+		return countBits(value) * (uint8_t)(((value & (value + 1)) & 0xFF) == 0);
+	}
+
+	// 8 --> 0xFF, speeds above 8 are limited to 8
+	static constexpr uint8_t encodeFanSpeed(uint8_t speed)
+	{
+		return (uint8_t)(0xFF >> (8 - (speed > 8 ? 8 : speed)));
+	}
+
+	// 0x33 --> 0% 0xFF --> 100%, (x-51)/2.04 rounded with 25/51 ~ 251/512
+	static constexpr uint8_t decodeHumidity(uint8_t value)
+	{
+		return (uint8_t)(((uint16_t)(value > 51 ? value - 51 : 0) * 251 + 256) >> 9);
+	}
+
+private:
+	static constexpr uint8_t addBits(uint8_t value)
+	{
+		return (uint8_t)(value - ((value >> 1) & 0x55));
+	}
+
+	static constexpr uint8_t addPairs(uint8_t value)
+	{
+		return (uint8_t)((value & 0x33) + ((value >> 2) & 0x33));
+	}
+
+	static constexpr uint8_t addNibbles(uint8_t value)
+	{
+		return (uint8_t)((value + (value >> 4)) & 0x0F);
+	}
+};
+
+static_assert(ValloxCodec::decodeFanSpeed(0x00) == 0, "fan speed decoder");
+static_assert(ValloxCodec::decodeFanSpeed(0x01) == 1, "fan speed decoder");
+static_assert(ValloxCodec::decodeFanSpeed(0x3F) == 6, "fan speed decoder");
+static_assert(ValloxCodec::decodeFanSpeed(0xFF) == 8, "fan speed decoder");
+static_assert(ValloxCodec::decodeFanSpeed(0x05) == 0, "fan speed decoder");
+static_assert(ValloxCodec::encodeFanSpeed(1) == VALLOX_FAN_SPEED_MAPPING[0], "fan speed encoder");
+static_assert(ValloxCodec::encodeFanSpeed(8) == VALLOX_FAN_SPEED_MAPPING[7], "fan speed encoder");
+static_assert(ValloxCodec::decodeHumidity(0x33) == 0, "humidity decoder");
+static_assert(ValloxCodec::decodeHumidity(0xFF) == 100, "humidity decoder");
+
+#endif // ValloxCodec_h
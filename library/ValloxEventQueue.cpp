@@ -0,0 +1,67 @@
+#include <ValloxEventQueue.h>
+
+#define VALLOX_EVENT_QUEUE_MASK (VALLOX_EVENT_QUEUE_SIZE - 1)
+
+// the indices run over 0..255 and are masked on access, so head - tail is the size even when full
+ValloxEventQueue::ValloxEventQueue()
+{
+	m_Head = 0;
+	m_Tail = 0;
+	m_Overflows = 0;
+}
+
+bool ValloxEventQueue::push(ValloxProperty propertyId, int8_t previousValue, int8_t value, uint32_t time)
+{
+	uint8_t head = m_Head;
+	uint8_t tail = __atomic_load_n(&m_Tail, __ATOMIC_ACQUIRE);
+	if ((uint8_t)(head - tail) >= VALLOX_EVENT_QUEUE_SIZE)
+	{
+		// only the producer counts, 32 bit atomics are not available on the AVR
+#ifdef __AVR__
+		m_Overflows++;
+#else
+		__atomic_store_n(&m_Overflows, __atomic_load_n(&m_Overflows, __ATOMIC_RELAXED) + 1, __ATOMIC_RELAXED);
+#endif
+		return false;
+	}
+
+	ValloxEvent& event = m_Events[head & VALLOX_EVENT_QUEUE_MASK];
+	event.time = time;
+	event.property = (uint8_t)propertyId;
+	event.previousValue = previousValue;
+	event.value = value;
+
+	// publishes the event to the consumer
+	__atomic_store_n(&m_Head, (uint8_t)(head + 1), __ATOMIC_RELEASE);
+	return true;
+}
+
+bool ValloxEventQueue::pop(ValloxEvent* pEvent)
+{
+	uint8_t tail = m_Tail;
+	uint8_t head = __atomic_load_n(&m_Head, __ATOMIC_ACQUIRE);
+	if (head == tail)
+	{
+		return false;
+	}
+
+	*pEvent = m_Events[tail & VALLOX_EVENT_QUEUE_MASK];
+
+	// hands the slot back to the producer
+	__atomic_store_n(&m_Tail, (uint8_t)(tail + 1), __ATOMIC_RELEASE);
+	return true;
+}
+
+uint8_t ValloxEventQueue::size() const
+{
+	return (uint8_t)(__atomic_load_n(&m_Head, __ATOMIC_ACQUIRE) - __atomic_load_n(&m_Tail, __ATOMIC_ACQUIRE));
+}
+
+uint32_t ValloxEventQueue::getOverflows() const
+{
+#ifdef __AVR__
+	return m_Overflows;
+#else
+	return __atomic_load_n(&m_Overflows, __ATOMIC_RELAXED);
+#endif
+}
@@ -0,0 +1,50 @@
+// Queue of property changes to be fetched by the application.
+//
+// Instead of being called back from within receive(), the application takes
+// the changes out of the queue whenever it suits, from loop() or from another
+// thread. The decoder is the only producer and the application the only
+// consumer, so the ring needs no lock: each side only moves its own index.
+// When the queue is full new changes are dropped and counted, the decoder never
+// waits for the application.
+
+#ifndef ValloxEventQueue_h
+#define ValloxEventQueue_h
+
+#include <ValloxProperty.h>
+#include <inttypes.h>
+
+// number of events, a power of two up to 128 as the indices are kept in a byte
+#ifndef VALLOX_EVENT_QUEUE_SIZE
+#define VALLOX_EVENT_QUEUE_SIZE 16
+#endif
+
+static_assert(VALLOX_EVENT_QUEUE_SIZE >= 2 && VALLOX_EVENT_QUEUE_SIZE <= 128 &&
+	(VALLOX_EVENT_QUEUE_SIZE & (VALLOX_EVENT_QUEUE_SIZE - 1)) == 0, "VALLOX_EVENT_QUEUE_SIZE must be a power of two from 2 to 128");
+
+struct ValloxEvent
+{
+	uint32_t time;			// ms of the clock, 0 without a clock
+	uint8_t property;		// ValloxProperty
+	int8_t previousValue;
+	int8_t value;
+};
+
+class ValloxEventQueue
+{
+public:
+	ValloxEventQueue();
+
+	bool push(ValloxProperty propertyId, int8_t previousValue, int8_t value, uint32_t time);	// producer, false if the queue is full
+	bool pop(ValloxEvent* pEvent);		// consumer, false if the queue is empty
+
+	uint8_t size() const;
+	uint32_t getOverflows() const;		// events dropped as the queue was full
+
+private:
+	ValloxEvent m_Events[VALLOX_EVENT_QUEUE_SIZE];
+	uint8_t m_Head;			// next event to write, moved by the producer
+	uint8_t m_Tail;			// next event to read, moved by the consumer
+	uint32_t m_Overflows;
+};
+
+#endif // ValloxEventQueue_h
@@ -0,0 +1,529 @@
+#include <ValloxMetrics.h>
+#include <ValloxPlatform.h>
+#include <stddef.h>
+
+const uint8_t VALLOX_PROPERTY_WIDTH = 4;		// sign and 3 digits
+const uint8_t VALLOX_COUNTER_WIDTH = 10;		// 4294967295
+
+// metric labels of the properties by compact index, separated by \0
+static const char VALLOX_PROPERTY_NAMES[] PROGMEM =
+	// integer properties
+	"fan_speed\0"
+	"temp_inside\0"
+	"temp_outside\0"
+	"temp_exhaust\0"
+	"temp_incomming\0"
+	"humidity\0"
+	"basic_humidity_level\0"
+	"humidity_sensor1\0"
+	"humidity_sensor2\0"
+	"co2_high\0"
+	"co2_low\0"
+	"co2_set_point_high\0"
+	"co2_set_point_low\0"
+	"fan_speed_max\0"
+	"fan_speed_min\0"
+	"dc_fan_input_adjustment\0"
+	"dc_fan_output_adjustment\0"
+	"input_fan_stop_threshold\0"
+	"heating_set_point\0"
+	"pre_heating_set_point\0"
+	"hrc_bypass_threshold\0"
+	"cell_defrosting_threshold\0"
+	"adjustment_interval_minutes\0"
+	"service_reminder\0"
+	"incomming_current\0"
+	"last_error_number\0"
+	"in_efficiency\0"
+	"out_efficiency\0"
+	"average_efficiency\0"
+	"select_status\0"
+
+	// boolean properties
+	"power_state\0"
+	"co2_adjust_state\0"
+	"humidity_adjust_state\0"
+	"heating_state\0"
+	"filter_guard_indicator\0"
+	"heating_indicator\0"
+	"fault_indicator\0"
+	"service_reminder_indicator\0"
+	"automatic_humidity_level_seeker_state\0"
+	"boost_switch_mode\0"
+	"radiator_type\0"
+	"cascade_adjust\0"
+	"max_speed_limit_mode\0"
+	"post_heating_on\0"
+	"damper_motor_position\0"
+	"fault_signal_relay\0"
+	"supply_fan_off\0"
+	"pre_heating_on\0"
+	"exhaust_fan_off\0"
+	"fire_place_booster_on";
+
+// metric names of the statistics, in the order of VALLOX_STATISTIC_FIELDS
+static const char VALLOX_STATISTIC_NAMES[] PROGMEM =
+	"received_bytes\0"
+	"received_telegrams\0"
+	"checksum_failures\0"
+	"unexpected_bytes\0"
+	"skipped_bytes\0"
+	"recovered_telegrams\0"
+	"transmitted_telegrams\0"
+	"deferred_telegrams\0"
+	"collisions\0"
+	"retransmitted_telegrams\0"
+	"dropped_telegrams\0"
+	"queued_writes\0"
+	"coalesced_writes\0"
+	"dropped_writes\0"
+	"suspensions\0"
+	"suspended_milliseconds\0"
+	"missed_resumes\0"
+	"bytes_per_second\0"
+	"peak_bytes_per_second\0"
+	"longest_suspension_milliseconds";
+
+const uint8_t VALLOX_METRIC_GAUGE = 0x01;
+const uint8_t VALLOX_METRIC_16BIT = 0x02;
+
+struct ValloxStatisticField
+{
+	uint16_t offset;		// in ValloxStatistics
+	uint8_t flags;
+};
+
+static const ValloxStatisticField VALLOX_STATISTIC_FIELDS[VALLOX_METRIC_STATISTICS] PROGMEM =
+{
+	{ offsetof(ValloxStatistics, receivedBytes), 0 },
+	{ offsetof(ValloxStatistics, receivedTelegrams), 0 },
+	{ offsetof(ValloxStatistics, checksumFailures), 0 },
+	{ offsetof(ValloxStatistics, unexpectedBytes), 0 },
+	{ offsetof(ValloxStatistics, skippedBytes), 0 },
+	{ offsetof(ValloxStatistics, recoveredTelegrams), 0 },
+	{ offsetof(ValloxStatistics, transmittedTelegrams), 0 },
+	{ offsetof(ValloxStatistics, deferredTelegrams), 0 },
+	{ offsetof(ValloxStatistics, collisions), 0 },
+	{ offsetof(ValloxStatistics, retransmittedTelegrams), 0 },
+	{ offsetof(ValloxStatistics, droppedTelegrams), 0 },
+	{ offsetof(ValloxStatistics, queuedWrites), 0 },
+	{ offsetof(ValloxStatistics, coalescedWrites), 0 },
+	{ offsetof(ValloxStatistics, droppedWrites), 0 },
+	{ offsetof(ValloxStatistics, suspensions), 0 },
+	{ offsetof(ValloxStatistics, suspendedMs), 0 },
+	{ offsetof(ValloxStatistics, missedResumes), 0 },
+	{ offsetof(ValloxStatistics, bytesPerSecond), VALLOX_METRIC_GAUGE | VALLOX_METRIC_16BIT },
+	{ offsetof(ValloxStatistics, peakBytesPerSecond), VALLOX_METRIC_GAUGE | VALLOX_METRIC_16BIT },
+	{ offsetof(ValloxStatistics, longestSuspensionMs), VALLOX_METRIC_GAUGE }
+};
+
+static uint32_t readStatistic(const ValloxStatistics& statistics, uint8_t index)
+{
+	ValloxStatisticField field;
+	memcpy_P(&field, &VALLOX_STATISTIC_FIELDS[index], sizeof(field));
+
+	const uint8_t* pField = (const uint8_t*)&statistics + field.offset;
+	if (field.flags & VALLOX_METRIC_16BIT)
+	{
+		uint16_t value;
+		memcpy(&value, pField, sizeof(value));
+		return value;
+	}
+
+	uint32_t value;
+	memcpy(&value, pField, sizeof(value));
+	return value;
+}
+
+// start of the index-th name in a \0 separated list
+static const char* findName(const char* pNames, uint8_t index)
+{
+	while (index > 0)
+	{
+		if (pgm_read_byte(pNames++) == '\0')
+		{
+			index--;
+		}
+	}
+	return pNames;
+}
+
+// the buckets of the histogram are cumulative, the last field is the count
+static uint32_t cumulativeGaps(const ValloxStatistics& statistics, uint8_t field)
+{
+	uint32_t sum = 0;
+	for (uint8_t bucket = 0; bucket <= field && bucket < VALLOX_GAP_BUCKETS; bucket++)
+	{
+		sum += statistics.gaps[bucket];
+	}
+	return sum;
+}
+
+ValloxMetrics::ValloxMetrics(char* pBuffer, uint16_t size)
+{
+	m_pBuffer = pBuffer;
+	m_Size = size;
+	m_Length = 0;
+	m_Built = false;
+	m_PatchedFields = 0;
+}
+
+uint16_t ValloxMetrics::render(const ValloxPropertyStore& properties, const ValloxStatistics& statistics)
+{
+	m_PatchedFields = 0;
+
+	if (!m_Built || isLayoutChanged(properties, statistics))
+	{
+		m_Built = build(properties, statistics);
+		if (!m_Built)
+		{
+			m_Length = 0;
+			return 0;
+		}
+		update(properties, statistics, true);
+	}
+	else
+	{
+		update(properties, statistics, false);
+	}
+
+	return m_Length;
+}
+
+void ValloxMetrics::invalidate()
+{
+	m_Built = false;
+}
+
+const char* ValloxMetrics::getText() const
+{
+	return m_pBuffer;
+}
+
+uint16_t ValloxMetrics::getLength() const
+{
+	return m_Length;
+}
+
+uint16_t ValloxMetrics::getPatchedFields() const
+{
+	return m_PatchedFields;
+}
+
+bool ValloxMetrics::getPropertyName(ValloxProperty propertyId, char* pName, uint8_t size)
+{
+	uint8_t index = ValloxPropertyStore::indexOf(propertyId);
+	if (index == VALLOX_NO_INDEX || size == 0)
+	{
+		return false;
+	}
+
+	const char* pSource = findName(VALLOX_PROPERTY_NAMES, index);
+	uint8_t length = 0;
+	char c;
+	while ((c = pgm_read_byte(pSource++)) != '\0' && length < size - 1)
+	{
+		pName[length++] = c;
+	}
+	pName[length] = '\0';
+	return c == '\0';
+}
+
+// lays out the text with empty value fields and remembers where they are
+bool ValloxMetrics::build(const ValloxPropertyStore& properties, const ValloxStatistics& statistics)
+{
+	m_Length = 0;
+	m_KnownProperties.clear();
+
+	bool fits = append("# TYPE vallox_property gauge\n");
+	for (uint8_t index = 0; index < VALLOX_PROPERTY_COUNT && fits; index++)
+	{
+		if (!properties.isKnown(index))
+		{
+			continue;
+		}
+		m_KnownProperties.set(index);
+		fits = append("vallox_property{property=\"") && appendName(VALLOX_PROPERTY_NAMES, index) && append("\"} ") &&
+			appendField(&m_PropertyOffsets[index], VALLOX_PROPERTY_WIDTH);
+	}
+
+	for (uint8_t index = 0; index < VALLOX_METRIC_STATISTICS && fits; index++)
+	{
+		ValloxStatisticField field;
+		memcpy_P(&field, &VALLOX_STATISTIC_FIELDS[index], sizeof(field));
+		bool gauge = (field.flags & VALLOX_METRIC_GAUGE) != 0;
+
+		fits = append("# TYPE vallox_") && appendName(VALLOX_STATISTIC_NAMES, index) && append(gauge ? " gauge\n" : " counter\n") &&
+			append("vallox_") && appendName(VALLOX_STATISTIC_NAMES, index) && append(gauge ? " " : "_total ") &&
+			appendField(&m_StatisticOffsets[index], VALLOX_COUNTER_WIDTH);
+	}
+
+	fits = fits && append("# TYPE vallox_telegram_gap_seconds histogram\n");
+	uint32_t limit = VALLOX_GAP_FIRST_LIMIT_MS;
+	for (uint8_t bucket = 0; bucket < VALLOX_GAP_BUCKETS && fits; bucket++, limit <<= 1)
+	{
+		fits = append("vallox_telegram_gap_seconds_bucket{le=\"");
+		if (bucket < VALLOX_GAP_BUCKETS - 1)
+		{
+			char millis[5] = { '.', (char)('0' + limit % 1000 / 100), (char)('0' + limit % 100 / 10), (char)('0' + limit % 10), '\0' };
+			fits = fits && appendUnsigned(limit / 1000) && append(millis);
+		}
+		else
+		{
+			fits = fits && append("+Inf");
+		}
+		fits = fits && append("\"} ") && appendField(&m_GapOffsets[bucket], VALLOX_COUNTER_WIDTH);
+	}
+	fits = fits && append("vallox_telegram_gap_seconds_count ") && appendField(&m_GapOffsets[VALLOX_GAP_BUCKETS], VALLOX_COUNTER_WIDTH);
+
+#if VALLOX_STATISTICS_TABLES
+	fits = fits && append("# TYPE vallox_pair_telegrams counter\n");
+	for (uint8_t pair = 0; pair <= VALLOX_STATISTICS_PAIRS && fits; pair++)
+	{
+		const ValloxPairStatistics& entry = statistics.pairs[pair < VALLOX_STATISTICS_PAIRS ? pair : 0];
+		if (pair == VALLOX_STATISTICS_PAIRS)
+		{
+			fits = append("vallox_pair_telegrams_total{sender=\"other\",receiver=\"other\"} ");
+		}
+		else if (entry.telegrams != 0)
+		{
+			fits = append("vallox_pair_telegrams_total{sender=\"") && appendHex(entry.sender) &&
+				append("\",receiver=\"") && appendHex(entry.receiver) && append("\"} ");
+		}
+		else
+		{
+			continue;
+		}
+		fits = fits && appendField(&m_PairOffsets[pair], VALLOX_COUNTER_WIDTH);
+	}
+
+	fits = fits && append("# TYPE vallox_variable_telegrams counter\n");
+	for (uint8_t entry = 0; entry <= VALLOX_STATISTICS_VARIABLES && fits; entry++)
+	{
+		if (entry == VALLOX_STATISTICS_VARIABLES)
+		{
+			fits = append("vallox_variable_telegrams_total{variable=\"other\"} ");
+		}
+		else if (statistics.variables[entry].telegrams != 0)
+		{
+			fits = append("vallox_variable_telegrams_total{variable=\"") && appendHex(statistics.variables[entry].variable) && append("\"} ");
+		}
+		else
+		{
+			continue;
+		}
+		fits = fits && appendField(&m_VariableOffsets[entry], VALLOX_COUNTER_WIDTH);
+	}
+#endif
+
+	return fits && append("# EOF\n");
+}
+
+// writes the fields whose value differs from the last render, all of them after a build
+void ValloxMetrics::update(const ValloxPropertyStore& properties, const ValloxStatistics& statistics, bool all)
+{
+	for (uint8_t index = 0; m_KnownProperties.next(&index); index++)
+	{
+		int8_t value = properties.get(index);
+		if (all || value != m_Properties[index])
+		{
+			m_Properties[index] = value;
+			writeField(m_PropertyOffsets[index], VALLOX_PROPERTY_WIDTH, value < 0 ? -(int16_t)value : value, value < 0);
+		}
+	}
+
+	for (uint8_t index = 0; index < VALLOX_METRIC_STATISTICS; index++)
+	{
+		uint32_t value = readStatistic(statistics, index);
+		if (all || value != m_Statistics[index])
+		{
+			m_Statistics[index] = value;
+			writeField(m_StatisticOffsets[index], VALLOX_COUNTER_WIDTH, value, false);
+		}
+	}
+
+	for (uint8_t field = 0; field < VALLOX_METRIC_GAPS; field++)
+	{
+		uint32_t value = cumulativeGaps(statistics, field);
+		if (all || value != m_Gaps[field])
+		{
+			m_Gaps[field] = value;
+			writeField(m_GapOffsets[field], VALLOX_COUNTER_WIDTH, value, false);
+		}
+	}
+
+#if VALLOX_STATISTICS_TABLES
+	for (uint8_t pair = 0; pair <= VALLOX_STATISTICS_PAIRS; pair++)
+	{
+		ValloxPairStatistics entry;
+		if (pair < VALLOX_STATISTICS_PAIRS)
+		{
+			entry = statistics.pairs[pair];
+		}
+		else
+		{
+			entry.sender = 0;
+			entry.receiver = 0;
+			entry.telegrams = statistics.otherPairTelegrams;
+		}
+
+		bool listed = pair == VALLOX_STATISTICS_PAIRS || entry.telegrams != 0;
+		if (all || entry.telegrams != m_Pairs[pair].telegrams)
+		{
+			m_Pairs[pair] = entry;
+			if (listed)
+			{
+				writeField(m_PairOffsets[pair], VALLOX_COUNTER_WIDTH, entry.telegrams, false);
+			}
+		}
+	}
+
+	for (uint8_t slot = 0; slot <= VALLOX_STATISTICS_VARIABLES; slot++)
+	{
+		ValloxVariableStatistics entry;
+		if (slot < VALLOX_STATISTICS_VARIABLES)
+		{
+			entry = statistics.variables[slot];
+		}
+		else
+		{
+			entry.variable = 0;
+			entry.telegrams = statistics.otherVariableTelegrams;
+		}
+
+		bool listed = slot == VALLOX_STATISTICS_VARIABLES || entry.telegrams != 0;
+		if (all || entry.telegrams != m_Variables[slot].telegrams)
+		{
+			m_Variables[slot] = entry;
+			if (listed)
+			{
+				writeField(m_VariableOffsets[slot], VALLOX_COUNTER_WIDTH, entry.telegrams, false);
+			}
+		}
+	}
+#endif
+}
+
+// a property was received or a pair or variable was added or replaced since the text was laid out
+bool ValloxMetrics::isLayoutChanged(const ValloxPropertyStore& properties, const ValloxStatistics& statistics) const
+{
+	for (uint8_t index = 0; index < VALLOX_PROPERTY_COUNT; index++)
+	{
+		if (properties.isKnown(index) != m_KnownProperties.test(index))
+		{
+			return true;
+		}
+	}
+
+#if VALLOX_STATISTICS_TABLES
+	for (uint8_t pair = 0; pair < VALLOX_STATISTICS_PAIRS; pair++)
+	{
+		const ValloxPairStatistics& entry = statistics.pairs[pair];
+		const ValloxPairStatistics& rendered = m_Pairs[pair];
+		if ((entry.telegrams != 0) != (rendered.telegrams != 0) ||
+			(entry.telegrams != 0 && (entry.sender != rendered.sender || entry.receiver != rendered.receiver)))
+		{
+			return true;
+		}
+	}
+
+	for (uint8_t slot = 0; slot < VALLOX_STATISTICS_VARIABLES; slot++)
+	{
+		const ValloxVariableStatistics& entry = statistics.variables[slot];
+		const ValloxVariableStatistics& rendered = m_Variables[slot];
+		if ((entry.telegrams != 0) != (rendered.telegrams != 0) ||
+			(entry.telegrams != 0 && entry.variable != rendered.variable))
+		{
+			return true;
+		}
+	}
+#endif
+	return false;
+}
+
+bool ValloxMetrics::append(const char* pText)
+{
+	while (*pText != '\0')
+	{
+		if (m_Length >= m_Size)
+		{
+			return false;
+		}
+		m_pBuffer[m_Length++] = *pText++;
+	}
+	return true;
+}
+
+bool ValloxMetrics::appendName(const char* pNames, uint8_t index)
+{
+	const char* pName = findName(pNames, index);
+	char c;
+	while ((c = pgm_read_byte(pName++)) != '\0')
+	{
+		if (m_Length >= m_Size)
+		{
+			return false;
+		}
+		m_pBuffer[m_Length++] = c;
+	}
+	return true;
+}
+
+bool ValloxMetrics::appendUnsigned(uint32_t value)
+{
+	char digits[11];
+	uint8_t count = 0;
+	do
+	{
+		digits[count++] = (char)('0' + value % 10);
+		value /= 10;
+	} while (value != 0);
+
+	while (count > 0)
+	{
+		if (m_Length >= m_Size)
+		{
+			return false;
+		}
+		m_pBuffer[m_Length++] = digits[--count];
+	}
+	return true;
+}
+
+// lower case, as the labels are compared as strings
+bool ValloxMetrics::appendHex(uint8_t value)
+{
+	static const char HEX_DIGITS[] = "0123456789abcdef";
+	char text[3] = { HEX_DIGITS[value >> 4], HEX_DIGITS[value & 0x0F], '\0' };
+	return append(text);
+}
+
+// reserves the value field of a sample and ends its line
+bool ValloxMetrics::appendField(uint16_t* pOffset, uint8_t width)
+{
+	if (m_Length + width + 1 > m_Size)
+	{
+		return false;
+	}
+
+	*pOffset = m_Length;
+	m_Length += width;
+	m_pBuffer[m_Length++] = '\n';
+	return true;
+}
+
+// right aligned with leading zeros, the sign takes the first character
+void ValloxMetrics::writeField(uint16_t offset, uint8_t width, uint32_t value, bool negative)
+{
+	char* pField = m_pBuffer + offset;
+	for (uint8_t i = width; i > 0; i--)
+	{
+		pField[i - 1] = (char)('0' + value % 10);
+		value /= 10;
+	}
+	if (negative)
+	{
+		pField[0] = '-';
+	}
+	m_PatchedFields++;
+}
@@ -0,0 +1,82 @@
+// Properties and bus statistics as OpenMetrics text, e.g. for Prometheus.
+//
+// The text is rendered into a buffer of the caller. The first render writes
+// the complete text with every value in a field of fixed width, padded with
+// leading zeros. Later renders only overwrite the fields whose value changed,
+// so scraping a unit costs a few comparisons unless it changed a lot:
+//
+//   # TYPE vallox_property gauge
+//   vallox_property{property="temp_inside"} 0021
+//   # TYPE vallox_received_telegrams counter
+//   vallox_received_telegrams_total 0000012345
+//   ...
+//   # EOF
+//
+// Properties which were not received yet are left out. The text is written
+// again when a property is received for the first time, when a sender/receiver
+// pair or a variable shows up in the statistics for the first time or after
+// they were reset.
+//
+// The whole text takes about 4 KB, so this is meant for boards with some RAM
+// and for gateways.
+
+#ifndef ValloxMetrics_h
+#define ValloxMetrics_h
+
+#include <ValloxSerial.h>
+#include <inttypes.h>
+
+const uint8_t VALLOX_METRIC_STATISTICS = 20;	// scalar counters and gauges of ValloxStatistics
+const uint8_t VALLOX_METRIC_GAPS = VALLOX_GAP_BUCKETS + 1;	// cumulative buckets and the count
+
+class ValloxMetrics
+{
+public:
+	ValloxMetrics(char* pBuffer, uint16_t size);
+
+	// returns the length of the text, 0 if the buffer is too small
+	uint16_t render(const ValloxPropertyStore& properties, const ValloxStatistics& statistics);
+	void invalidate();				// the next render writes the whole text
+
+	const char* getText() const;		// not terminated, getLength() characters
+	uint16_t getLength() const;
+	uint16_t getPatchedFields() const;	// fields written by the last render
+
+	// metric label of a property, e.g. "temp_inside", false if the property is not stored
+	static bool getPropertyName(ValloxProperty propertyId, char* pName, uint8_t size);
+
+private:
+	bool build(const ValloxPropertyStore& properties, const ValloxStatistics& statistics);
+	void update(const ValloxPropertyStore& properties, const ValloxStatistics& statistics, bool all);
+	bool isLayoutChanged(const ValloxPropertyStore& properties, const ValloxStatistics& statistics) const;
+
+	inline bool append(const char* pText);
+	inline bool appendName(const char* pNames, uint8_t index);
+	inline bool appendUnsigned(uint32_t value);
+	inline bool appendHex(uint8_t value);
+	inline bool appendField(uint16_t* pOffset, uint8_t width);
+	inline void writeField(uint16_t offset, uint8_t width, uint32_t value, bool negative);
+
+	char* m_pBuffer;
+	uint16_t m_Size;
+	uint16_t m_Length;
+	bool m_Built;
+	uint16_t m_PatchedFields;
+
+	// where the value fields are and what they hold
+	ValloxPropertyMask m_KnownProperties;			// the properties with a sample
+	uint16_t m_PropertyOffsets[VALLOX_PROPERTY_COUNT];
+	int8_t m_Properties[VALLOX_PROPERTY_COUNT];
+	uint16_t m_StatisticOffsets[VALLOX_METRIC_STATISTICS];
+	uint32_t m_Statistics[VALLOX_METRIC_STATISTICS];
+	uint16_t m_GapOffsets[VALLOX_METRIC_GAPS];
+	uint32_t m_Gaps[VALLOX_METRIC_GAPS];
+#if VALLOX_STATISTICS_TABLES
+	uint16_t m_PairOffsets[VALLOX_STATISTICS_PAIRS + 1];		// the last one is the other pairs
+	ValloxPairStatistics m_Pairs[VALLOX_STATISTICS_PAIRS + 1];
+	uint16_t m_VariableOffsets[VALLOX_STATISTICS_VARIABLES + 1];
+	ValloxVariableStatistics m_Variables[VALLOX_STATISTICS_VARIABLES + 1];
+#endif
+};
+
+#endif // ValloxMetrics_h
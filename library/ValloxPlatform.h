@@ -0,0 +1,34 @@
+// Platform abstraction so that the library builds for the Arduino cores and on
+// a host.
+//
+// On AVR constant tables are placed in flash with PROGMEM and have to be read
+// with the pgm_read functions. Everywhere else those map to plain memory
+// access.
+
+#ifndef ValloxPlatform_h
+#define ValloxPlatform_h
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+
+#include <inttypes.h>
+#include <string.h>
+
+#ifndef PROGMEM
+#define PROGMEM
+#endif
+
+#ifndef pgm_read_byte
+#define pgm_read_byte(address) (*(const uint8_t*)(address))
+#endif
+
+#ifndef pgm_read_word
+#define pgm_read_word(address) (*(const uint16_t*)(address))
+#endif
+
+#ifndef memcpy_P
+#define memcpy_P memcpy
+#endif
+
+#endif // ValloxPlatform_h
@@ -0,0 +1,197 @@
+#include <ValloxPollTable.h>
+#include <ValloxPlatform.h>
+
+ValloxPollTable::ValloxPollTable()
+{
+	memset(m_Entries, 0, sizeof(m_Entries));
+	m_Used = 0;
+	m_Pending = 0;
+	m_Sent = 0;
+}
+
+int8_t ValloxPollTable::find(uint8_t variable) const
+{
+	for (uint8_t slot = 0; slot < VALLOX_MAX_POLLS; slot++)
+	{
+		if ((m_Used & (1 << slot)) && m_Entries[slot].variable == variable)
+		{
+			return slot;
+		}
+	}
+	return -1;
+}
+
+bool ValloxPollTable::start(uint8_t variable, PollCompletedCallbackFunction callbackFunction, void* pContext, unsigned long now, bool* pSend)
+{
+	int8_t slot = find(variable);
+	if (slot >= 0 && (m_Pending & (1 << slot)))
+	{
+		// the reply to the running request answers this one as well, but it has room for one callback only
+		*pSend = false;
+		Entry& entry = m_Entries[slot];
+		if (callbackFunction && entry.callback &&
+			(entry.callback != callbackFunction || entry.pContext != pContext))
+		{
+			return false;
+		}
+		if (callbackFunction)
+		{
+			entry.callback = callbackFunction;
+			entry.pContext = pContext;
+		}
+		return true;
+	}
+
+	if (slot < 0)
+	{
+		// a free entry or the one idle for the longest time
+		unsigned long oldest = 0;
+		for (uint8_t candidate = 0; candidate < VALLOX_MAX_POLLS; candidate++)
+		{
+			uint8_t candidateBit = 1 << candidate;
+			if ((m_Used & candidateBit) == 0)
+			{
+				slot = candidate;
+				break;
+			}
+			if ((m_Pending & candidateBit) == 0 && (slot < 0 || now - m_Entries[candidate].lastRequest > oldest))
+			{
+				slot = candidate;
+				oldest = now - m_Entries[candidate].lastRequest;
+			}
+		}
+
+		if (slot < 0)
+		{
+			// sent without tracking
+			*pSend = true;
+			return false;
+		}
+
+		memset(&m_Entries[slot].statistics, 0, sizeof(ValloxPollStatistics));
+		m_Entries[slot].variable = variable;
+		m_Used |= 1 << slot;
+	}
+
+	Entry& entry = m_Entries[slot];
+	entry.retries = 0;
+	entry.firstRequest = now;
+	entry.lastRequest = now;
+	entry.callback = callbackFunction;
+	entry.pContext = pContext;
+	entry.statistics.requests++;
+	m_Pending |= 1 << slot;
+	m_Sent &= ~(1 << slot);
+
+	*pSend = true;
+	return true;
+}
+
+bool ValloxPollTable::hasPending() const
+{
+	return m_Pending != 0;
+}
+
+void ValloxPollTable::sent(uint8_t variable, unsigned long now)
+{
+	int8_t slot = find(variable);
+	if (slot >= 0 && (m_Pending & (1 << slot)))
+	{
+		m_Entries[slot].lastRequest = now;
+		m_Sent |= 1 << slot;
+	}
+}
+
+void ValloxPollTable::resend(uint8_t variable)
+{
+	int8_t slot = find(variable);
+	if (slot >= 0)
+	{
+		m_Sent &= ~(1 << slot);
+	}
+}
+
+void ValloxPollTable::complete(uint8_t variable, uint8_t value, unsigned long now)
+{
+	int8_t slot = find(variable);
+	if (slot >= 0 && (m_Pending & (1 << slot)))
+	{
+		// a broadcast may answer a poll which still waits to be sent, the latency is the wait then
+		ValloxPollStatistics& statistics = m_Entries[slot].statistics;
+		uint16_t latency = (uint16_t)(now - m_Entries[slot].lastRequest);
+		statistics.replies++;
+		statistics.lastLatency = latency;
+		statistics.totalLatency += latency;
+		if (latency > statistics.maxLatency)
+		{
+			statistics.maxLatency = latency;
+		}
+
+		finish(slot, true, value, now);
+	}
+}
+
+uint8_t ValloxPollTable::expire(unsigned long now, uint16_t timeout, uint8_t maxRetries)
+{
+	uint8_t resend = 0;
+
+	for (uint8_t slot = 0; slot < VALLOX_MAX_POLLS; slot++)
+	{
+		Entry& entry = m_Entries[slot];
+		if ((m_Sent & (1 << slot)) && now - entry.lastRequest >= timeout)
+		{
+			if (entry.retries < maxRetries)
+			{
+				entry.retries++;
+				entry.lastRequest = now;
+				entry.statistics.retries++;
+				m_Sent &= ~(1 << slot);
+				resend |= 1 << slot;
+			}
+			else
+			{
+				entry.statistics.timeouts++;
+				finish(slot, false, 0, now);
+			}
+		}
+	}
+
+	return resend;
+}
+
+uint8_t ValloxPollTable::restart()
+{
+	m_Sent = 0;
+	return m_Pending;
+}
+
+void ValloxPollTable::finish(uint8_t slot, bool replied, uint8_t value, unsigned long now)
+{
+	Entry& entry = m_Entries[slot];
+	m_Pending &= ~(1 << slot);
+	m_Sent &= ~(1 << slot);
+
+	if (entry.callback)
+	{
+		PollCompletedCallbackFunction callback = entry.callback;
+		entry.callback = NULL;
+		(*callback)(entry.pContext, entry.variable, replied, value, (uint16_t)(now - entry.firstRequest));
+	}
+}
+
+uint8_t ValloxPollTable::getVariable(uint8_t slot) const
+{
+	return m_Entries[slot].variable;
+}
+
+bool ValloxPollTable::getStatistics(uint8_t variable, ValloxPollStatistics* pStatistics) const
+{
+	int8_t slot = find(variable);
+	if (slot < 0)
+	{
+		return false;
+	}
+
+	*pStatistics = m_Entries[slot].statistics;
+	return true;
+}
@@ -0,0 +1,81 @@
+// Outstanding poll requests and their round trip statistics.
+//
+// Every polled variable gets an entry which links the reply of the master to
+// the request. While a request is pending the entry holds its completion
+// callback, after that it keeps the latency statistics of the variable until
+// it is reused for another variable. The least recently used idle entry is
+// reused first. The timeout of a request runs from the moment its poll was
+// actually sent, not while it waits in the transmit queue.
+
+#ifndef ValloxPollTable_h
+#define ValloxPollTable_h
+
+#include <inttypes.h>
+
+// number of variables tracked at once, at most 8 as the slots are kept in a byte
+#ifndef VALLOX_MAX_POLLS
+#define VALLOX_MAX_POLLS 8
+#endif
+
+static_assert(VALLOX_MAX_POLLS > 0 && VALLOX_MAX_POLLS <= 8, "VALLOX_MAX_POLLS must be 1..8");
+
+extern "C" {
+	// replied is false if the poll timed out after the last retry, latency is measured from the call of poll()
+	typedef void(*PollCompletedCallbackFunction)(void* pContext, uint8_t variable, bool replied, uint8_t value, uint16_t latencyMs);
+}
+
+// round trip statistics of a variable, latencies in ms from the last (re)send to the reply
+struct ValloxPollStatistics
+{
+	uint16_t requests;
+	uint16_t replies;
+	uint16_t retries;
+	uint16_t timeouts;		// requests given up after the last retry
+	uint16_t lastLatency;
+	uint16_t maxLatency;
+	uint32_t totalLatency;	// divide by replies for the average
+};
+
+class ValloxPollTable
+{
+public:
+	ValloxPollTable();
+
+	// returns false if all entries are pending or the variable is pending with the callback of another caller.
+	// *pSend is false if the variable is already pending.
+	bool start(uint8_t variable, PollCompletedCallbackFunction callbackFunction, void* pContext, unsigned long now, bool* pSend);
+
+	bool hasPending() const;
+	void sent(uint8_t variable, unsigned long now);						// the poll went out, its timeout starts
+	void resend(uint8_t variable);										// one more poll follows, its timeout waits for it
+	void complete(uint8_t variable, uint8_t value, unsigned long now);	// a reply of the master arrived
+
+	// gives up sent requests after the last retry and returns the slots to send again
+	uint8_t expire(unsigned long now, uint16_t timeout, uint8_t maxRetries);
+	uint8_t restart();			// the polls were dropped, returns the pending slots to send again
+	uint8_t getVariable(uint8_t slot) const;
+
+	bool getStatistics(uint8_t variable, ValloxPollStatistics* pStatistics) const;
+
+private:
+	struct Entry
+	{
+		uint8_t variable;
+		uint8_t retries;
+		unsigned long firstRequest;
+		unsigned long lastRequest;
+		PollCompletedCallbackFunction callback;
+		void* pContext;
+		ValloxPollStatistics statistics;
+	};
+
+	inline int8_t find(uint8_t variable) const;
+	inline void finish(uint8_t slot, bool replied, uint8_t value, unsigned long now);
+
+	Entry m_Entries[VALLOX_MAX_POLLS];
+	uint8_t m_Used;		// slots assigned to a variable
+	uint8_t m_Pending;	// slots waiting for a reply
+	uint8_t m_Sent;		// pending slots whose poll is on the bus
+};
+
+#endif // ValloxPollTable_h
@@ -0,0 +1,102 @@
+#include <ValloxProfiler.h>
+
+#if VALLOX_PROFILING
+
+#ifdef ARDUINO
+static uint32_t defaultClock()
+{
+	return micros();
+}
+#else
+#include <time.h>
+#endif
+
+ValloxProfiler::ValloxProfiler()
+{
+#ifdef ARDUINO
+	m_ClockFunction = defaultClock;
+#else
+	m_ClockFunction = monotonicNs;
+#endif
+	m_SlowCallbackThreshold = 0;
+	m_SlowCallback = NULL;
+	m_pSlowCallbackContext = NULL;
+	reset();
+}
+
+void ValloxProfiler::attachClock(ProfileClockFunction clockFunction)
+{
+	m_ClockFunction = clockFunction;
+	reset();
+}
+
+void ValloxProfiler::setSlowCallbackThreshold(uint32_t ticks, SlowCallbackFunction callbackFunction, void* pContext)
+{
+	m_SlowCallbackThreshold = ticks;
+	m_SlowCallback = callbackFunction;
+	m_pSlowCallbackContext = pContext;
+}
+
+const ValloxProfileHistogram& ValloxProfiler::getHistogram(ValloxProfileSection section) const
+{
+	return m_Histograms[section];
+}
+
+uint32_t ValloxProfiler::getSlowCallbacks() const
+{
+	return m_SlowCallbacks;
+}
+
+void ValloxProfiler::reset()
+{
+	memset(m_Histograms, 0, sizeof(m_Histograms));
+	m_SlowCallbacks = 0;
+}
+
+void ValloxProfiler::stop(ValloxProfileSection section, uint32_t start)
+{
+	uint32_t ticks = (*m_ClockFunction)() - start;
+
+	// the number of significant bits is the bucket
+	uint8_t bucket = 0;
+	for (uint32_t rest = ticks; rest != 0 && bucket < VALLOX_PROFILE_BUCKETS - 1; rest >>= 1)
+	{
+		bucket++;
+	}
+
+	ValloxProfileHistogram& histogram = m_Histograms[section];
+	histogram.count++;
+	histogram.totalTicks += ticks;
+	if (ticks > histogram.maxTicks)
+	{
+		histogram.maxTicks = ticks;
+	}
+	histogram.buckets[bucket]++;
+
+	if (section >= VALLOX_PROFILE_FIRST_CALLBACK && m_SlowCallbackThreshold != 0 && ticks >= m_SlowCallbackThreshold)
+	{
+		m_SlowCallbacks++;
+		if (m_SlowCallback)
+		{
+			(*m_SlowCallback)(m_pSlowCallbackContext, section, ticks);
+		}
+	}
+}
+
+#ifndef ARDUINO
+uint32_t ValloxProfiler::monotonicNs()
+{
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return (uint32_t)time.tv_sec * 1000000000UL + (uint32_t)time.tv_nsec;
+}
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+uint32_t ValloxProfiler::cycles()
+{
+	return (uint32_t)__builtin_ia32_rdtsc();
+}
+#endif
+
+#endif // VALLOX_PROFILING
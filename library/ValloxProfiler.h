@@ -0,0 +1,130 @@
+// Latency probes of the receive path and of the user callbacks.
+//
+// Every probed section adds its inclusive duration to a histogram with one
+// bucket per power of two ticks, so a run of several hours shows where the
+// loop time goes when the receive buffer overruns. A callback of the
+// application which takes longer than the threshold is counted and reported.
+// The ticks come from a clock function: micros() on the Arduino cores, the
+// monotonic clock in ns elsewhere, or the cycle counter via attachClock().
+//
+// Left out unless VALLOX_PROFILING is set to 1, without it the probes compile
+// to nothing.
+
+#ifndef ValloxProfiler_h
+#define ValloxProfiler_h
+
+#include <ValloxPlatform.h>
+#include <inttypes.h>
+
+#ifndef VALLOX_PROFILING
+#define VALLOX_PROFILING 0
+#endif
+
+#if VALLOX_PROFILING
+
+// bucket n counts durations of 2^(n-1) to 2^n - 1 ticks, the last one all longer ones
+#ifndef VALLOX_PROFILE_BUCKETS
+#ifdef ARDUINO
+#define VALLOX_PROFILE_BUCKETS 16
+#else
+#define VALLOX_PROFILE_BUCKETS 32
+#endif
+#endif
+
+enum ValloxProfileSection
+{
+	ProfileReceive,				// receive() and receiveAll()
+	ProfileTelegram,			// decoding of one telegram
+	ProfileUpdateProperty,
+	ProfileUpdateBitfields,
+	ProfileUpdateEfficiencies,
+
+	// callbacks of the application
+	ProfileTelegramCallback,
+	ProfilePropertyCallback,	// single and batched property changes
+	ProfileSubscriberCallback,
+	ProfileWriteCallback,
+
+	ProfileSectionCount
+};
+
+const uint8_t VALLOX_PROFILE_FIRST_CALLBACK = ProfileTelegramCallback;
+
+extern "C" {
+	typedef uint32_t(*ProfileClockFunction)();	// ticks, may wrap around
+	typedef void(*SlowCallbackFunction)(void* pContext, ValloxProfileSection section, uint32_t ticks);
+}
+
+struct ValloxProfileHistogram
+{
+	uint32_t count;
+	uint32_t maxTicks;
+	uint64_t totalTicks;
+	uint32_t buckets[VALLOX_PROFILE_BUCKETS];
+};
+
+class ValloxProfiler
+{
+public:
+	ValloxProfiler();
+
+	void attachClock(ProfileClockFunction clockFunction);
+	void setSlowCallbackThreshold(uint32_t ticks, SlowCallbackFunction callbackFunction = NULL, void* pContext = NULL);	// 0 = off
+
+	const ValloxProfileHistogram& getHistogram(ValloxProfileSection section) const;
+	uint32_t getSlowCallbacks() const;
+	void reset();
+
+	uint32_t start() const
+	{
+		return (*m_ClockFunction)();
+	}
+	void stop(ValloxProfileSection section, uint32_t start);
+
+#ifndef ARDUINO
+	static uint32_t monotonicNs();
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+	static uint32_t cycles();		// time stamp counter, the cheapest clock on x86
+#endif
+
+private:
+	ProfileClockFunction m_ClockFunction;
+	uint32_t m_SlowCallbackThreshold;
+	SlowCallbackFunction m_SlowCallback;
+	void* m_pSlowCallbackContext;
+	uint32_t m_SlowCallbacks;
+	ValloxProfileHistogram m_Histograms[ProfileSectionCount];
+};
+
+// measures from its construction to the end of the enclosing block
+class ValloxProfileScope
+{
+public:
+	ValloxProfileScope(ValloxProfiler& profiler, ValloxProfileSection section)
+		: m_Profiler(profiler), m_Section(section), m_Start(profiler.start())
+	{
+	}
+
+	~ValloxProfileScope()
+	{
+		m_Profiler.stop(m_Section, m_Start);
+	}
+
+private:
+	ValloxProfiler& m_Profiler;
+	ValloxProfileSection m_Section;
+	uint32_t m_Start;
+};
+
+#define VALLOX_PROFILE_NAME(line) valloxProfileScope##line
+#define VALLOX_PROFILE_SCOPE(line, section) ValloxProfileScope VALLOX_PROFILE_NAME(line)(m_Profiler, section)
+#define VALLOX_PROFILE(section) VALLOX_PROFILE_SCOPE(__LINE__, section)
+
+#else
+
+#define VALLOX_PROFILE(section)
+
+#endif // VALLOX_PROFILING
+
+#endif // ValloxProfiler_h
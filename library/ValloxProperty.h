@@ -0,0 +1,103 @@
+// Properties decoded from the telegrams of the vallox bus.
+
+#ifndef ValloxProperty_h
+#define ValloxProperty_h
+
+extern "C" {
+	enum ValloxProperty
+	{
+		// sensor data 
+		FanSpeedProperty							= 0,  // VALLOX_VARIABLE_FAN_SPEED
+		TempInsideProperty							= 1,  // VALLOX_VARIABLE_TEMP_INSIDE
+		TempOutsideProperty							= 2,  // VALLOX_VARIABLE_TEMP_OUTSIDE
+		TempExhaustProperty							= 3,  // VALLOX_VARIABLE_TEMP_EXHAUST
+		TempIncommingProperty						= 4,  // VALLOX_VARIABLE_TEMP_INCOMMING
+
+		// status bits
+		PowerStateProperty							= 5,  // VALLOX_VARIABLE_SELECT
+		CO2AdjustStateProperty						= 6,  // VALLOX_VARIABLE_SELECT
+		HumidityAdjustStateProperty					= 7,  // VALLOX_VARIABLE_SELECT
+		HeatingStateProperty						= 8,  // VALLOX_VARIABLE_SELECT
+		FilterGuardIndicatorProperty				= 9,  // VALLOX_VARIABLE_SELECT
+		HeatingIndicatorProperty					= 10, // VALLOX_VARIABLE_SELECT
+		FaultIndicatorProperty						= 11, // VALLOX_VARIABLE_SELECT
+		ServiceReminderIndicatorProperty			= 12, // VALLOX_VARIABLE_SELECT
+
+		HumidityProperty							= 13, // VALLOX_VARIABLE_HUMIDITY
+		BasicHumidityLevelProperty					= 14, // VALLOX_VARIABLE_BASIC_HUMIDITY_LEVEL
+		HumiditySensor1Property						= 15, // VALLOX_VARIABLE_HUMIDITY_SENSOR1
+		HumiditySensor2Property						= 16, // VALLOX_VARIABLE_HUMIDITY_SENSOR2
+
+		CO2HighProperty								= 17, // VALLOX_VARIABLE_CO2_HIGH
+		CO2LowProperty								= 18, // VALLOX_VARIABLE_CO2_LOW
+		CO2SetPointHighProperty						= 19, // VALLOX_VARIABLE_CO2_SET_POINT_UPPER
+		CO2SetPointLowProperty						= 20, // VALLOX_VARIABLE_CO2_SET_POINT_LOWER
+
+		FanSpeedMaxProperty							= 21, // VALLOX_VARIABLE_FAN_SPEED_MAX
+		FanSpeedMinProperty							= 22, // VALLOX_VARIABLE_FAN_SPEED_MIN
+		DCFanInputAdjustmentProperty				= 23, // VALLOX_VARIABLE_DC_FAN_INPUT_ADJUSTMENT
+		DCFanOutputAdjustmentProperty				= 24, // VALLOX_VARIABLE_DC_FAN_OUTPUT_ADJUSTMENT
+		InputFanStopThresholdProperty				= 25, // VALLOX_VARIABLE_INPUT_FAN_STOP
+		HeatingSetPointProperty						= 26, // VALLOX_VARIABLE_HEATING_SET_POINT
+		PreHeatingSetPointProperty					= 27, // VALLOX_VARIABLE_PRE_HEATING_SET_POINT
+		HrcBypassThresholdProperty					= 28, // VALLOX_VARIABLE_HRC_BYPASS
+		CellDefrostingThresholdProperty				= 29, // VALLOX_VARIABLE_CELL_DEFROSTING
+
+		// program
+		AdjustmentIntervalMinutesProperty			= 30, // VALLOX_VARIABLE_PROGRAM
+		AutomaticHumidityLevelSeekerStateProperty	= 31, // VALLOX_VARIABLE_PROGRAM
+		BoostSwitchModeProperty						= 32, // VALLOX_VARIABLE_PROGRAM
+		RadiatorTypeProperty						= 33, // VALLOX_VARIABLE_PROGRAM
+		CascadeAdjustProperty						= 34, // VALLOX_VARIABLE_PROGRAM
+
+		// program2
+		MaxSpeedLimitModeProperty					= 35, // VALLOX_VARIABLE_PROGRAM2
+
+		ServiceReminderProperty						= 36, // VALLOX_VARIABLE_SERVICE_REMINDER
+
+		// ioport multi purpose 1
+		PostHeatingOnProperty						= 37, // VALLOX_VARIABLE_IOPORT_MULTI_PURPOSE_1
+
+		// ioport multi purpose 2
+		DamperMotorPositionProperty					= 38, // VALLOX_VARIABLE_IOPORT_MULTI_PURPOSE_2
+		FaultSignalRelayProperty					= 39, // VALLOX_VARIABLE_IOPORT_MULTI_PURPOSE_2
+		SupplyFanOffProperty						= 50, // VALLOX_VARIABLE_IOPORT_MULTI_PURPOSE_2
+		PreHeatingOnProperty						= 41, // VALLOX_VARIABLE_IOPORT_MULTI_PURPOSE_2
+		ExhaustFanOffProperty						= 42, // VALLOX_VARIABLE_IOPORT_MULTI_PURPOSE_2
+		FirePlaceBoosterOnProperty					= 43, // VALLOX_VARIABLE_IOPORT_MULTI_PURPOSE_2
+
+		IncommingCurrentProperty					= 44, // VALLOX_VARIABLE_CURRENT_INCOMMING
+		LastErrorNumberProperty                     = 45, // VALLOX_VARIABLE_LAST_ERROR_NUMBER
+
+
+		// TODO: those variables are to be implemented in future, they can be polled by their virtual properties below
+
+		// calculated  properties
+		InEfficiencyProperty			= 100,
+		OutEfficiencyProperty			= 101,
+		AverageEfficiencyProperty		= 102,
+		
+
+		// virtual properties to be able to poll for this variable
+		SelectStatusProperty			= 200,
+		ProgramProperty					= 201, // VALLOX_VARIABLE_PROGRAM
+		Program2Property				= 202, // VALLOX_VARIABLE_PROGRAM2
+		IoPortMultiPurpose1Property		= 203, // VALLOX_VARIABLE_IOPORT_MULTI_PURPOSE_1
+		IoPortMultiPurpose2Property		= 204, // VALLOX_VARIABLE_IOPORT_MULTI_PURPOSE_2
+		IoPortFanSpeedRelaysProperty	= 205, // VALLOX_VARIABLE_IOPORT_FANSPEED_RELAYS
+		InstalledCO2SensorsProperty		= 206, // VALLOX_VARIABLE_INSTALLED_CO2_SENSORS
+		PostHeatingOnCounterProperty	= 207, // VALLOX_VARIABLE_POST_HEATING_ON_COUNTER
+		PostHeatingOffTimeProperty		= 208, // VALLOX_VARIABLE_POST_HEATING_OFF_TIME
+		PostHeatingTargetValueProperty	= 209, // VALLOX_VARIABLE_POST_HEATING_TARGET_VALUE
+		Flags1Property					= 210, // VALLOX_VARIABLE_FLAGS_1
+		Flags2Property					= 211, // VALLOX_VARIABLE_FLAGS_2
+		Flags3Property					= 212, // VALLOX_VARIABLE_FLAGS_3
+		Flags4Property					= 213, // VALLOX_VARIABLE_FLAGS_4
+		Flags5Property					= 214, // VALLOX_VARIABLE_FLAGS_5
+		Flags6Property					= 215, // VALLOX_VARIABLE_FLAGS_6
+		FirePlaceBoosterCounterProperty	= 216, // VALLOX_VARIABLE_FIRE_PLACE_BOOSTER_COUNTER
+		MaintenanceMonthCounterProperty	= 217, // VALLOX_VARIABLE_MAINTENANCE_MONTH_COUNTER
+	};
+}
+
+#endif // ValloxProperty_h
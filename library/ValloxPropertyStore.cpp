@@ -0,0 +1,383 @@
+#include <ValloxPropertyStore.h>
+#include <ValloxPlatform.h>
+
+// compact index -> property id
+static constexpr uint8_t VALLOX_PROPERTY_IDS[VALLOX_PROPERTY_COUNT] PROGMEM =
+{
+	// integer properties
+	FanSpeedProperty,
+	TempInsideProperty,
+	TempOutsideProperty,
+	TempExhaustProperty,
+	TempIncommingProperty,
+	HumidityProperty,
+	BasicHumidityLevelProperty,
+	HumiditySensor1Property,
+	HumiditySensor2Property,
+	CO2HighProperty,
+	CO2LowProperty,
+	CO2SetPointHighProperty,
+	CO2SetPointLowProperty,
+	FanSpeedMaxProperty,
+	FanSpeedMinProperty,
+	DCFanInputAdjustmentProperty,
+	DCFanOutputAdjustmentProperty,
+	InputFanStopThresholdProperty,
+	HeatingSetPointProperty,
+	PreHeatingSetPointProperty,
+	HrcBypassThresholdProperty,
+	CellDefrostingThresholdProperty,
+	AdjustmentIntervalMinutesProperty,
+	ServiceReminderProperty,
+	IncommingCurrentProperty,
+	LastErrorNumberProperty,
+	InEfficiencyProperty,
+	OutEfficiencyProperty,
+	AverageEfficiencyProperty,
+	SelectStatusProperty,
+
+	// boolean properties
+	PowerStateProperty,
+	CO2AdjustStateProperty,
+	HumidityAdjustStateProperty,
+	HeatingStateProperty,
+	FilterGuardIndicatorProperty,
+	HeatingIndicatorProperty,
+	FaultIndicatorProperty,
+	ServiceReminderIndicatorProperty,
+	AutomaticHumidityLevelSeekerStateProperty,
+	BoostSwitchModeProperty,
+	RadiatorTypeProperty,
+	CascadeAdjustProperty,
+	MaxSpeedLimitModeProperty,
+	PostHeatingOnProperty,
+	DamperMotorPositionProperty,
+	FaultSignalRelayProperty,
+	SupplyFanOffProperty,
+	PreHeatingOnProperty,
+	ExhaustFanOffProperty,
+	FirePlaceBoosterOnProperty
+};
+
+// property id -> compact index for the sensor, status and setting properties
+static constexpr uint8_t VALLOX_PROPERTY_INDICES[] PROGMEM =
+{
+	0, // FanSpeedProperty
+	1, // TempInsideProperty
+	2, // TempOutsideProperty
+	3, // TempExhaustProperty
+	4, // TempIncommingProperty
+	30, // PowerStateProperty
+	31, // CO2AdjustStateProperty
+	32, // HumidityAdjustStateProperty
+	33, // HeatingStateProperty
+	34, // FilterGuardIndicatorProperty
+	35, // HeatingIndicatorProperty
+	36, // FaultIndicatorProperty
+	37, // ServiceReminderIndicatorProperty
+	5, // HumidityProperty
+	6, // BasicHumidityLevelProperty
+	7, // HumiditySensor1Property
+	8, // HumiditySensor2Property
+	9, // CO2HighProperty
+	10, // CO2LowProperty
+	11, // CO2SetPointHighProperty
+	12, // CO2SetPointLowProperty
+	13, // FanSpeedMaxProperty
+	14, // FanSpeedMinProperty
+	15, // DCFanInputAdjustmentProperty
+	16, // DCFanOutputAdjustmentProperty
+	17, // InputFanStopThresholdProperty
+	18, // HeatingSetPointProperty
+	19, // PreHeatingSetPointProperty
+	20, // HrcBypassThresholdProperty
+	21, // CellDefrostingThresholdProperty
+	22, // AdjustmentIntervalMinutesProperty
+	38, // AutomaticHumidityLevelSeekerStateProperty
+	39, // BoostSwitchModeProperty
+	40, // RadiatorTypeProperty
+	41, // CascadeAdjustProperty
+	42, // MaxSpeedLimitModeProperty
+	23, // ServiceReminderProperty
+	43, // PostHeatingOnProperty
+	44, // DamperMotorPositionProperty
+	45, // FaultSignalRelayProperty
+	VALLOX_NO_INDEX, // 40
+	47, // PreHeatingOnProperty
+	48, // ExhaustFanOffProperty
+	49, // FirePlaceBoosterOnProperty
+	24, // IncommingCurrentProperty
+	25, // LastErrorNumberProperty
+	VALLOX_NO_INDEX, // 46
+	VALLOX_NO_INDEX, // 47
+	VALLOX_NO_INDEX, // 48
+	VALLOX_NO_INDEX, // 49
+	46 // SupplyFanOffProperty
+};
+
+const uint8_t VALLOX_PROPERTY_INDICES_COUNT = sizeof(VALLOX_PROPERTY_INDICES);
+const uint8_t VALLOX_EFFICIENCY_INDEX = 26;
+const uint8_t VALLOX_SELECT_STATUS_INDEX = 29;
+
+// both tables have to describe the same mapping
+static constexpr uint8_t constexprIndexOf(uint8_t propertyId)
+{
+	return propertyId < VALLOX_PROPERTY_INDICES_COUNT ? VALLOX_PROPERTY_INDICES[propertyId] :
+		propertyId >= InEfficiencyProperty && propertyId <= AverageEfficiencyProperty ? VALLOX_EFFICIENCY_INDEX + propertyId - InEfficiencyProperty :
+		propertyId == SelectStatusProperty ? VALLOX_SELECT_STATUS_INDEX : VALLOX_NO_INDEX;
+}
+
+static constexpr bool isConsistent(uint8_t index)
+{
+	return index == VALLOX_PROPERTY_COUNT ||
+		(constexprIndexOf(VALLOX_PROPERTY_IDS[index]) == index && isConsistent(index + 1));
+}
+
+static_assert(isConsistent(0), "VALLOX_PROPERTY_IDS and VALLOX_PROPERTY_INDICES do not match");
+
+static inline bool testBit(const uint8_t* pBits, uint8_t bit)
+{
+	return (pBits[bit >> 3] & (1 << (bit & 7))) != 0;
+}
+
+static inline void setBit(uint8_t* pBits, uint8_t bit)
+{
+	pBits[bit >> 3] |= (1 << (bit & 7));
+}
+
+static inline void resetBit(uint8_t* pBits, uint8_t bit)
+{
+	pBits[bit >> 3] &= ~(1 << (bit & 7));
+}
+
+
+ValloxPropertyMask::ValloxPropertyMask()
+{
+	clear();
+}
+
+void ValloxPropertyMask::clear()
+{
+	memset(m_Bits, 0, sizeof(m_Bits));
+}
+
+bool ValloxPropertyMask::isEmpty() const
+{
+	for (uint8_t i = 0; i < sizeof(m_Bits); i++)
+	{
+		if (m_Bits[i])
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+void ValloxPropertyMask::set(uint8_t index)
+{
+	setBit(m_Bits, index);
+}
+
+void ValloxPropertyMask::reset(uint8_t index)
+{
+	resetBit(m_Bits, index);
+}
+
+bool ValloxPropertyMask::test(uint8_t index) const
+{
+	return testBit(m_Bits, index);
+}
+
+void ValloxPropertyMask::add(ValloxProperty propertyId)
+{
+	uint8_t index = ValloxPropertyStore::indexOf(propertyId);
+	if (index != VALLOX_NO_INDEX)
+	{
+		set(index);
+	}
+}
+
+bool ValloxPropertyMask::contains(ValloxProperty propertyId) const
+{
+	uint8_t index = ValloxPropertyStore::indexOf(propertyId);
+	return index != VALLOX_NO_INDEX && test(index);
+}
+
+bool ValloxPropertyMask::next(uint8_t* pIndex) const
+{
+	uint8_t index = *pIndex;
+	while (index < VALLOX_PROPERTY_COUNT)
+	{
+		uint8_t bits = m_Bits[index >> 3] >> (index & 7);
+		if (bits == 0)
+		{
+			// skip the rest of this byte
+			index = (index | 7) + 1;
+		}
+		else if (bits & 1)
+		{
+			*pIndex = index;
+			return true;
+		}
+		else
+		{
+			index++;
+		}
+	}
+	return false;
+}
+
+void ValloxPropertyMask::merge(const ValloxPropertyMask& mask)
+{
+	for (uint8_t i = 0; i < sizeof(m_Bits); i++)
+	{
+		m_Bits[i] |= mask.m_Bits[i];
+	}
+}
+
+bool ValloxPropertyMask::intersects(const ValloxPropertyMask& mask) const
+{
+	for (uint8_t i = 0; i < sizeof(m_Bits); i++)
+	{
+		if (m_Bits[i] & mask.m_Bits[i])
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+
+ValloxPropertyStore::ValloxPropertyStore()
+{
+	clear();
+}
+
+void ValloxPropertyStore::clear()
+{
+	memset(m_Values, VALLOX_UNKNOWN_VALUE, sizeof(m_Values));
+	memset(m_KnownValues, 0, sizeof(m_KnownValues));
+	memset(m_Booleans, 0, sizeof(m_Booleans));
+	memset(m_KnownBooleans, 0, sizeof(m_KnownBooleans));
+	m_Dirty.clear();
+
+	m_Values[indexOf(FanSpeedProperty)] = 1;
+	m_Values[indexOf(FanSpeedMaxProperty)] = 8;
+	m_Values[indexOf(FanSpeedMinProperty)] = 1;
+	setBit(m_KnownValues, indexOf(FanSpeedProperty));
+	setBit(m_KnownValues, indexOf(FanSpeedMaxProperty));
+	setBit(m_KnownValues, indexOf(FanSpeedMinProperty));
+}
+
+int8_t ValloxPropertyStore::get(uint8_t index) const
+{
+	if (index < VALLOX_INTEGER_PROPERTY_COUNT)
+	{
+		return m_Values[index];
+	}
+
+	uint8_t bit = index - VALLOX_INTEGER_PROPERTY_COUNT;
+	if (!testBit(m_KnownBooleans, bit))
+	{
+		return VALLOX_UNKNOWN_VALUE;
+	}
+	return testBit(m_Booleans, bit) ? 1 : 0;
+}
+
+bool ValloxPropertyStore::set(uint8_t index, int8_t value)
+{
+	if (index >= VALLOX_INTEGER_PROPERTY_COUNT && value != VALLOX_UNKNOWN_VALUE)
+	{
+		value = value ? 1 : 0;
+	}
+
+	// the first -1 degree is a change as well
+	bool unchanged = index < VALLOX_INTEGER_PROPERTY_COUNT ? isKnown(index) && m_Values[index] == value : get(index) == value;
+	if (unchanged)
+	{
+		return false;
+	}
+
+	if (index < VALLOX_INTEGER_PROPERTY_COUNT)
+	{
+		m_Values[index] = value;
+		setBit(m_KnownValues, index);
+	}
+	else
+	{
+		uint8_t bit = index - VALLOX_INTEGER_PROPERTY_COUNT;
+		if (value == VALLOX_UNKNOWN_VALUE)
+		{
+			resetBit(m_KnownBooleans, bit);
+			resetBit(m_Booleans, bit);
+		}
+		else
+		{
+			setBit(m_KnownBooleans, bit);
+			if (value)
+			{
+				setBit(m_Booleans, bit);
+			}
+			else
+			{
+				resetBit(m_Booleans, bit);
+			}
+		}
+	}
+
+	m_Dirty.set(index);
+	return true;
+}
+
+bool ValloxPropertyStore::isKnown(uint8_t index) const
+{
+	if (index < VALLOX_INTEGER_PROPERTY_COUNT)
+	{
+		return testBit(m_KnownValues, index);
+	}
+	return testBit(m_KnownBooleans, index - VALLOX_INTEGER_PROPERTY_COUNT);
+}
+
+int8_t ValloxPropertyStore::getValue(ValloxProperty propertyId) const
+{
+	uint8_t index = indexOf(propertyId);
+	return index != VALLOX_NO_INDEX ? get(index) : VALLOX_UNKNOWN_VALUE;
+}
+
+const ValloxPropertyMask& ValloxPropertyStore::getDirty() const
+{
+	return m_Dirty;
+}
+
+void ValloxPropertyStore::clearDirty(uint8_t index)
+{
+	m_Dirty.reset(index);
+}
+
+void ValloxPropertyStore::clearDirty()
+{
+	m_Dirty.clear();
+}
+
+uint8_t ValloxPropertyStore::indexOf(ValloxProperty propertyId)
+{
+	uint8_t id = (uint8_t)propertyId;
+	if (id < VALLOX_PROPERTY_INDICES_COUNT)
+	{
+		return pgm_read_byte(&VALLOX_PROPERTY_INDICES[id]);
+	}
+	if (id >= InEfficiencyProperty && id <= AverageEfficiencyProperty)
+	{
+		return VALLOX_EFFICIENCY_INDEX + id - InEfficiencyProperty;
+	}
+	if (id == SelectStatusProperty)
+	{
+		return VALLOX_SELECT_STATUS_INDEX;
+	}
+	return VALLOX_NO_INDEX;
+}
+
+ValloxProperty ValloxPropertyStore::propertyAt(uint8_t index)
+{
+	return (ValloxProperty)pgm_read_byte(&VALLOX_PROPERTY_IDS[index]);
+}
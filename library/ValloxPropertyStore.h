@@ -0,0 +1,74 @@
+// Dense storage of all decoded property values.
+//
+// The sparse ValloxProperty ids are mapped to a compact index. Integer
+// properties are kept in an int8_t array, boolean properties are packed into
+// bitsets. A bit per property tells whether the value was received yet, as -1
+// is a valid temperature. Every change marks the property in a dirty bitset.
+
+#ifndef ValloxPropertyStore_h
+#define ValloxPropertyStore_h
+
+#include <ValloxProperty.h>
+#include <inttypes.h>
+
+const uint8_t VALLOX_INTEGER_PROPERTY_COUNT = 30;
+const uint8_t VALLOX_BOOLEAN_PROPERTY_COUNT = 20;
+const uint8_t VALLOX_PROPERTY_COUNT = VALLOX_INTEGER_PROPERTY_COUNT + VALLOX_BOOLEAN_PROPERTY_COUNT;
+const uint8_t VALLOX_NO_INDEX = 0xFF;
+
+const int8_t VALLOX_UNKNOWN_VALUE = -1;
+
+// one bit per compact property index
+class ValloxPropertyMask
+{
+public:
+	ValloxPropertyMask();
+
+	void clear();
+	bool isEmpty() const;
+
+	void set(uint8_t index);
+	void reset(uint8_t index);
+	bool test(uint8_t index) const;
+
+	void add(ValloxProperty propertyId);
+	bool contains(ValloxProperty propertyId) const;
+
+	bool next(uint8_t* pIndex) const;	// advances *pIndex to the next set bit at or after *pIndex
+
+	void merge(const ValloxPropertyMask& mask);
+	bool intersects(const ValloxPropertyMask& mask) const;
+
+private:
+	uint8_t m_Bits[(VALLOX_PROPERTY_COUNT + 7) / 8];
+};
+
+class ValloxPropertyStore
+{
+public:
+	ValloxPropertyStore();
+
+	void clear();									// resets all properties to their initial values
+
+	int8_t get(uint8_t index) const;				// VALLOX_UNKNOWN_VALUE if the property was not received yet
+	bool set(uint8_t index, int8_t value);			// returns true and marks the property dirty if the value changed
+	bool isKnown(uint8_t index) const;				// received or preset, integer properties stay known
+
+	int8_t getValue(ValloxProperty propertyId) const;
+
+	const ValloxPropertyMask& getDirty() const;
+	void clearDirty(uint8_t index);
+	void clearDirty();
+
+	static uint8_t indexOf(ValloxProperty propertyId);	// VALLOX_NO_INDEX for properties which are not stored
+	static ValloxProperty propertyAt(uint8_t index);
+
+private:
+	int8_t m_Values[VALLOX_INTEGER_PROPERTY_COUNT];
+	uint8_t m_KnownValues[(VALLOX_INTEGER_PROPERTY_COUNT + 7) / 8];
+	uint8_t m_Booleans[(VALLOX_BOOLEAN_PROPERTY_COUNT + 7) / 8];
+	uint8_t m_KnownBooleans[(VALLOX_BOOLEAN_PROPERTY_COUNT + 7) / 8];
+	ValloxPropertyMask m_Dirty;
+};
+
+#endif // ValloxPropertyStore_h
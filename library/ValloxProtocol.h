@@ -22,11 +22,17 @@
 #ifndef ValloxProtocol_h
 #define ValloxProtocol_h
 
-#include <inttypes.h>
+#include <ValloxCodec.h>
 
 const uint16_t VALLOX_BAUDRATE = 9600; 
 
 const uint8_t VALLOX_LENGTH = 6; // always 6
+
+// time on the wire of one telegram: 6 characters of 10 bits at 9600 baud take 6.25ms,
+// rounded up and one more for the resolution of millis()
+const uint8_t VALLOX_TELEGRAM_DURATION_MS = 7;
+
+const uint16_t VALLOX_CHARACTER_TIME_US = 1042; // 10 bits at 9600 baud
 const uint8_t VALLOX_DOMAIN = 1; // always 1
 
 // Addresses for sender and receiver
@@ -314,101 +320,35 @@ enum ValloxRadiatorType
 	Water
 };
 
-static uint8_t VALLOX_FAN_SPEED_MAPPING[] =
-{
-	0x01,
-	0x03,
-	0x07,
-	0x0F,
-	0x1F,
-	0x3F,
-	0x7F,
-	0xFF
-};
-
-
-static int8_t VALLOX_TEMPERATURE_MAPPING[] =
-{
-	-74, -70, -66, -62, -59, -56, -54, -52,
-	-50, -48, -47, -46, -44, -43, -42, -41,
-	-40, -39, -38, -37, -36, -35, -34, -33,
-	-33, -32, -31, -30, -30, -29, -28, -28,
-	-27, -27, -26, -25, -25, -24, -24, -23,
-	-23, -22, -22, -21, -21, -20, -20, -19,
-	-19, -19, -18, -18, -17, -17, -16, -16,
-	-16, -15, -15, -14, -14, -14, -13, -13,
-	-12, -12, -12, -11, -11, -11, -10, -10,
-	-9,  -9,  -9,  -8,  -8,  -8,  -7,  -7,
-	-7,  -6,  -6,  -6,  -5,  -5,  -5,  -4,
-	-4,  -4,  -3,  -3,  -3,  -2,  -2,  -2,
-	-1,  -1,  -1,  -1,  0,   0,   0,   1,
-	1,   1,   2,   2,   2,   3,   3,   3,
-	4,   4,   4,   5,   5,   5,   5,   6,
-	6,   6,   7,   7,   7,   8,   8,   8,
-	9,   9,   9,   10,  10,  10,  11,  11,
-	11,  12,  12,  12,  13,  13,  13,  14,
-	14,  14,  15,  15,  15,  16,  16,  16,
-	17,  17,  18,  18,  18,  19,  19,  19,
-	20,  20,  21,  21,  21,  22,  22,  22,
-	23,  23,  24,  24,  24,  25,  25,  26,
-	26,  27,  27,  27,  28,  28,  29,  29,
-	30,  30,  31,  31,  32,  32,  33,  33,
-	34,  34,  35,  35,  36,  36,  37,  37,
-	38,  38,  39,  40,  40,  41,  41,  42,
-	43,  43,  44,  45,  45,  46,  47,  48,
-	49,  49,  50,  51,  52,  53,  53,  54,
-	55,  56,  57,  59,  60,  61,  62,  63,
-	65,  66,  68,  69,  71,  73,  75,  77,
-	79,  81,  82,  86,  90,  93,  97,  100,
-	100, 100, 100, 100, 100, 100, 100, 100
-};
-
 class Vallox
 {
 public:
 	static int8_t convertTemperature(uint8_t value)
 	{
-		return VALLOX_TEMPERATURE_MAPPING[value];
+		return ValloxCodec::decodeTemperature(value);
 	}
 
 	static uint8_t convertBackTemperature(int8_t temperature)
 	{
-		uint8_t value = 100;
-
-		for (uint8_t i = 0; i < 255; i++)
-		{
-			int8_t valueFromTable = VALLOX_TEMPERATURE_MAPPING[i];
-			if (valueFromTable >= temperature)
-			{
-				value = i;
-				break;
-			}
-		}
-
-		return value;
+		return ValloxCodec::encodeTemperature(temperature);
 	}
 
-	// 8 --> 0xFF
+	// 7 --> 0xFF (zero based index of the fan speed)
 	static uint8_t convertBackFanSpeed(uint8_t value)
 	{
-		return VALLOX_FAN_SPEED_MAPPING[value];
+		return ValloxCodec::encodeFanSpeed((uint8_t)(value + 1));
 	}
 
 	// 0xFF --> 8
 	static uint8_t convertFanSpeed(uint8_t value)
 	{
-		uint8_t fanSpeed = 0;
-
-		for (uint8_t i = 0; i < 8; i++)
-		{
-			if (VALLOX_FAN_SPEED_MAPPING[i] == value)
-			{
-				fanSpeed = i + 1;
-				break;
-			}
-		}
+		return ValloxCodec::decodeFanSpeed(value);
+	}
 
-		return fanSpeed;
+	// 0x33 --> 0% 0xFF --> 100%
+	static uint8_t convertHumidity(uint8_t value)
+	{
+		return ValloxCodec::decodeHumidity(value);
 	}
 
 	// 1 1 1 1 1 1 1 1
@@ -0,0 +1,182 @@
+#include <ValloxScheduler.h>
+
+#if VALLOX_SCHEDULER
+
+ValloxScheduler::ValloxScheduler()
+{
+	m_Count = 0;
+}
+
+int8_t ValloxScheduler::find(uint8_t variable) const
+{
+	for (uint8_t i = 0; i < m_Count; i++)
+	{
+		if (m_Entries[i].variable == variable)
+		{
+			return i;
+		}
+	}
+	return -1;
+}
+
+bool ValloxScheduler::add(uint8_t variable, uint16_t maxAgeSeconds, uint8_t priority, unsigned long now)
+{
+	int8_t i = find(variable);
+	if (i < 0)
+	{
+		if (m_Count == VALLOX_MAX_SCHEDULED)
+		{
+			return false;
+		}
+
+		Entry& entry = m_Entries[m_Count++];
+		entry.variable = variable;
+		entry.priority = priority;
+		entry.unanswered = 0;
+		entry.known = false;
+		entry.value = 0;
+		entry.maxAge = maxAgeSeconds;
+		entry.changeInterval = 0;
+		entry.lastSeen = now;
+		entry.lastChanged = now;
+		entry.lastPolled = 0;
+	}
+	else
+	{
+		// several properties of the same variable: the tightest requirement wins
+		Entry& entry = m_Entries[i];
+		entry.maxAge = maxAgeSeconds < entry.maxAge ? maxAgeSeconds : entry.maxAge;
+		entry.priority = priority > entry.priority ? priority : entry.priority;
+	}
+	return true;
+}
+
+void ValloxScheduler::remove(uint8_t variable)
+{
+	int8_t i = find(variable);
+	if (i >= 0)
+	{
+		m_Entries[i] = m_Entries[--m_Count];
+	}
+}
+
+bool ValloxScheduler::isEmpty() const
+{
+	return m_Count == 0;
+}
+
+unsigned long ValloxScheduler::getMaxInterval(const Entry& entry) const
+{
+	return ((unsigned long)entry.maxAge * 1000) << VALLOX_SCHEDULE_MAX_STRETCH;
+}
+
+// half the time the value usually stays unchanged, a value unchanged for longer than that counts with its current age
+unsigned long ValloxScheduler::getInterval(const Entry& entry) const
+{
+	unsigned long unchanged = entry.known ? entry.lastSeen - entry.lastChanged : 0;
+	unsigned long changeInterval = (unsigned long)entry.changeInterval * 1000;
+	unsigned long interval = (changeInterval > unchanged ? changeInterval : unchanged) / 2;
+
+	unsigned long minInterval = (unsigned long)entry.maxAge * 1000;
+	unsigned long maxInterval = getMaxInterval(entry);
+	return interval < minInterval ? minInterval : interval > maxInterval ? maxInterval : interval;
+}
+
+void ValloxScheduler::observe(uint8_t variable, uint8_t value, unsigned long now)
+{
+	int8_t i = find(variable);
+	if (i >= 0)
+	{
+		Entry& entry = m_Entries[i];
+		if (entry.known && entry.value != value)
+		{
+			// smoothed, so a single quick change does not undo what was learned
+			unsigned long measured = (now - entry.lastChanged) / 1000;
+			measured = measured < 0xFFFF ? measured : 0xFFFF;
+			entry.changeInterval = entry.changeInterval == 0 ? (uint16_t)measured :
+				(uint16_t)(((unsigned long)entry.changeInterval * 3 + measured) / 4);
+			entry.lastChanged = now;
+		}
+		else if (!entry.known)
+		{
+			entry.lastChanged = now;
+		}
+
+		entry.known = true;
+		entry.value = value;
+		entry.lastSeen = now;
+		entry.unanswered = 0;
+	}
+}
+
+bool ValloxScheduler::next(unsigned long now, unsigned long holdOff, uint8_t* pVariable)
+{
+	int8_t best = -1;
+	unsigned long bestOverdue = 0;
+
+	for (uint8_t i = 0; i < m_Count; i++)
+	{
+		Entry& entry = m_Entries[i];
+		if (entry.lastPolled != 0)
+		{
+			// every unanswered poll doubles the wait, up to the longest interval
+			unsigned long wait = holdOff;
+			unsigned long maxInterval = getMaxInterval(entry);
+			for (uint8_t k = 0; k < entry.unanswered && wait < maxInterval; k++)
+			{
+				wait <<= 1;
+			}
+			wait = wait > maxInterval && maxInterval > holdOff ? maxInterval : wait;
+			if (now - entry.lastPolled < wait)
+			{
+				continue;
+			}
+		}
+
+		// never seen values are due since they were added
+		unsigned long age = now - entry.lastSeen;
+		unsigned long interval = entry.known ? getInterval(entry) : 0;
+		if (age < interval)
+		{
+			continue;
+		}
+		unsigned long overdue = age - interval;
+
+		if (best < 0 ||
+			entry.priority > m_Entries[best].priority ||
+			(entry.priority == m_Entries[best].priority && overdue > bestOverdue))
+		{
+			best = i;
+			bestOverdue = overdue;
+		}
+	}
+
+	if (best < 0)
+	{
+		return false;
+	}
+
+	// 0 marks never polled, the counter is reset by the answer
+	Entry& entry = m_Entries[best];
+	entry.lastPolled = now ? now : 1;
+	if (entry.unanswered < 0xFF)
+	{
+		entry.unanswered++;
+	}
+	*pVariable = entry.variable;
+	return true;
+}
+
+bool ValloxScheduler::getInterval(uint8_t variable, unsigned long* pIntervalMs) const
+{
+	int8_t i = find(variable);
+	if (i < 0)
+	{
+		return false;
+	}
+
+	*pIntervalMs = getInterval(m_Entries[i]);
+	return true;
+}
+
+#endif // VALLOX_SCHEDULER
@@ -0,0 +1,81 @@
+// Adaptive polling of variables by staleness.
+//
+// Every scheduled variable has a maximum age and a priority. A variable is
+// due when its value is older than its current interval. Values seen on the
+// bus without being polled, e.g. broadcasts, count as fresh as well. The
+// interval is half the time the value usually stays unchanged, learned from
+// the changes seen, but at least the maximum age and at most
+// 2^VALLOX_SCHEDULE_MAX_STRETCH times of it. So settings which never change
+// are polled rarely and a change brings the interval down again.
+//
+// Of all due variables the one with the highest priority and then the one
+// overdue for the longest time is polled next. Variables never seen are due
+// from the time they were added on. A poll which is not answered doubles the
+// time until the variable is polled again, up to the longest interval, so
+// variables the master does not know do not take the bus from the others.
+//
+// Setting VALLOX_SCHEDULER to 0 leaves it out for sketches which do not poll
+// in the background.
+
+#ifndef ValloxScheduler_h
+#define ValloxScheduler_h
+
+#include <inttypes.h>
+
+#ifndef VALLOX_SCHEDULER
+#define VALLOX_SCHEDULER 1
+#endif
+
+#if VALLOX_SCHEDULER
+
+#ifndef VALLOX_MAX_SCHEDULED
+#define VALLOX_MAX_SCHEDULED 16
+#endif
+
+#ifndef VALLOX_SCHEDULE_MAX_STRETCH
+#define VALLOX_SCHEDULE_MAX_STRETCH 4
+#endif
+
+class ValloxScheduler
+{
+public:
+	ValloxScheduler();
+
+	bool add(uint8_t variable, uint16_t maxAgeSeconds, uint8_t priority, unsigned long now);	// returns false if the table is full
+	void remove(uint8_t variable);
+	bool isEmpty() const;
+
+	void observe(uint8_t variable, uint8_t value, unsigned long now);	// the value of a variable was received
+
+	// the most urgent due variable. variables polled within holdOff are skipped as their reply may still come,
+	// unanswered ones for twice as long after every poll.
+	bool next(unsigned long now, unsigned long holdOff, uint8_t* pVariable);
+
+	bool getInterval(uint8_t variable, unsigned long* pIntervalMs) const;	// the learned interval
+
+private:
+	struct Entry
+	{
+		uint8_t variable;
+		uint8_t priority;
+		uint8_t unanswered;		// polls since the value was seen last
+		bool known;				// value and lastChanged are valid
+		uint8_t value;
+		uint16_t maxAge;		// seconds
+		uint16_t changeInterval;	// seconds the value usually stays unchanged, 0 until it changed twice
+		unsigned long lastSeen;		// the time it was added as long as it was not seen
+		unsigned long lastChanged;
+		unsigned long lastPolled;
+	};
+
+	inline int8_t find(uint8_t variable) const;
+	inline unsigned long getInterval(const Entry& entry) const;
+	inline unsigned long getMaxInterval(const Entry& entry) const;
+
+	Entry m_Entries[VALLOX_MAX_SCHEDULED];
+	uint8_t m_Count;
+};
+
+#endif // VALLOX_SCHEDULER
+
+#endif // ValloxScheduler_h
@@ -1,6 +1,5 @@
 #include <ValloxSerial.h>
-
-const int8_t INITIAL_VALUE = -1;
+#include <ValloxVariableTable.h>
 
 ValloxSerial::ValloxSerial()
 {
@@ -9,8 +8,10 @@ ValloxSerial::ValloxSerial()
 
 	m_SenderId = VALLOX_ADDRESS_PANEL8;	// we send commands in the name of panel8 (29)	
 	m_ReceiverId = VALLOX_ADDRESS_PANEL1; // we always listen for the telegrams between the master and the panel1!
+	preparePollTelegram();
 
 	m_PropertyChangedCallback = NULL;
+	m_PropertiesChangedCallback = NULL;
 	m_StartSendingCallback = NULL;
 	m_StopSendingCallback = NULL;
 	m_LogCallback = NULL;
@@ -18,73 +19,63 @@ ValloxSerial::ValloxSerial()
 	m_TelegramChecksumFailureCallback = NULL;
 	m_UnexpectedByteReceivedCallbackFunction = NULL;
 	m_SuspendResumeCallbackFunction = NULL;
-
-	m_FanSpeed = 1;
-	m_TempInside = INITIAL_VALUE;
-	m_TempOutside = INITIAL_VALUE;
-	m_TempExhaust = INITIAL_VALUE;
-	m_TempIncomming = INITIAL_VALUE;
-
-	m_SelectStatus = INITIAL_VALUE;
-	m_PowerState = INITIAL_VALUE;
-	m_CO2AdjustState = INITIAL_VALUE;
-	m_HumidityAdjustState = INITIAL_VALUE;
-	m_HeatingState = INITIAL_VALUE;
-	m_FilterGuardIndicator = INITIAL_VALUE;
-	m_HeatingIndicator = INITIAL_VALUE;
-	m_FaultIndicator = INITIAL_VALUE;
-	m_ServiceReminderIndicator = INITIAL_VALUE;
-
-	m_Humidity = INITIAL_VALUE;
-	m_BasicHumidityLevel = INITIAL_VALUE;
-
-	m_HumiditySensor1 = INITIAL_VALUE;
-	m_HumiditySensor2 = INITIAL_VALUE;
-	m_CO2High = INITIAL_VALUE;
-	m_CO2Low = INITIAL_VALUE;
-	m_CO2SetPointHigh = INITIAL_VALUE;
-	m_CO2SetPointLow = INITIAL_VALUE;
-
-	m_FanSpeedMax = 8;
-	m_FanSpeedMin = 1;
-	m_DCFanInputAdjustment = INITIAL_VALUE;
-	m_DCFanOutputAdjustment = INITIAL_VALUE;
-	m_InputFanStopThreshold = INITIAL_VALUE;
-
-	m_HeatingSetPoint = INITIAL_VALUE;
-	m_PreHeatingSetPoint = INITIAL_VALUE;
-	m_HrcBypassThreshold = INITIAL_VALUE;
-	m_CellDefrostingThreshold = INITIAL_VALUE;
-
-	// program
-	m_AdjustmentIntervalMinutes = INITIAL_VALUE;
-	m_AutomaticHumidityLevelSeekerState = INITIAL_VALUE;
-	m_BoostSwitchMode = INITIAL_VALUE;
-	m_RadiatorType = INITIAL_VALUE;
-	m_CascadeAdjust = INITIAL_VALUE;
-
-	// program 2
-	m_MaxSpeedLimitMode = INITIAL_VALUE;
-
-	m_ServiceReminder = INITIAL_VALUE;
-	
-	// multi porpose ioport 1
-	m_PostHeatingOn = INITIAL_VALUE;
-
-	// multi porpose ioport 2
-	m_DamperMotorPosition = INITIAL_VALUE;
-	m_FaultSignalRelay = INITIAL_VALUE;
-	m_SupplyFanOff = INITIAL_VALUE;
-	m_PreHeatingOn = INITIAL_VALUE;
-	m_ExhaustFanOff = INITIAL_VALUE;
-	m_FirePlaceBoosterOn = INITIAL_VALUE;
-
-	m_IncommingCurrent = INITIAL_VALUE;
-	m_LastErrorNumber = INITIAL_VALUE;
-
-	m_InEfficiency = INITIAL_VALUE;
-	m_OutEfficiency = INITIAL_VALUE;
-	m_AverageEfficiency = INITIAL_VALUE;
+#ifdef ARDUINO
+	m_ClockFunction = millis;
+#else
+	m_ClockFunction = NULL;
+#endif
+	m_pTrace = NULL;
+	m_pEventQueue = NULL;
+
+	m_NotificationMode = NotifyPerProperty;
+#if VALLOX_SHARED_STORE
+	m_Unpublished = false;
+#endif
+
+	m_NonBlockingTransmit = false;
+	m_Transmitting = false;
+	m_TransmitStart = 0;
+
+	m_TxSuspended = false;
+	m_SuspendStart = 0;
+	m_SuspendTimeout = VALLOX_SUSPEND_TIMEOUT_MS;
+
+	m_PollTimeout = VALLOX_POLL_TIMEOUT_MS;
+	m_PollRetries = VALLOX_POLL_RETRIES;
+
+#if VALLOX_WRITE_TRANSACTIONS
+	m_WriteMode = WriteUnconfirmed;
+	m_WriteTimeout = VALLOX_WRITE_TIMEOUT_MS;
+	m_WriteRetries = VALLOX_WRITE_RETRIES;
+	m_WriteCompletedCallback = NULL;
+	m_pWriteCompletedContext = NULL;
+#endif
+
+#if VALLOX_SCHEDULER
+	m_ScheduleInterval = VALLOX_SCHEDULE_INTERVAL_MS;
+	m_LastScheduledPoll = 0;
+#endif
+	m_Ticking = false;
+
+	m_BusIdleTime = 0;
+	m_EchoCheck = false;
+	m_MaxRetries = 0;
+	m_LastBusActivity = 0;
+	m_ObservedBytes = 0;
+	m_BackoffStart = 0;
+	m_BackoffTime = 0;
+	m_BackoffRandom = 0xACE1 ^ m_SenderId; // any seed but 0
+	m_CurrentPending = false;
+	m_CurrentDeferred = false;
+	m_CurrentRetries = 0;
+	m_EchoPending = false;
+	m_EchoReceived = false;
+
+	m_Resynchronize = false;
+	m_Synchronized = true;
+	m_WindowLength = 0;
+
+	resetStatistics();
 }
 
 ValloxSerial::~ValloxSerial()
@@ -111,171 +102,83 @@ void ValloxSerial::setReceiverId(uint8_t receiverId)
 void ValloxSerial::setSenderId(uint8_t senderId)
 {
 	m_SenderId = senderId;
+	preparePollTelegram();
 }
 
-int8_t ValloxSerial::getValue(ValloxProperty propertyId) const
+void ValloxSerial::preparePollTelegram()
 {
-	int8_t value = INITIAL_VALUE;
-
-	switch (propertyId)
-	{
-	case FanSpeedProperty:
-		value = m_FanSpeed;
-		break;
-	case TempInsideProperty:
-		value = m_TempInside;
-		break;
-	case TempOutsideProperty:
-		value = m_TempOutside;
-		break;
-	case TempExhaustProperty:
-		value = m_TempExhaust;
-		break;
-	case TempIncommingProperty:
-		value = m_TempIncomming;
-		break;
-
-	case SelectStatusProperty:
-		value = m_SelectStatus;
-		break;
+	m_PollTelegram[0] = VALLOX_DOMAIN;
+	m_PollTelegram[1] = m_SenderId;
+	m_PollTelegram[2] = VALLOX_ADDRESS_MASTER;
+	m_PollTelegram[3] = VALLOX_VARIABLE_POLL;
+	m_PollTelegram[4] = 0;
+	m_PollChecksum = Vallox::calculateChecksum(m_PollTelegram);
+}
 
-	case PowerStateProperty:
-		value = m_PowerState;
-		break;
-	case CO2AdjustStateProperty:
-		value = m_CO2AdjustState;
-		break;
-	case HumidityAdjustStateProperty:
-		value = m_HumidityAdjustState;
-		break;
-	case HeatingStateProperty:
-		value = m_HeatingState;
-		break;
-	case FilterGuardIndicatorProperty:
-		value = m_FilterGuardIndicator;
-		break;
-	case HeatingIndicatorProperty:
-		value = m_HeatingIndicator;
-		break;
-	case FaultIndicatorProperty:
-		value = m_FaultIndicator;
-		break;
-	case ServiceReminderIndicatorProperty:
-		value = m_ServiceReminderIndicator;
-		break;
+void ValloxSerial::setResynchronize(bool resynchronize)
+{
+	m_Resynchronize = resynchronize;
+	m_Synchronized = true;
+	m_WindowLength = 0;
+}
 
-	case HumidityProperty:
-		value = m_Humidity;
-		break;
-	case BasicHumidityLevelProperty:
-		value = m_BasicHumidityLevel;
-		break;
-	case HumiditySensor1Property:
-		value = m_HumiditySensor1;
-		break;
-	case HumiditySensor2Property:
-		value = m_HumiditySensor2;
-		break;
+const ValloxStatistics& ValloxSerial::getStatistics() const
+{
+	return m_Statistics;
+}
 
-	case CO2HighProperty:
-		value = m_CO2High;
-		break;
-	case CO2LowProperty:
-		value = m_CO2Low;
-		break;
+void ValloxSerial::resetStatistics()
+{
+	memset(&m_Statistics, 0, sizeof(m_Statistics));
+	m_LastTelegramTime = 0;
+	m_RateStart = now();
+	m_RateBytes = 0;
+}
 
-	case CO2SetPointHighProperty:
-		value = m_CO2SetPointHigh;
-		break;
-	case CO2SetPointLowProperty:
-		value = m_CO2SetPointLow;
-		break;
+#if VALLOX_PROFILING
+ValloxProfiler& ValloxSerial::getProfiler()
+{
+	return m_Profiler;
+}
+#endif
 
-	case FanSpeedMaxProperty:
-		value = m_FanSpeedMax;
-		break;
-	case FanSpeedMinProperty:
-		value = m_FanSpeedMin;
-		break;
-	case DCFanInputAdjustmentProperty:
-		value = m_DCFanInputAdjustment;
-		break;
-	case DCFanOutputAdjustmentProperty:
-		value = m_DCFanOutputAdjustment;
-		break;
-	case InputFanStopThresholdProperty:
-		value = m_InputFanStopThreshold;
-		break;
-	case HeatingSetPointProperty:
-		value = m_HeatingSetPoint;
-		break;
-	case PreHeatingSetPointProperty:
-		value = m_PreHeatingSetPoint;
-		break;
-	case HrcBypassThresholdProperty:
-		value = m_HrcBypassThreshold;
-		break;
-	case CellDefrostingThresholdProperty:
-		value = m_CellDefrostingThreshold;
-		break;
+int8_t ValloxSerial::getValue(ValloxProperty propertyId) const
+{
+	return m_Properties.getValue(propertyId);
+}
 
-	case AdjustmentIntervalMinutesProperty:
-		value = m_AdjustmentIntervalMinutes;
-		break;
-	case AutomaticHumidityLevelSeekerStateProperty:
-		value = m_AutomaticHumidityLevelSeekerState;
-		break;
-	case BoostSwitchModeProperty:
-		value = m_BoostSwitchMode;
-		break;
-	case RadiatorTypeProperty:
-		value = m_RadiatorType;
-		break;
-	case CascadeAdjustProperty:
-		value = m_CascadeAdjust;
-		break;
+void ValloxSerial::snapshot(ValloxPropertyStore& store) const
+{
+	store = m_Properties;
+}
 
-	case MaxSpeedLimitModeProperty:
-		value = m_MaxSpeedLimitMode;
-		break;
-	case ServiceReminderProperty:
-		value = m_ServiceReminder;
-		break;
+#if VALLOX_SHARED_STORE
+const ValloxSharedStore& ValloxSerial::getSharedStore() const
+{
+	return m_SharedStore;
+}
+#endif
 
-	case PostHeatingOnProperty:
-		value = m_PostHeatingOn;
-		break;
-	case DamperMotorPositionProperty:
-		value = m_DamperMotorPosition;
-		break;
-	case FaultSignalRelayProperty:
-		value = m_FaultSignalRelay;
-		break;
-	case SupplyFanOffProperty:
-		value = m_SupplyFanOff;
-		break;
-	case PreHeatingOnProperty:
-		value = m_PreHeatingOn;
-		break;
-	case ExhaustFanOffProperty:
-		value = m_ExhaustFanOff;
-		break;
-	case FirePlaceBoosterOnProperty:
-		value = m_FirePlaceBoosterOn;
-		break;
-	case IncommingCurrentProperty:
-		value = m_IncommingCurrent;
-		break;
-	case LastErrorNumberProperty:
-		value = m_LastErrorNumber;
-		break;
+uint8_t ValloxSerial::changedSince(PropertyChangedCallbackFunction callbackFunction)
+{
+	uint8_t changedProperties = 0;
 
-	default:
-		value = INITIAL_VALUE;
-		break;
+	uint8_t index = 0;
+	while (m_Properties.getDirty().next(&index))
+	{
+		m_Properties.clearDirty(index);
+		(*callbackFunction)(ValloxPropertyStore::propertyAt(index), m_Properties.get(index));
+		changedProperties++;
+		index++;
 	}
 
-	return value;
+	return changedProperties;
+}
+
+void ValloxSerial::setNotificationMode(ValloxNotificationMode mode)
+{
+	onPropertiesChanged();
+	m_NotificationMode = mode;
 }
 
 void ValloxSerial::attachPropertyChanged(PropertyChangedCallbackFunction callbackFunction)
@@ -288,6 +191,39 @@ void ValloxSerial::detachPropertyChanged(PropertyChangedCallbackFunction callbac
 	m_PropertyChangedCallback = NULL;
 }
 
+void ValloxSerial::attachPropertiesChanged(PropertiesChangedCallbackFunction callbackFunction)
+{
+	m_PropertiesChangedCallback = callbackFunction;
+}
+
+void ValloxSerial::detachPropertiesChanged(PropertiesChangedCallbackFunction callbackFunction)
+{
+	m_PropertiesChangedCallback = NULL;
+}
+
+int8_t ValloxSerial::subscribe(PropertySubscriberFunction callbackFunction, void* pContext, const ValloxPropertyMask& properties, unsigned long minimumIntervalMs)
+{
+	// without a clock we can not hold back changes
+	return m_Subscribers.add(callbackFunction, pContext, properties, m_ClockFunction ? minimumIntervalMs : 0);
+}
+
+void ValloxSerial::unsubscribe(int8_t subscription)
+{
+	m_Subscribers.remove(subscription);
+}
+
+void ValloxSerial::attachClock(ClockFunction clockFunction)
+{
+	m_ClockFunction = clockFunction;
+	m_RateStart = now();
+	m_RateBytes = m_Statistics.receivedBytes;
+}
+
+void ValloxSerial::detachClock(ClockFunction clockFunction)
+{
+	m_ClockFunction = NULL;
+}
+
 
 void ValloxSerial::attach(StartSendingFunction startSendingCallback, StopSendingFunction stopSendingCallback)
 {
@@ -302,6 +238,32 @@ void ValloxSerial::detach(StartSendingFunction startSendingCallback, StopSending
 }
 
 
+void ValloxSerial::attachTrace(ValloxTrace* pTrace)
+{
+	m_pTrace = pTrace;
+}
+
+void ValloxSerial::detachTrace(ValloxTrace* pTrace)
+{
+	if (m_pTrace == pTrace)
+	{
+		m_pTrace = NULL;
+	}
+}
+
+void ValloxSerial::attachEventQueue(ValloxEventQueue* pEventQueue)
+{
+	m_pEventQueue = pEventQueue;
+}
+
+void ValloxSerial::detachEventQueue(ValloxEventQueue* pEventQueue)
+{
+	if (m_pEventQueue == pEventQueue)
+	{
+		m_pEventQueue = NULL;
+	}
+}
+
 void ValloxSerial::attachLogger(LogCallbackFunction callbackFunction)
 {
 	m_LogCallback = callbackFunction;
@@ -358,1048 +320,1325 @@ void ValloxSerial::detach(SuspendResumeCallbackFunction callbackFunction)
 
 
 
-void ValloxSerial::poll(ValloxProperty propertyId) const
+void ValloxSerial::poll(ValloxProperty propertyId)
 {
-	switch (propertyId)
-	{
-	case FanSpeedProperty:
-		send(VALLOX_VARIABLE_POLL, VALLOX_VARIABLE_FAN_SPEED);
-		break;
-	case TempInsideProperty:
-		send(VALLOX_VARIABLE_POLL, VALLOX_VARIABLE_TEMP_INSIDE);
-		break;
-	case TempOutsideProperty:
-		send(VALLOX_VARIABLE_POLL, VALLOX_VARIABLE_TEMP_OUTSIDE);
-		break;
-	case TempExhaustProperty:
-		send(VALLOX_VARIABLE_POLL, VALLOX_VARIABLE_TEMP_EXHAUST);
-		break;
-	case TempIncommingProperty:
-		send(VALLOX_VARIABLE_POLL, VALLOX_VARIABLE_TEMP_INCOMMING);
-		break;
+	pollVariable(readPropertyVariable(propertyId));
+}
 
-	// status bits
-	case PowerStateProperty:
-		send(VALLOX_VARIABLE_POLL, VALLOX_VARIABLE_SELECT);
-		break;
-	case CO2AdjustStateProperty:
-		send(VALLOX_VARIABLE_POLL, VALLOX_VARIABLE_SELECT);
-		break;
-	case HumidityAdjustStateProperty:
-		send(VALLOX_VARIABLE_POLL, VALLOX_VARIABLE_SELECT);
-		break;
-	case HeatingStateProperty:
-		send(VALLOX_VARIABLE_POLL, VALLOX_VARIABLE_SELECT);
-		break;
-	case FilterGuardIndicatorProperty:
-		send(VALLOX_VARIABLE_POLL, VALLOX_VARIABLE_SELECT);
-		break;
-	case HeatingIndicatorProperty:
-		send(VALLOX_VARIABLE_POLL, VALLOX_VARIABLE_SELECT);
-		break;
-	case FaultIndicatorProperty:
-		send(VALLOX_VARIABLE_POLL, VALLOX_VARIABLE_SELECT);
-		break;
-	case ServiceReminderIndicatorProperty:
-		send(VALLOX_VARIABLE_POLL, VALLOX_VARIABLE_SELECT);
-		break;
+bool ValloxSerial::poll(ValloxProperty propertyId, PollCompletedCallbackFunction callbackFunction, void* pContext)
+{
+	return pollVariable(readPropertyVariable(propertyId), callbackFunction, pContext);
+}
 
-	case HumidityProperty:
-		send(VALLOX_VARIABLE_POLL, VALLOX_VARIABLE_HUMIDITY);
-		break;
-	case BasicHumidityLevelProperty:
-		send(VALLOX_VARIABLE_POLL, VALLOX_VARIABLE_BASIC_HUMIDITY_LEVEL);
-		break;
-	case HumiditySensor1Property:
-		send(VALLOX_VARIABLE_POLL, VALLOX_VARIABLE_HUMIDITY_SENSOR1);
-		break;
-	case HumiditySensor2Property:
-		send(VALLOX_VARIABLE_POLL, VALLOX_VARIABLE_HUMIDITY_SENSOR2);
-		break;
+bool ValloxSerial::pollVariable(uint8_t variable, PollCompletedCallbackFunction callbackFunction, void* pContext)
+{
+	if (variable == VALLOX_VARIABLE_POLL)
+	{
+		// unknown property
+		return false;
+	}
 
-	case CO2HighProperty:
-		send(VALLOX_VARIABLE_POLL, VALLOX_VARIABLE_CO2_HIGH);
-		break;
-	case CO2LowProperty:
-		send(VALLOX_VARIABLE_POLL, VALLOX_VARIABLE_CO2_LOW);
-		break;
+	bool sendPoll = true;
+	bool tracked = m_PollTable.start(variable, callbackFunction, pContext, now(), &sendPoll);
+	// without a clock pending polls never time out, so we always send
+	if (sendPoll || !m_ClockFunction)
+	{
+		// a poll dropped during a suspension is sent again on the resume
+		if (!send(VALLOX_VARIABLE_POLL, variable, VALLOX_ADDRESS_MASTER, TransmitPoll) && tracked && !m_TxSuspended)
+		{
+			// no room in the queue, so it times out and is retried
+			m_PollTable.sent(variable, now());
+		}
+	}
 
-	case CO2SetPointHighProperty:
-		send(VALLOX_VARIABLE_POLL, VALLOX_VARIABLE_CO2_SET_POINT_UPPER);
-		break;
-	case CO2SetPointLowProperty:
-		send(VALLOX_VARIABLE_POLL, VALLOX_VARIABLE_CO2_SET_POINT_LOWER);
-		break;
+	return tracked;
+}
 
-	case FanSpeedMaxProperty:
-		send(VALLOX_VARIABLE_POLL, VALLOX_VARIABLE_FAN_SPEED_MAX);
-		break;
-	case FanSpeedMinProperty:
-		send(VALLOX_VARIABLE_POLL, VALLOX_VARIABLE_FAN_SPEED_MIN);
-		break;
-	case DCFanInputAdjustmentProperty:
-		send(VALLOX_VARIABLE_POLL, VALLOX_VARIABLE_DC_FAN_INPUT_ADJUSTMENT);
-		break;
-	case DCFanOutputAdjustmentProperty:
-		send(VALLOX_VARIABLE_POLL, VALLOX_VARIABLE_DC_FAN_OUTPUT_ADJUSTMENT);
-		break;
-	case InputFanStopThresholdProperty:
-		send(VALLOX_VARIABLE_POLL, VALLOX_VARIABLE_INPUT_FAN_STOP);
-		break;
-	case HeatingSetPointProperty:
-		send(VALLOX_VARIABLE_POLL, VALLOX_VARIABLE_HEATING_SET_POINT);
-		break;
-	case PreHeatingSetPointProperty:
-		send(VALLOX_VARIABLE_POLL, VALLOX_VARIABLE_PRE_HEATING_SET_POINT);
-		break;
-	case HrcBypassThresholdProperty:
-		send(VALLOX_VARIABLE_POLL, VALLOX_VARIABLE_HRC_BYPASS);
-		break;
-	case CellDefrostingThresholdProperty:
-		send(VALLOX_VARIABLE_POLL, VALLOX_VARIABLE_CELL_DEFROSTING);
-		break;
+uint8_t ValloxSerial::pollSet(const ValloxPropertyMask& mask)
+{
+	// several properties share a variable which is polled only once
+	uint8_t requested[32];
+	memset(requested, 0, sizeof(requested));
 
-	// program 
-	case AdjustmentIntervalMinutesProperty:
-		send(VALLOX_VARIABLE_POLL, VALLOX_VARIABLE_PROGRAM);
-		break;
-	case AutomaticHumidityLevelSeekerStateProperty:
-		send(VALLOX_VARIABLE_POLL, VALLOX_VARIABLE_PROGRAM);
-		break;
-	case BoostSwitchModeProperty:
-		send(VALLOX_VARIABLE_POLL, VALLOX_VARIABLE_PROGRAM);
-		break;
-	case RadiatorTypeProperty:
-		send(VALLOX_VARIABLE_POLL, VALLOX_VARIABLE_PROGRAM);
-		break;
-	case CascadeAdjustProperty:
-		send(VALLOX_VARIABLE_POLL, VALLOX_VARIABLE_PROGRAM);
-		break;
+	uint8_t count = 0;
+	for (uint8_t index = 0; mask.next(&index); index++)
+	{
+		uint8_t variable = readPropertyVariable(ValloxPropertyStore::propertyAt(index));
+		if (variable == VALLOX_VARIABLE_POLL || (requested[variable >> 3] & (1 << (variable & 7))))
+		{
+			continue;
+		}
 
-	// program 2
-	case MaxSpeedLimitModeProperty:
-		send(VALLOX_VARIABLE_POLL, VALLOX_VARIABLE_PROGRAM2);
-		break;
+		// the rest has to wait for the next call when the queue is full
+		if (m_NonBlockingTransmit && m_TransmitQueue.isFull(TransmitPoll))
+		{
+			break;
+		}
 
-	case ServiceReminderProperty:
-		send(VALLOX_VARIABLE_POLL, VALLOX_VARIABLE_SERVICE_REMINDER);
-		break;
+		requested[variable >> 3] |= 1 << (variable & 7);
+		pollVariable(variable);
+		count++;
+	}
 
-	// multi purpose io port 1
-	case PostHeatingOnProperty:
-		send(VALLOX_VARIABLE_POLL, VALLOX_VARIABLE_IOPORT_MULTI_PURPOSE_1);
-		break;
+	return count;
+}
 
-	// multi purpose io port 1
-	case DamperMotorPositionProperty:
-		send(VALLOX_VARIABLE_POLL, VALLOX_VARIABLE_IOPORT_MULTI_PURPOSE_2);
-		break;
-	case FaultSignalRelayProperty:
-		send(VALLOX_VARIABLE_POLL, VALLOX_VARIABLE_IOPORT_MULTI_PURPOSE_2);
-		break;
-	case SupplyFanOffProperty:
-		send(VALLOX_VARIABLE_POLL, VALLOX_VARIABLE_IOPORT_MULTI_PURPOSE_2);
-		break;
-	case PreHeatingOnProperty:
-		send(VALLOX_VARIABLE_POLL, VALLOX_VARIABLE_IOPORT_MULTI_PURPOSE_2);
-		break;
-	case ExhaustFanOffProperty:
-		send(VALLOX_VARIABLE_POLL, VALLOX_VARIABLE_IOPORT_MULTI_PURPOSE_2);
-		break;
-	case FirePlaceBoosterOnProperty:
-		send(VALLOX_VARIABLE_POLL, VALLOX_VARIABLE_IOPORT_MULTI_PURPOSE_2);
-		break;
+void ValloxSerial::setPollTimeout(uint16_t timeoutMs, uint8_t maxRetries)
+{
+	m_PollTimeout = timeoutMs;
+	m_PollRetries = maxRetries;
+}
 
-	case IncommingCurrentProperty:
-		send(VALLOX_VARIABLE_POLL, VALLOX_VARIABLE_CURRENT_INCOMMING);
-		break;
-	case LastErrorNumberProperty:
-		send(VALLOX_VARIABLE_POLL, VALLOX_VARIABLE_LAST_ERROR_NUMBER);
-		break;
+bool ValloxSerial::getPollStatistics(uint8_t variable, ValloxPollStatistics* pStatistics) const
+{
+	return m_PollTable.getStatistics(variable, pStatistics);
+}
 
-	// virtual properties for bit encoded values
-	case SelectStatusProperty:
-		send(VALLOX_VARIABLE_POLL, VALLOX_VARIABLE_SELECT);
-		break;
-	case ProgramProperty:
-		send(VALLOX_VARIABLE_POLL, VALLOX_VARIABLE_PROGRAM);
-		break;
-	case Program2Property:
-		send(VALLOX_VARIABLE_POLL, VALLOX_VARIABLE_PROGRAM2);
-		break;
-	case IoPortMultiPurpose1Property:
-		send(VALLOX_VARIABLE_POLL, VALLOX_VARIABLE_IOPORT_MULTI_PURPOSE_1);
-		break;
-	case IoPortMultiPurpose2Property:
-		send(VALLOX_VARIABLE_POLL, VALLOX_VARIABLE_IOPORT_MULTI_PURPOSE_2);
-		break;
+// resends polls without reply and gives up after the last retry
+void ValloxSerial::expirePolls()
+{
+	resendPolls(m_PollTable.expire(now(), m_PollTimeout, m_PollRetries));
+}
 
-	default:
-		// unknown property
-		break;
+void ValloxSerial::resendPolls(uint8_t slots)
+{
+	for (uint8_t slot = 0; slots != 0; slot++, slots >>= 1)
+	{
+		if (slots & 1)
+		{
+			// a retry of a poll which did not get out yet
+			uint8_t variable = m_PollTable.getVariable(slot);
+			if (isQueued(VALLOX_VARIABLE_POLL, variable, VALLOX_ADDRESS_MASTER))
+			{
+				continue;
+			}
+			if (!send(VALLOX_VARIABLE_POLL, variable, VALLOX_ADDRESS_MASTER, TransmitPoll))
+			{
+				m_PollTable.sent(variable, now());
+			}
+		}
 	}
 }
 
-
-
-void ValloxSerial::setFanSpeed(uint8_t value) const
+void ValloxSerial::setFanSpeed(uint8_t value)
 {
 	uint8_t fanSpeed = Vallox::convertBackFanSpeed(value-1); // -1 as index in array is zero based 0-7
-	send(VALLOX_VARIABLE_FAN_SPEED, fanSpeed);
+	writeVariable(VALLOX_VARIABLE_FAN_SPEED, fanSpeed);
 }
 
-void ValloxSerial::setFanSpeedMax(uint8_t value) const
+void ValloxSerial::setFanSpeedMax(uint8_t value)
 {
 	uint8_t fanSpeed = Vallox::convertBackFanSpeed(value - 1); // -1 as index in array is zero based 0-7
-	send(VALLOX_VARIABLE_FAN_SPEED_MAX, fanSpeed);
+	writeVariable(VALLOX_VARIABLE_FAN_SPEED_MAX, fanSpeed);
 }
 
-void ValloxSerial::setFanSpeedMin(uint8_t value) const
+void ValloxSerial::setFanSpeedMin(uint8_t value)
 {
 	uint8_t fanSpeed = Vallox::convertBackFanSpeed(value - 1); // -1 as index in array is zero based 0-7
-	send(VALLOX_VARIABLE_FAN_SPEED_MIN, fanSpeed);
+	writeVariable(VALLOX_VARIABLE_FAN_SPEED_MIN, fanSpeed);
 }
 
-void ValloxSerial::setDCFanInputAdjustment(uint8_t value) const
+void ValloxSerial::setDCFanInputAdjustment(uint8_t value)
 {
-	send(VALLOX_VARIABLE_DC_FAN_INPUT_ADJUSTMENT, value);
+	writeVariable(VALLOX_VARIABLE_DC_FAN_INPUT_ADJUSTMENT, value);
 }
 
-void ValloxSerial::setDCFanOutputAdjustment(uint8_t value) const
+void ValloxSerial::setDCFanOutputAdjustment(uint8_t value)
 {
-	send(VALLOX_VARIABLE_DC_FAN_OUTPUT_ADJUSTMENT, value);
+	writeVariable(VALLOX_VARIABLE_DC_FAN_OUTPUT_ADJUSTMENT, value);
 }
 
-void ValloxSerial::setHrcBypassThreshold(int8_t value) const
+void ValloxSerial::setHrcBypassThreshold(int8_t value)
 {
 	uint8_t temperature = Vallox::convertBackTemperature(value);
-	send(VALLOX_VARIABLE_HRC_BYPASS, temperature);
+	writeVariable(VALLOX_VARIABLE_HRC_BYPASS, temperature);
 }
 
-void ValloxSerial::setInputFanStopThreshold(int8_t value) const
+void ValloxSerial::setInputFanStopThreshold(int8_t value)
 {
 	uint8_t temperature = Vallox::convertBackTemperature(value);
-	send(VALLOX_VARIABLE_INPUT_FAN_STOP, temperature);
+	writeVariable(VALLOX_VARIABLE_INPUT_FAN_STOP, temperature);
 }
 
-void ValloxSerial::setHeatingSetPoint(int8_t value) const
+void ValloxSerial::setHeatingSetPoint(int8_t value)
 {
 	uint8_t temperature = Vallox::convertBackTemperature(value);
-	send(VALLOX_VARIABLE_HEATING_SET_POINT, temperature);
+	writeVariable(VALLOX_VARIABLE_HEATING_SET_POINT, temperature);
 }
 
-void ValloxSerial::setPreHeatingSetPoint(int8_t value) const
+void ValloxSerial::setPreHeatingSetPoint(int8_t value)
 {
 	uint8_t temperature = Vallox::convertBackTemperature(value);
-	send(VALLOX_VARIABLE_PRE_HEATING_SET_POINT, temperature);
+	writeVariable(VALLOX_VARIABLE_PRE_HEATING_SET_POINT, temperature);
 }
 
-void ValloxSerial::setCellDefrostingThreshold(int8_t value) const
+void ValloxSerial::setCellDefrostingThreshold(int8_t value)
 {
 	uint8_t temperature = Vallox::convertBackTemperature(value);
-	send(VALLOX_VARIABLE_CELL_DEFROSTING, temperature);
+	writeVariable(VALLOX_VARIABLE_CELL_DEFROSTING, temperature);
 }
 
-void ValloxSerial::setSelectStatus(int8_t value) const
+void ValloxSerial::setSelectStatus(int8_t value)
 {
-	send(VALLOX_VARIABLE_SELECT, value);
 	//send(VALLOX_VARIABLE_SELECT, value, VALLOX_ADDRESS_MAINBOARDS);
-	send(VALLOX_VARIABLE_POLL, VALLOX_VARIABLE_SELECT);
-}
-
-void ValloxSerial::send(uint8_t variable, uint8_t value, uint8_t destination) const
-{
-	// When C02 sensor communication is active we discard telegrams
-	if (!m_TxSuspended)
+	// a confirmed write reads the status back anyway
+	if (!writeVariable(VALLOX_VARIABLE_SELECT, value))
 	{
-		uint8_t telegram[VALLOX_LENGTH];
-		telegram[0] = VALLOX_DOMAIN;
-		telegram[1] = m_SenderId;
-		telegram[2] = destination;
-		telegram[3] = variable;
-		telegram[4] = value;
-		telegram[5] = Vallox::calculateChecksum(telegram);
-
-		onStartSending();
-		m_pTxSerial->write(telegram, VALLOX_LENGTH);
-		m_pTxSerial->flush();
-		onStopSending();
+		send(VALLOX_VARIABLE_POLL, VALLOX_VARIABLE_SELECT);
 	}
 }
 
-
-bool ValloxSerial::receive()
+// returns false if the telegram was dropped
+bool ValloxSerial::send(uint8_t variable, uint8_t value, uint8_t destination, ValloxTransmitPriority priority)
 {
-	bool telegramReceived = false;
-
-	// wait until at least one complete telegram is in the input buffer
-	if (m_pRxSerial->available() >= VALLOX_LENGTH)
+	// while telegrams kept during a suspension wait, a blocking send queues as well, so it can not overtake them
+	if (m_NonBlockingTransmit || m_TxSuspended || !m_TransmitQueue.isEmpty() || m_CurrentPending)
 	{
-		uint8_t domain = m_pRxSerial->read();
-
-		if (domain == VALLOX_DOMAIN)
+		// When C02 sensor communication is active only writes are kept until the resume
+		if (m_TxSuspended && priority != TransmitWrite)
 		{
-			uint8_t sender = m_pRxSerial->read();
-			uint8_t receiver = m_pRxSerial->read();
-			uint8_t command = m_pRxSerial->read();
-			uint8_t arg = m_pRxSerial->read();
-			uint8_t checksum = m_pRxSerial->read();
+			return false;
+		}
 
-			uint16_t computedChecksum = (domain + sender + receiver + command + arg) & 0x00ff;
-			if (checksum == computedChecksum)
-			{
-				bool handleTelegram = true;
-				if (m_TelegramReceivedCallback)
-				{
-					handleTelegram = (*m_TelegramReceivedCallback)(sender, receiver, command, arg);
-				}
+		ValloxQueuedTelegram telegram;
+		telegram.variable = variable;
+		telegram.value = value;
+		telegram.destination = destination;
 
-				// the callback may return false to avoid handling this telegram!
-				if (handleTelegram)
-				{
-					telegramReceived = onTelegramReceived(sender, receiver, command, arg);
-				}
-			}
-			else
+		bool queued = true;
+		if (priority == TransmitWrite && m_TransmitQueue.replace(priority, telegram))
+		{
+			m_Statistics.coalescedWrites++;
+		}
+		else if (priority == TransmitPoll && m_TransmitQueue.contains(priority, telegram))
+		{
+			// the poll did not get out yet
+		}
+		else if (m_TransmitQueue.push(priority, telegram))
+		{
+			if (priority == TransmitWrite)
 			{
-				if (m_TelegramChecksumFailureCallback)
-				{
-					(*m_TelegramChecksumFailureCallback)(sender, receiver, command, arg, checksum);
-				}
+				m_Statistics.queuedWrites++;
 			}
 		}
 		else
 		{
-			if (m_UnexpectedByteReceivedCallbackFunction)
+			if (priority == TransmitWrite)
 			{
-				(*m_UnexpectedByteReceivedCallbackFunction)(domain);
+				m_Statistics.droppedWrites++;
 			}
+			log("Transmit queue full");
+			queued = false;
 		}
+		tick();
+		return queued;
+	}
+	else
+	{
+		transmit(variable, value, destination);
+		m_pTxSerial->flush();
+		onStopSending();
+		return true;
 	}
-
-	return telegramReceived;
 }
 
-void ValloxSerial::calculateResults()
+// waiting in the queue or deferred by listen before talk
+// waiting in the queue or being sent
+bool ValloxSerial::isQueued(uint8_t variable, uint8_t value, uint8_t destination) const
 {
-	updateEfficiencies();
+	if (m_CurrentPending &&
+		m_CurrentTelegram.variable == variable &&
+		m_CurrentTelegram.value == value &&
+		m_CurrentTelegram.destination == destination)
+	{
+		return true;
+	}
+
+	ValloxQueuedTelegram telegram;
+	telegram.variable = variable;
+	telegram.value = value;
+	telegram.destination = destination;
+	return m_TransmitQueue.contains(TransmitPoll, telegram);
 }
 
-bool ValloxSerial::onTelegramReceived(uint8_t sender, uint8_t receiver, uint8_t command, uint8_t arg)
+// switches to sending and hands the telegram to the serial without waiting
+void ValloxSerial::transmit(uint8_t variable, uint8_t value, uint8_t destination)
 {
-	bool telegramReceived = true;
-
-	if (receiver == m_ReceiverId || receiver == m_SenderId || receiver == VALLOX_ADDRESS_PANELS)
+	if (variable == VALLOX_VARIABLE_POLL && destination == VALLOX_ADDRESS_MASTER)
 	{
-		uint8_t variable = command;
-		int8_t value = (int8_t)arg;
+		// the checksum is a plain sum, so the polled variable is simply added
+		m_PollTelegram[4] = value;
+		m_PollTelegram[5] = m_PollChecksum + value;
 
-		switch (variable)
-		{
-		case VALLOX_VARIABLE_IOPORT_FANSPEED_RELAYS:
-		{
-			// TODO
-			// convertIoPortFanSpeedRelays
-			break;
-		}
-		case VALLOX_VARIABLE_IOPORT_MULTI_PURPOSE_1:
-		{
-			updateMultiPurposeIoPort1(value);
-			break;
-		}
-		case VALLOX_VARIABLE_IOPORT_MULTI_PURPOSE_2:
-		{
-			updateMultiPurposeIoPort2(value);
-			break;
-		}
-		case VALLOX_VARIABLE_INSTALLED_CO2_SENSORS:
-		{
-			// TODO
-			// convertInstalledCO2Sensor
-			break;
-		}
-		case VALLOX_VARIABLE_CURRENT_INCOMMING:
-		{
-			updateCurrentIncomming(value);
-			break;
-		}
-		case VALLOX_VARIABLE_LAST_ERROR_NUMBER:
-		{
-			updateLastErrorNumber(value);
-			break;
-		}
-		case VALLOX_VARIABLE_POST_HEATING_ON_COUNTER:
-		{
-			// TODO
-			break;
-		}
-		case VALLOX_VARIABLE_POST_HEATING_OFF_TIME:
-		{
-			// TODO
-			break;
-		}
-		case VALLOX_VARIABLE_POST_HEATING_TARGET_VALUE:
-		{
-			// TODO
-			break;
-		}
-		case VALLOX_VARIABLE_FLAGS_1:
-		{
-			// TODO
-			// converFlags1
-			break;
-		}
-		case VALLOX_VARIABLE_FLAGS_2:
-		{
-			// TODO
-			// converFlags2
-			break;
-		}
-		case VALLOX_VARIABLE_FLAGS_3:
-		{
-			// TODO
-			// converFlags3
-			break;
-		}
-		case VALLOX_VARIABLE_FLAGS_4:
-		{
-			// TODO
-			// converFlags4
-			break;
-		}
-		case VALLOX_VARIABLE_FLAGS_5:
-		{
-			// TODO
-			// converFlags5
-			break;
-		}
-		case VALLOX_VARIABLE_FLAGS_6:
-		{
-			// TODO
-			// converFlags6
-			break;
-		}
-		case VALLOX_VARIABLE_FIRE_PLACE_BOOSTER_COUNTER:
-		{
-			// TODO
-			break;
-		}
-		case VALLOX_VARIABLE_MAINTENANCE_MONTH_COUNTER:
-		{
-			// TODO
-			break;
-		}
-		case VALLOX_VARIABLE_FAN_SPEED:
-		{
-			int fanSpeed = Vallox::convertFanSpeed(value);
-			updateFanSpeed(fanSpeed);
-			break;
-		}
-		case VALLOX_VARIABLE_TEMP_OUTSIDE:
-		{
-			int temperature = Vallox::convertTemperature(value);
-			updateTempOutside(temperature);
-			break;
-		}
-		case VALLOX_VARIABLE_TEMP_EXHAUST:
-		{
-			int temperature = Vallox::convertTemperature(value);
-			updateTempExhaust(temperature);
-			break;
-		}
-		case VALLOX_VARIABLE_TEMP_INSIDE:
+		onStartSending();
+		m_pTxSerial->write(m_PollTelegram, VALLOX_LENGTH);
+		m_Statistics.transmittedTelegrams++;
+		if (m_PollTable.hasPending())
 		{
-			int temperature = Vallox::convertTemperature(value);
-			updateTempInside(temperature);
-			break;
+			m_PollTable.sent(value, now());
 		}
-		case VALLOX_VARIABLE_TEMP_INCOMMING:
+#if VALLOX_WRITE_TRANSACTIONS
+		if (m_WriteTable.hasPending())
 		{
-			int temperature = Vallox::convertTemperature(value);
-			updateTempIncomming(temperature);
-			break;
+			m_WriteTable.polled(value);
 		}
-		case VALLOX_VARIABLE_SELECT:
+#endif
+		if (m_pTrace)
 		{
-			updateSelectStatus(value);
-			break;
+			m_pTrace->recordTelegram(m_PollTelegram, true, now());
 		}
+		return;
+	}
 
-		case VALLOX_VARIABLE_HUMIDITY:
-		{
-			updateHumidity(value);
-			break;
-		}
-		case VALLOX_VARIABLE_BASIC_HUMIDITY_LEVEL:
-		{
-			updateBasicHumidityLevel(value);
-			break;
-		}
-		case VALLOX_VARIABLE_HUMIDITY_SENSOR1:
-		{
-			updateHumiditySensor1(value);
-			break;
-		}
-		case VALLOX_VARIABLE_HUMIDITY_SENSOR2:
-		{
-			updateHumiditySensor2(value);
-			break;
-		}
+	uint8_t telegram[VALLOX_LENGTH];
+	telegram[0] = VALLOX_DOMAIN;
+	telegram[1] = m_SenderId;
+	telegram[2] = destination;
+	telegram[3] = variable;
+	telegram[4] = value;
+	telegram[5] = Vallox::calculateChecksum(telegram);
+
+	onStartSending();
+	m_pTxSerial->write(telegram, VALLOX_LENGTH);
+	m_Statistics.transmittedTelegrams++;
+#if VALLOX_WRITE_TRANSACTIONS
+	if (m_WriteTable.hasPending())
+	{
+		m_WriteTable.sent(variable);
+	}
+#endif
+	if (m_pTrace)
+	{
+		m_pTrace->recordTelegram(telegram, true, now());
+	}
+}
 
-		case VALLOX_VARIABLE_CO2_HIGH:
-		{
-			updateCO2High(value);
-			break;
-		}
-		case VALLOX_VARIABLE_CO2_LOW:
-		{
-			updateCO2Low(value);
-			break;
-		}
-		case VALLOX_VARIABLE_CO2_SET_POINT_UPPER:
-		{
-			updateCO2SetPointHigh(value);
-			break;
-		}
-		case VALLOX_VARIABLE_CO2_SET_POINT_LOWER:
-		{
-			updateCO2SetPointLow(value);
-			break;
-		}
+void ValloxSerial::setNonBlockingTransmit(bool nonBlocking)
+{
+	m_NonBlockingTransmit = nonBlocking;
+}
 
-		case VALLOX_VARIABLE_FAN_SPEED_MAX:
-		{
-			uint8_t fanSpeed = Vallox::convertFanSpeed(value);
-			updateFanSpeedMax(fanSpeed);
-			break;
-		}
-		case VALLOX_VARIABLE_FAN_SPEED_MIN:
-		{
-			uint8_t fanSpeed = Vallox::convertFanSpeed(value);
-			updateFanSpeedMin(fanSpeed);
-			break;
-		}
-		case VALLOX_VARIABLE_DC_FAN_OUTPUT_ADJUSTMENT:
-		{
-			updateDCFanOutputAdjustment(value);
-			break;
-		}
-		case VALLOX_VARIABLE_DC_FAN_INPUT_ADJUSTMENT:
-		{
-			updateDCFanInputAdjustment(value);
-			break;
-		}
-		case VALLOX_VARIABLE_INPUT_FAN_STOP:
-		{
-			int8_t temperature = Vallox::convertTemperature(value);
-			updateInputFanStopThreshold(temperature);
-			break;
-		}
+#if VALLOX_SCHEDULER
+bool ValloxSerial::schedule(ValloxProperty propertyId, uint16_t maxAgeSeconds, uint8_t priority)
+{
+	uint8_t variable = readPropertyVariable(propertyId);
+	return variable != VALLOX_VARIABLE_POLL && m_Scheduler.add(variable, maxAgeSeconds, priority, now());
+}
 
-		case VALLOX_VARIABLE_HEATING_SET_POINT:
-		{
-			int temperature = Vallox::convertTemperature(value);
-			updateHeatingSetPoint(temperature);
-			break;
-		}
-		case VALLOX_VARIABLE_PRE_HEATING_SET_POINT:
+bool ValloxSerial::schedule(ValloxProperty propertyId)
+{
+	ValloxVariableDescriptor descriptor;
+	readVariableDescriptor(readPropertyVariable(propertyId), &descriptor);
+
+	if (descriptor.type & VALLOX_FLAG_BROADCAST)
+	{
+		return schedule(propertyId, VALLOX_MAX_AGE_BROADCAST, 0);
+	}
+	if (descriptor.type & VALLOX_FLAG_SETTING)
+	{
+		return schedule(propertyId, VALLOX_MAX_AGE_SETTING, 0);
+	}
+	return schedule(propertyId, VALLOX_MAX_AGE_STATUS, 1);
+}
+
+void ValloxSerial::unschedule(ValloxProperty propertyId)
+{
+	m_Scheduler.remove(readPropertyVariable(propertyId));
+}
+
+void ValloxSerial::setScheduleInterval(uint16_t intervalMs)
+{
+	m_ScheduleInterval = intervalMs;
+}
+
+// polls the most urgent scheduled variable, at most one per schedule interval and only when nothing else waits for the bus
+void ValloxSerial::pollScheduled()
+{
+	unsigned long time = now();
+	if (m_ClockFunction && !m_TxSuspended &&
+		time - m_LastScheduledPoll >= m_ScheduleInterval &&
+		m_TransmitQueue.isEmpty() &&
+		!m_CurrentPending)
+	{
+		uint8_t variable;
+		unsigned long holdOff = (unsigned long)m_PollTimeout * (m_PollRetries + 1);
+		if (m_Scheduler.next(time, holdOff, &variable))
 		{
-			int temperature = Vallox::convertTemperature(value);
-			updatePreHeatingSetPoint(temperature);
-			break;
+			m_LastScheduledPoll = time;
+			pollVariable(variable);
 		}
-		case VALLOX_VARIABLE_HRC_BYPASS:
+	}
+}
+#endif
+
+#if VALLOX_WRITE_TRANSACTIONS
+void ValloxSerial::setWriteMode(ValloxWriteMode mode)
+{
+	m_WriteMode = mode;
+}
+
+void ValloxSerial::setWriteTimeout(uint16_t timeoutMs, uint8_t maxRetries)
+{
+	m_WriteTimeout = timeoutMs;
+	m_WriteRetries = maxRetries;
+}
+#endif
+
+bool ValloxSerial::writeVariable(uint8_t variable, uint8_t value)
+{
+#if VALLOX_WRITE_TRANSACTIONS
+	// without a clock a write could never time out
+	if (m_WriteMode == WriteUnconfirmed || !m_ClockFunction)
+	{
+		send(variable, value);
+		return false;
+	}
+
+	bool started;
+	int8_t slot = m_WriteTable.start(variable, value, now(), &started);
+	if (slot < 0)
+	{
+		log("Too many writes pending");
+		send(variable, value);
+		return false;
+	}
+
+	if (started)
+	{
+		ValloxProperty properties[VALLOX_MAX_VARIABLE_PROPERTIES];
+		uint8_t count = getVariableProperties(variable, properties);
+		int8_t* pPrevious = m_WriteTable.getPrevious(slot);
+		for (uint8_t i = 0; i < count; i++)
 		{
-			int8_t temperature = Vallox::convertTemperature(value);
-			updateHRCBypassThreshold(temperature);
-			break;
+			pPrevious[i] = getValue(properties[i]);
 		}
-		case VALLOX_VARIABLE_CELL_DEFROSTING:
+	}
+
+	if (m_WriteMode == WriteOptimistic)
+	{
+		decodeVariable(variable, value);
+		publish();
+		if (m_NotificationMode == NotifyPerTelegram)
 		{
-			int temperature = Vallox::convertTemperature(value);
-			updateCellDefrostingThreshold(temperature);
-			break;
+			onPropertiesChanged();
 		}
+	}
+
+	send(variable, value);
+	pollWritten(variable);
+	return true;
+#else
+	send(variable, value);
+	return false;
+#endif
+}
+
+#if VALLOX_WRITE_TRANSACTIONS
+void ValloxSerial::attachWriteCompleted(WriteCompletedCallbackFunction callbackFunction, void* pContext)
+{
+	m_WriteCompletedCallback = callbackFunction;
+	m_pWriteCompletedContext = pContext;
+}
+
+void ValloxSerial::detachWriteCompleted(WriteCompletedCallbackFunction callbackFunction)
+{
+	if (m_WriteCompletedCallback == callbackFunction)
+	{
+		m_WriteCompletedCallback = NULL;
+		m_pWriteCompletedContext = NULL;
+	}
+}
+
+bool ValloxSerial::getWriteStatistics(uint8_t variable, ValloxWriteStatistics* pStatistics) const
+{
+	return m_WriteTable.getStatistics(variable, pStatistics);
+}
 
-		case VALLOX_VARIABLE_PROGRAM:
+// writes again if the master did not report the value in time and gives up after the last retry
+void ValloxSerial::expireWrites()
+{
+	uint8_t failed;
+	uint8_t retry = m_WriteTable.expire(now(), m_WriteTimeout, m_WriteRetries, &failed);
+	for (uint8_t slot = 0; retry != 0; slot++, retry >>= 1)
+	{
+		if (retry & 1)
 		{
-			updateProgram(value);
-			break;
+			rewrite(slot);
 		}
-		case VALLOX_VARIABLE_PROGRAM2:
+	}
+
+	for (uint8_t slot = 0; failed != 0; slot++, failed >>= 1)
+	{
+		if (failed & 1)
 		{
-			updateProgram2(value);
-			break;
+			// unless the master read back another value, the properties show ours
+			if (m_WriteMode == WriteOptimistic && !m_WriteTable.isRejected(slot))
+			{
+				restoreProperties(slot);
+			}
+			m_WriteTable.finish(slot);
+			onWriteCompleted(slot, false);
 		}
+	}
+
+	publish();
+}
+
+void ValloxSerial::rewrite(uint8_t slot)
+{
+	uint8_t variable = m_WriteTable.getVariable(slot);
+	uint8_t value = m_WriteTable.getValue(slot);
+
+	if (m_WriteMode == WriteOptimistic)
+	{
+		decodeVariable(variable, value);
+	}
+
+	send(variable, value);
+	pollWritten(variable);
+}
+
+// the read back has to follow the write on the bus, a poll already sent or being sent reads the old value
+void ValloxSerial::pollWritten(uint8_t variable)
+{
+	bool sendPoll = true;
+	bool tracked = m_PollTable.start(variable, NULL, NULL, now(), &sendPoll);
+	if (!sendPoll)
+	{
+		// a queued poll goes out after the write anyway, one on its way is followed by another
+		// and the timeout waits for that one, whose reply confirms the write
+		m_PollTable.resend(variable);
+	}
+	if (!send(VALLOX_VARIABLE_POLL, variable, VALLOX_ADDRESS_MASTER, TransmitPoll) && tracked && !m_TxSuspended)
+	{
+		// no room in the queue, so it times out and is retried
+		m_PollTable.sent(variable, now());
+	}
+}
+
+void ValloxSerial::restoreProperties(uint8_t slot)
+{
+	ValloxProperty properties[VALLOX_MAX_VARIABLE_PROPERTIES];
+	uint8_t count = getVariableProperties(m_WriteTable.getVariable(slot), properties);
+	const int8_t* pPrevious = m_WriteTable.getPrevious(slot);
+	for (uint8_t i = 0; i < count; i++)
+	{
+		updateProperty(properties[i], pPrevious[i]);
+	}
+
+	if (m_NotificationMode == NotifyPerTelegram)
+	{
+		onPropertiesChanged();
+	}
+}
+
+void ValloxSerial::onWriteCompleted(uint8_t slot, bool confirmed)
+{
+	if (!confirmed)
+	{
+		log("Write failed");
+	}
+
+	if (m_WriteCompletedCallback)
+	{
+		VALLOX_PROFILE(ProfileWriteCallback);
+		(*m_WriteCompletedCallback)(m_pWriteCompletedContext, m_WriteTable.getVariable(slot), confirmed,
+			m_WriteTable.getValue(slot), m_WriteTable.getLatency(slot, now()));
+	}
+}
+
+// the properties decoded from a variable: its raw value first, then its bits
+uint8_t ValloxSerial::getVariableProperties(uint8_t variable, ValloxProperty* pProperties)
+{
+	ValloxVariableDescriptor descriptor;
+	readVariableDescriptor(variable, &descriptor);
+
+	uint8_t count = 0;
+	if (descriptor.property != VALLOX_NO_PROPERTY)
+	{
+		pProperties[count++] = (ValloxProperty)descriptor.property;
+	}
 
-		case VALLOX_VARIABLE_SERVICE_REMINDER:
+	if ((descriptor.type & VALLOX_DECODER_MASK) == VALLOX_DECODE_BITFIELD)
+	{
+		for (uint8_t i = 0; i < descriptor.bitfieldCount; i++)
 		{
-			updateServiceReminder(value);
-			break;
+			ValloxBitfieldDescriptor bitfield;
+			readBitfieldDescriptor(descriptor.firstBitfield + i, &bitfield);
+			pProperties[count++] = (ValloxProperty)bitfield.property;
 		}
+	}
+
+	return count;
+}
+#endif
+
+void ValloxSerial::setSuspendTimeout(uint16_t timeoutMs)
+{
+	m_SuspendTimeout = timeoutMs;
+}
 
-		case VALLOX_VARIABLE_UNKNOWN:
+bool ValloxSerial::isSuspended() const
+{
+	return m_TxSuspended;
+}
+
+void ValloxSerial::setListenBeforeTalk(uint8_t idleCharacters, bool echoCheck, uint8_t maxRetries)
+{
+	// rounded up and one more for the resolution of the clock
+	m_BusIdleTime = idleCharacters > 0 ? ((uint32_t)idleCharacters * VALLOX_CHARACTER_TIME_US + 999) / 1000 + 1 : 0;
+	m_EchoCheck = echoCheck;
+	m_MaxRetries = maxRetries;
+}
+
+void ValloxSerial::tick()
+{
+	// sending from here calls us again
+	if (m_Ticking)
+	{
+		return;
+	}
+	m_Ticking = true;
+
+	observeBus();
+
+	if (m_ClockFunction)
+	{
+		updateByteRate();
+	}
+
+	// the timeouts do not run while nothing can be sent
+	if (m_PollTable.hasPending() && !m_TxSuspended)
+	{
+		expirePolls();
+	}
+
+#if VALLOX_WRITE_TRANSACTIONS
+	if (m_WriteTable.hasPending() && !m_TxSuspended)
+	{
+		expireWrites();
+	}
+#endif
+
+	if (m_TxSuspended && m_SuspendTimeout != 0 && m_ClockFunction &&
+		now() - m_SuspendStart >= m_SuspendTimeout)
+	{
+		log("Resume missed");
+		m_Statistics.missedResumes++;
+		onSuspended(false);
+	}
+
+#if VALLOX_SCHEDULER
+	if (!m_Scheduler.isEmpty())
+	{
+		pollScheduled();
+	}
+#endif
+
+	transmitNext();
+
+	m_Ticking = false;
+}
+
+void ValloxSerial::transmitNext()
+{
+	if (m_Transmitting)
+	{
+		if (!isTransmitComplete())
 		{
-			break;
+			return;
 		}
 
-		// C02 communication starts: no tx allowed!
-		case VALLOX_VARIABLE_SUSPEND:
+		m_Transmitting = false;
+		onStopSending();
+	}
+
+	if (m_EchoPending && !checkEcho())
+	{
+		return;
+	}
+
+	// the writes wait for the end of the CO2 sensor communication
+	if (m_TxSuspended)
+	{
+		return;
+	}
+
+	if (!m_CurrentPending)
+	{
+		if (!m_TransmitQueue.pop(&m_CurrentTelegram))
 		{
-			onSuspended(true);
-			break;
+			return;
 		}
 
-		// C02 communication ends: tx allowed!
-		case VALLOX_VARIABLE_RESUME:
+		m_CurrentPending = true;
+		m_CurrentDeferred = false;
+		m_CurrentRetries = 0;
+	}
+
+	if (!isBusIdle())
+	{
+		if (!m_CurrentDeferred)
 		{
-			onSuspended(false);
-			break;
+			m_CurrentDeferred = true;
+			m_Statistics.deferredTelegrams++;
 		}
+		return;
+	}
+
+	transmit(m_CurrentTelegram.variable, m_CurrentTelegram.value, m_CurrentTelegram.destination);
+	m_CurrentPending = false;
+
+	if (m_ClockFunction)
+	{
+		m_TransmitStart = now();
+		m_Transmitting = true;
 
-		default:
+		if (m_EchoCheck && m_BusIdleTime != 0)
 		{
-			log("Unkown command received");
-			telegramReceived = false;
-			break;
+			// keep the telegram for a retry until the echo was seen
+			m_CurrentPending = true;
+			m_EchoPending = true;
+			m_EchoReceived = false;
 		}
-		}//switch
 	}
 	else
 	{
-		// telegram was not meant for us.
+		// without a clock we can not tell when the telegram is out
+		m_pTxSerial->flush();
+		onStopSending();
 	}
-
-	return telegramReceived;
 }
 
+// the serial buffers the telegram, so we estimate when the last bit has left
+bool ValloxSerial::isTransmitComplete() const
+{
+	return now() - m_TransmitStart > VALLOX_TELEGRAM_DURATION_MS;
+}
 
+// remembers when bytes were last seen on the bus: any change of the
+// receive buffer since the last look means bytes have arrived recently.
+void ValloxSerial::observeBus()
+{
+	if (m_BusIdleTime != 0)
+	{
+		int available = m_pRxSerial->available();
+		if (available != m_ObservedBytes)
+		{
+			m_ObservedBytes = available;
+			m_LastBusActivity = now();
+		}
+	}
+}
 
-void ValloxSerial::updateFanSpeed(int8_t fanSpeed)
+bool ValloxSerial::isBusIdle() const
 {
-	if (m_FanSpeed != fanSpeed)
+	if (m_BusIdleTime == 0)
 	{
-		m_FanSpeed = fanSpeed;
-		onPropertyChanged(FanSpeedProperty, fanSpeed);
+		return true;
 	}
+
+	unsigned long time = now();
+	return time - m_LastBusActivity >= m_BusIdleTime &&
+		time - m_BackoffStart >= m_BackoffTime;
 }
 
-void ValloxSerial::updateTempInside(int8_t temperature)
+// a complete telegram is waiting to be decoded
+bool ValloxSerial::isTelegramWaiting() const
 {
-	if (m_TempInside != temperature)
+	return m_pRxSerial->available() + m_WindowLength >= VALLOX_LENGTH;
+}
+
+// our own telegram has to come back unchanged, otherwise somebody talked at the same time.
+// returns false while we are still waiting for the echo.
+bool ValloxSerial::checkEcho()
+{
+	if (!m_EchoReceived)
+	{
+		// wait until the echo had the chance to arrive and to be decoded
+		if (isTelegramWaiting() || now() - m_TransmitStart <= (unsigned long)VALLOX_TELEGRAM_DURATION_MS + m_BusIdleTime)
+		{
+			return false;
+		}
+
+		m_Statistics.collisions++;
+		if (m_CurrentRetries < m_MaxRetries)
+		{
+			m_CurrentRetries++;
+			m_Statistics.retransmittedTelegrams++;
+			backoff();
+		}
+		else
+		{
+			m_Statistics.droppedTelegrams++;
+			m_CurrentPending = false;
+			log("Telegram dropped after collisions");
+		}
+	}
+	else
 	{
-		m_TempInside = temperature;
-		onPropertyChanged(TempInsideProperty, temperature);
+		m_CurrentPending = false;
 	}
+
+	m_EchoPending = false;
+	return true;
 }
 
-void ValloxSerial::updateTempOutside(int8_t temperature)
+// random delay of up to 2^retries telegrams so that colliding senders do not meet again
+void ValloxSerial::backoff()
 {
-	if (m_TempOutside != temperature)
-	{
-		m_TempOutside = temperature;
-		onPropertyChanged(TempOutsideProperty, temperature);
-	}
+	m_BackoffRandom ^= m_BackoffRandom << 7;
+	m_BackoffRandom ^= m_BackoffRandom >> 9;
+	m_BackoffRandom ^= m_BackoffRandom << 8;
+
+	uint16_t window = (uint16_t)VALLOX_TELEGRAM_DURATION_MS << (m_CurrentRetries < 8 ? m_CurrentRetries : 8);
+	m_BackoffStart = now();
+	m_BackoffTime = m_BackoffRandom % window;
 }
 
-void ValloxSerial::updateTempExhaust(int8_t temperature)
+bool ValloxSerial::isTransmitting() const
 {
-	if (m_TempExhaust != temperature)
-	{
-		m_TempExhaust = temperature;
-		onPropertyChanged(TempExhaustProperty, temperature);
-	}
+	return m_Transmitting;
 }
 
-void ValloxSerial::updateTempIncomming(int8_t temperature)
+uint8_t ValloxSerial::getQueuedTelegrams() const
 {
-	if (m_TempIncomming != temperature)
-	{
-		m_TempIncomming = temperature;
-		onPropertyChanged(TempIncommingProperty, temperature);
-	}
+	return m_TransmitQueue.size();
 }
 
-void ValloxSerial::updateSelectStatus(int8_t select)
-{
-	if (m_SelectStatus != select)
-	{
-		m_SelectStatus = select;
-		onPropertyChanged(SelectStatusProperty, m_SelectStatus);
-	}
 
-	bool powerState;
-	bool co2AdjustState;
-	bool humidityAdjustState;
-	bool heatingState;
-	bool filterGuardIndicator;
-	bool heatingIndicator;
-	bool faultIndicator;
-	bool serviceReminderIndicator;
+bool ValloxSerial::receive()
+{
+	VALLOX_PROFILE(ProfileReceive);
+	bool telegramReceived = false;
 
-	Vallox::convertSelect(select,
-		&powerState, 
-		&co2AdjustState, 
-		&humidityAdjustState, 
-		&heatingState,
-		&filterGuardIndicator, 
-		&heatingIndicator, 
-		&faultIndicator,
-		&serviceReminderIndicator);
+	observeBus();
 
-	if (m_PowerState != powerState)
+	if (m_Resynchronize)
 	{
-		m_PowerState = powerState;
-		onPropertyChanged(PowerStateProperty, m_PowerState);
+		receiveWindow(&telegramReceived);
 	}
-
-	if (m_CO2AdjustState != co2AdjustState)
+	else
 	{
-		m_CO2AdjustState = co2AdjustState;
-		onPropertyChanged(CO2AdjustStateProperty, m_CO2AdjustState);
+		receiveTelegram(&telegramReceived);
 	}
 
-	if (m_HumidityAdjustState != humidityAdjustState)
+	if (m_NotificationMode == NotifyPerReceive)
 	{
-		m_HumidityAdjustState = humidityAdjustState;
-		onPropertyChanged(HumidityAdjustStateProperty, m_HumidityAdjustState);
+		onPropertiesChanged();
 	}
+	onSubscriptionsPending();
 
-	if (m_HeatingState != heatingState)
-	{
-		m_HeatingState = heatingState;
-		onPropertyChanged(HeatingStateProperty, m_HeatingState);
-	}
+	tick();
+
+	return telegramReceived;
+}
+
+uint16_t ValloxSerial::receiveAll(uint16_t maxTelegrams, int* pPendingBytes)
+{
+	VALLOX_PROFILE(ProfileReceive);
+	uint16_t processedTelegrams = 0;
+	bool telegramReceived = false;
+
+	observeBus();
 
-	if (m_FilterGuardIndicator != filterGuardIndicator)
+	if (m_Resynchronize)
 	{
-		m_FilterGuardIndicator = filterGuardIndicator;
-		onPropertyChanged(FilterGuardIndicatorProperty, m_FilterGuardIndicator);
+		while ((maxTelegrams == 0 || processedTelegrams < maxTelegrams) && receiveWindow(&telegramReceived))
+		{
+			processedTelegrams++;
+		}
 	}
-
-	if (m_HeatingIndicator != heatingIndicator)
+	else
 	{
-		m_HeatingIndicator = heatingIndicator;
-		onPropertyChanged(HeatingIndicatorProperty, m_HeatingIndicator);
+		while ((maxTelegrams == 0 || processedTelegrams < maxTelegrams) && m_pRxSerial->available() >= VALLOX_LENGTH)
+		{
+			if (receiveTelegram(&telegramReceived))
+			{
+				processedTelegrams++;
+			}
+		}
 	}
 
-	if (m_FaultIndicator != faultIndicator)
+	if (pPendingBytes)
 	{
-		m_FaultIndicator = faultIndicator;
-		onPropertyChanged(FaultIndicatorProperty, m_FaultIndicator);
+		*pPendingBytes = m_pRxSerial->available() + m_WindowLength;
 	}
 
-	if (m_ServiceReminderIndicator != serviceReminderIndicator)
+	if (m_NotificationMode == NotifyPerReceive)
 	{
-		m_ServiceReminderIndicator = serviceReminderIndicator;
-		onPropertyChanged(ServiceReminderIndicatorProperty, m_ServiceReminderIndicator);
+		onPropertiesChanged();
 	}
-}
+	onSubscriptionsPending();
 
+	tick();
 
-void ValloxSerial::updateHumidity(int8_t humidity)
-{
-	if (m_Humidity != humidity)
-	{
-		m_Humidity = humidity;
-		onPropertyChanged(HumidityProperty, m_Humidity);
-	}
+	return processedTelegrams;
 }
 
-void ValloxSerial::updateBasicHumidityLevel(int8_t value)
+// reads one telegram at once: a checksum failure drops all 6 bytes.
+// returns true if a telegram with a valid checksum was processed.
+bool ValloxSerial::receiveTelegram(bool* pTelegramReceived)
 {
-	if (m_BasicHumidityLevel != value)
-	{
-		m_BasicHumidityLevel = value;
-		onPropertyChanged(BasicHumidityLevelProperty, m_BasicHumidityLevel);
-	}
-}
+	bool telegramProcessed = false;
 
-void ValloxSerial::updateHumiditySensor1(int8_t value)
-{
-	if (m_HumiditySensor1 != value)
+	// wait until at least one complete telegram is in the input buffer
+	if (m_pRxSerial->available() >= VALLOX_LENGTH)
 	{
-		m_HumiditySensor1 = value;
-		onPropertyChanged(HumiditySensor1Property, m_HumiditySensor1);
-	}
-}
+		uint8_t domain = m_pRxSerial->read();
+		m_Statistics.receivedBytes++;
 
-void ValloxSerial::updateHumiditySensor2(int8_t value)
-{
-	if (m_HumiditySensor2 != value)
-	{
-		m_HumiditySensor2 = value;
-		onPropertyChanged(HumiditySensor2Property, m_HumiditySensor2);
-	}
-}
+		if (domain == VALLOX_DOMAIN)
+		{
+			m_Statistics.receivedBytes += VALLOX_LENGTH - 1;
+			uint8_t sender = m_pRxSerial->read();
+			uint8_t receiver = m_pRxSerial->read();
+			uint8_t command = m_pRxSerial->read();
+			uint8_t arg = m_pRxSerial->read();
+			uint8_t checksum = m_pRxSerial->read();
 
-void ValloxSerial::updateCO2High(int8_t value)
-{
-	if (m_CO2High != value)
-	{
-		m_CO2High = value;
-		onPropertyChanged(CO2HighProperty, m_CO2High);
+			uint16_t computedChecksum = (domain + sender + receiver + command + arg) & 0x00ff;
+			if (checksum == computedChecksum)
+			{
+				*pTelegramReceived = processTelegram(sender, receiver, command, arg);
+				telegramProcessed = true;
+			}
+			else
+			{
+				m_Statistics.checksumFailures++;
+				if (m_pTrace)
+				{
+					uint8_t telegram[VALLOX_LENGTH] = { domain, sender, receiver, command, arg, checksum };
+					m_pTrace->recordChecksumFailure(telegram, now());
+				}
+				if (m_TelegramChecksumFailureCallback)
+				{
+					(*m_TelegramChecksumFailureCallback)(sender, receiver, command, arg, checksum);
+				}
+			}
+		}
+		else
+		{
+			m_Statistics.unexpectedBytes++;
+			traceStrayByte(domain);
+			if (m_UnexpectedByteReceivedCallbackFunction)
+			{
+				(*m_UnexpectedByteReceivedCallbackFunction)(domain);
+			}
+		}
 	}
-}
 
-void ValloxSerial::updateCO2Low(int8_t value)
-{
-	if (m_CO2Low != value)
-	{
-		m_CO2Low = value;
-		onPropertyChanged(CO2LowProperty, m_CO2Low);
-	}
+	return telegramProcessed;
 }
 
-void ValloxSerial::updateCO2SetPointHigh(int8_t value)
+// reads byte by byte into a sliding window of telegram length. When the window
+// does not hold a valid telegram it is shifted by one byte only, so that we
+// realign on the next telegram start instead of loosing the following ones.
+// returns true if a telegram with a valid checksum was processed.
+bool ValloxSerial::receiveWindow(bool* pTelegramReceived)
 {
-	if (m_CO2SetPointHigh != value)
+	int available = m_pRxSerial->available();
+	while (available > 0)
 	{
-		m_CO2SetPointHigh = value;
-		onPropertyChanged(CO2SetPointHighProperty, m_CO2SetPointHigh);
+		while (m_WindowLength < VALLOX_LENGTH && available > 0)
+		{
+			m_Window[m_WindowLength++] = m_pRxSerial->read();
+			m_Statistics.receivedBytes++;
+			available--;
+		}
+
+		if (m_Window[0] != VALLOX_DOMAIN)
+		{
+			skipWindowBytes();
+		}
+		else if (m_WindowLength == VALLOX_LENGTH)
+		{
+			uint8_t checksum = Vallox::calculateChecksum(m_Window);
+			if (m_Window[5] == checksum)
+			{
+				m_WindowLength = 0;
+				if (!m_Synchronized)
+				{
+					m_Synchronized = true;
+					m_Statistics.recoveredTelegrams++;
+				}
+
+				*pTelegramReceived = processTelegram(m_Window[1], m_Window[2], m_Window[3], m_Window[4]);
+				return true;
+			}
+
+			// only report failures of telegrams that started where we expected one
+			if (m_Synchronized)
+			{
+				m_Statistics.checksumFailures++;
+			}
+			if (m_Synchronized && m_pTrace)
+			{
+				m_pTrace->recordChecksumFailure(m_Window, now());
+			}
+			if (m_Synchronized && m_TelegramChecksumFailureCallback)
+			{
+				(*m_TelegramChecksumFailureCallback)(m_Window[1], m_Window[2], m_Window[3], m_Window[4], m_Window[5]);
+			}
+			skipWindowBytes();
+		}
 	}
+
+	return false;
 }
 
-void ValloxSerial::updateCO2SetPointLow(int8_t value)
+// drops the first byte of the window and all following bytes up to the next domain byte.
+void ValloxSerial::skipWindowBytes()
 {
-	if (m_CO2SetPointLow != value)
+	uint8_t skip = 1;
+	while (skip < m_WindowLength && m_Window[skip] != VALLOX_DOMAIN)
 	{
-		m_CO2SetPointLow = value;
-		onPropertyChanged(CO2SetPointLowProperty, m_CO2SetPointLow);
+		skip++;
 	}
-}
 
-void ValloxSerial::updateFanSpeedMax(int8_t fanSpeed)
-{
-	if (m_FanSpeedMax != fanSpeed)
+	for (uint8_t i = 0; i < skip; i++)
 	{
-		m_FanSpeedMax = fanSpeed;
-		onPropertyChanged(FanSpeedMaxProperty, m_FanSpeedMax);
+		traceStrayByte(m_Window[i]);
+		if (m_UnexpectedByteReceivedCallbackFunction)
+		{
+			(*m_UnexpectedByteReceivedCallbackFunction)(m_Window[i]);
+		}
 	}
-}
 
-void ValloxSerial::updateFanSpeedMin(int8_t fanSpeed)
-{
-	if (m_FanSpeedMin != fanSpeed)
+	m_WindowLength -= skip;
+	for (uint8_t i = 0; i < m_WindowLength; i++)
 	{
-		m_FanSpeedMin = fanSpeed;
-		onPropertyChanged(FanSpeedMinProperty, m_FanSpeedMin);
+		m_Window[i] = m_Window[i + skip];
 	}
+
+	m_Statistics.skippedBytes += skip;
+	m_Statistics.unexpectedBytes += skip;
+	m_Synchronized = false;
 }
 
-void ValloxSerial::updateDCFanInputAdjustment(int8_t value)
+void ValloxSerial::traceStrayByte(uint8_t value)
 {
-	if (m_DCFanInputAdjustment != value)
+	if (m_pTrace)
 	{
-		m_DCFanInputAdjustment = value;
-		onPropertyChanged(DCFanInputAdjustmentProperty, m_DCFanInputAdjustment);
+		m_pTrace->recordStrayByte(value, now());
 	}
 }
 
-void ValloxSerial::updateDCFanOutputAdjustment(int8_t value)
+// counts a valid telegram, with the tables by pair and variable as well. They are hashed with linear
+// probing, telegrams of keys which find no slot in a full table are counted as other.
+void ValloxSerial::countTelegram(uint8_t sender, uint8_t receiver, uint8_t variable)
 {
-	if (m_DCFanOutputAdjustment != value)
+	if (m_ClockFunction)
 	{
-		m_DCFanOutputAdjustment = value;
-		onPropertyChanged(DCFanOutputAdjustmentProperty, m_DCFanOutputAdjustment);
+		unsigned long time = now();
+		if (m_Statistics.receivedTelegrams != 0)
+		{
+			unsigned long gap = time - m_LastTelegramTime;
+			uint8_t bucket = 0;
+			for (unsigned long limit = VALLOX_GAP_FIRST_LIMIT_MS; bucket < VALLOX_GAP_BUCKETS - 1 && gap >= limit; limit <<= 1)
+			{
+				bucket++;
+			}
+			m_Statistics.gaps[bucket]++;
+		}
+		m_LastTelegramTime = time;
 	}
-}
+	m_Statistics.receivedTelegrams++;
 
-void ValloxSerial::updateInputFanStopThreshold(int8_t temperature)
-{
-	if (m_InputFanStopThreshold != temperature)
+#if VALLOX_STATISTICS_TABLES
+	uint8_t pair = (uint8_t)(sender * 7 + receiver) & (VALLOX_STATISTICS_PAIRS - 1);
+	for (uint8_t probe = 0; ; probe++, pair = (pair + 1) & (VALLOX_STATISTICS_PAIRS - 1))
 	{
-		m_InputFanStopThreshold = temperature;
-		onPropertyChanged(InputFanStopThresholdProperty, m_InputFanStopThreshold);
+		ValloxPairStatistics& entry = m_Statistics.pairs[pair];
+		if (entry.telegrams != 0 && entry.sender == sender && entry.receiver == receiver)
+		{
+			entry.telegrams++;
+			break;
+		}
+		if (entry.telegrams == 0)
+		{
+			entry.sender = sender;
+			entry.receiver = receiver;
+			entry.telegrams = 1;
+			m_Statistics.pairCount++;
+			break;
+		}
+		if (probe == VALLOX_STATISTICS_PAIRS - 1)
+		{
+			m_Statistics.otherPairTelegrams++;
+			break;
+		}
 	}
-}
 
-void ValloxSerial::updateHeatingSetPoint(int8_t temperature)
-{
-	if (m_HeatingSetPoint != temperature)
+	uint8_t slot = variable & (VALLOX_STATISTICS_VARIABLES - 1);
+	for (uint8_t probe = 0; ; probe++, slot = (slot + 1) & (VALLOX_STATISTICS_VARIABLES - 1))
 	{
-		m_HeatingSetPoint = temperature;
-		onPropertyChanged(HeatingSetPointProperty, m_HeatingSetPoint);
+		ValloxVariableStatistics& entry = m_Statistics.variables[slot];
+		if (entry.telegrams != 0 && entry.variable == variable)
+		{
+			entry.telegrams++;
+			break;
+		}
+		if (entry.telegrams == 0)
+		{
+			entry.variable = variable;
+			entry.telegrams = 1;
+			m_Statistics.variableCount++;
+			break;
+		}
+		if (probe == VALLOX_STATISTICS_VARIABLES - 1)
+		{
+			m_Statistics.otherVariableTelegrams++;
+			break;
+		}
 	}
+#endif
 }
 
-void ValloxSerial::updatePreHeatingSetPoint(int8_t temperature)
+// bytes of the last full second, a longer gap between two calls averages over it
+void ValloxSerial::updateByteRate()
 {
-	if (m_PreHeatingSetPoint != temperature)
+	unsigned long elapsed = now() - m_RateStart;
+	if (elapsed >= 1000)
 	{
-		m_PreHeatingSetPoint = temperature;
-		onPropertyChanged(PreHeatingSetPointProperty, m_PreHeatingSetPoint);
+		uint32_t bytes = m_Statistics.receivedBytes - m_RateBytes;
+		uint32_t rate = bytes * 1000 / elapsed;
+		m_Statistics.bytesPerSecond = rate < 0xFFFF ? (uint16_t)rate : 0xFFFF;
+		if (m_Statistics.bytesPerSecond > m_Statistics.peakBytesPerSecond)
+		{
+			m_Statistics.peakBytesPerSecond = m_Statistics.bytesPerSecond;
+		}
+		m_RateStart += elapsed;
+		m_RateBytes = m_Statistics.receivedBytes;
 	}
 }
 
-void ValloxSerial::updateHRCBypassThreshold(int8_t temperature)
+bool ValloxSerial::processTelegram(uint8_t sender, uint8_t receiver, uint8_t command, uint8_t arg)
 {
-	if (m_HrcBypassThreshold != temperature)
+	bool telegramReceived = false;
+
+	countTelegram(sender, receiver, command);
+
+	if (m_pTrace)
 	{
-		m_HrcBypassThreshold = temperature;
-		onPropertyChanged(HrcBypassThresholdProperty, m_HrcBypassThreshold);
+		uint8_t telegram[VALLOX_LENGTH] = { VALLOX_DOMAIN, sender, receiver, command, arg, 0 };
+		telegram[5] = Vallox::calculateChecksum(telegram);
+		m_pTrace->recordTelegram(telegram, false, now());
 	}
-}
 
-void ValloxSerial::updateCellDefrostingThreshold(int8_t temperature)
-{
-	if (m_CellDefrostingThreshold != temperature)
+	if (m_EchoPending &&
+		sender == m_SenderId &&
+		receiver == m_CurrentTelegram.destination &&
+		command == m_CurrentTelegram.variable &&
+		arg == m_CurrentTelegram.value)
 	{
-		m_CellDefrostingThreshold = temperature;
-		onPropertyChanged(CellDefrostingThresholdProperty, m_CellDefrostingThreshold);
+		m_EchoReceived = true;
 	}
-}
-
-void ValloxSerial::updateProgram(int8_t program)
-{
-	uint8_t adjustmentIntervalMinutes;
-	bool automaticHumidityLevelSeekerState;
-	bool boostSwitchMode;
-	bool radiatorType;
-	bool cascadeAdjust;
-
-	Vallox::convertProgram(program,
-		&adjustmentIntervalMinutes, 
-		&automaticHumidityLevelSeekerState,
-		&boostSwitchMode, 
-		&radiatorType,
-		&cascadeAdjust);
 
-	if (m_AdjustmentIntervalMinutes != adjustmentIntervalMinutes)
+	if (sender == VALLOX_ADDRESS_MASTER && m_PollTable.hasPending())
 	{
-		m_AdjustmentIntervalMinutes = adjustmentIntervalMinutes;
-		onPropertyChanged(AdjustmentIntervalMinutesProperty, m_AdjustmentIntervalMinutes);
+		m_PollTable.complete(command, arg, now());
 	}
 
-	if (m_AutomaticHumidityLevelSeekerState != automaticHumidityLevelSeekerState)
+#if VALLOX_WRITE_TRANSACTIONS
+	// only the answer to our read back decides a write, other reports may be older than it
+	ValloxWriteResult writeResult = WriteIgnored;
+	uint8_t writeSlot = 0;
+	if (sender == VALLOX_ADDRESS_MASTER && m_WriteTable.hasPending())
 	{
-		m_AutomaticHumidityLevelSeekerState = automaticHumidityLevelSeekerState;
-		onPropertyChanged(AutomaticHumidityLevelSeekerStateProperty, m_AutomaticHumidityLevelSeekerState);
+		writeResult = m_WriteTable.received(command, arg, readWriteMask(command), receiver == m_SenderId, now(), &writeSlot);
 	}
+#endif
 
-	if (m_BoostSwitchMode != boostSwitchMode)
+	bool handleTelegram = true;
+	if (m_TelegramReceivedCallback)
 	{
-		m_BoostSwitchMode = boostSwitchMode;
-		onPropertyChanged(BoostSwitchModeProperty, m_BoostSwitchMode);
+		VALLOX_PROFILE(ProfileTelegramCallback);
+		handleTelegram = (*m_TelegramReceivedCallback)(sender, receiver, command, arg);
 	}
 
-	if (m_RadiatorType != radiatorType)
+	// the callback may return false to avoid handling this telegram!
+	if (handleTelegram)
 	{
-		m_RadiatorType = radiatorType;
-		onPropertyChanged(RadiatorTypeProperty, m_RadiatorType);
+#if VALLOX_WRITE_TRANSACTIONS
+		if (writeResult == WriteStale && m_WriteMode == WriteOptimistic)
+		{
+			// the properties show the written value until the read back
+			telegramReceived = true;
+		}
+		else
+#endif
+		{
+			// a rejected write leaves the value of the master in the properties, the timeout writes again
+			telegramReceived = onTelegramReceived(sender, receiver, command, arg);
+		}
 	}
 
-	if (m_CascadeAdjust != cascadeAdjust)
+#if VALLOX_WRITE_TRANSACTIONS
+	if (writeResult == WriteConfirmed)
 	{
-		m_CascadeAdjust = cascadeAdjust;
-		onPropertyChanged(CascadeAdjustProperty, m_CascadeAdjust);
+		onWriteCompleted(writeSlot, true);
 	}
-}
+#endif
 
-void ValloxSerial::updateProgram2(int8_t program)
-{
-	bool maxSpeedLimitMode;
-	Vallox::convertProgram2(program,
-		&maxSpeedLimitMode);
+	publish();
 
-	if (m_MaxSpeedLimitMode != maxSpeedLimitMode)
+	if (m_NotificationMode == NotifyPerTelegram)
 	{
-		m_MaxSpeedLimitMode = maxSpeedLimitMode;
-		onPropertyChanged(MaxSpeedLimitModeProperty, m_MaxSpeedLimitMode);
+		onPropertiesChanged();
 	}
+
+	return telegramReceived;
 }
 
-void ValloxSerial::updateServiceReminder(int8_t value)
+void ValloxSerial::calculateResults()
 {
-	if (m_ServiceReminder != value)
-	{
-		m_ServiceReminder = value;
-		onPropertyChanged(ServiceReminderProperty, m_ServiceReminder);
-	}
+	updateEfficiencies();
+	publish();
+	onPropertiesChanged();
+	onSubscriptionsPending();
 }
 
-void ValloxSerial::updateMultiPurposeIoPort1(int8_t value)
+bool ValloxSerial::onTelegramReceived(uint8_t sender, uint8_t receiver, uint8_t command, uint8_t arg)
 {
-	bool postHeatingOn;
-	Vallox::convertIoPortMultiPurpose1(value,
-		&postHeatingOn);
+	VALLOX_PROFILE(ProfileTelegram);
+	bool telegramReceived = true;
+
+	if (receiver == m_ReceiverId || receiver == m_SenderId || receiver == VALLOX_ADDRESS_PANELS)
+	{
+		telegramReceived = decodeVariable(command, arg);
 
-	if (m_PostHeatingOn != postHeatingOn)
+#if VALLOX_SCHEDULER
+		if (!m_Scheduler.isEmpty())
+		{
+			m_Scheduler.observe(command, arg, now());
+		}
+#endif
+	}
+	else
 	{
-		m_PostHeatingOn = postHeatingOn;
-		onPropertyChanged(PostHeatingOnProperty, m_PostHeatingOn);
+		// telegram was not meant for us.
 	}
+
+	return telegramReceived;
 }
 
-void ValloxSerial::updateMultiPurposeIoPort2(int8_t value)
+// updates the properties held by the variable, returns false for unknown variables
+bool ValloxSerial::decodeVariable(uint8_t variable, uint8_t arg)
 {
-	bool damperMotorPosition;
-	bool faultSignalRelayClosed;
-	bool supplyFanOff;
-	bool preHeatingOn;
-	bool exhaustFanOff;
-	bool fireplaceBoosterClosed;
+	bool decoded = true;
+	int8_t value = (int8_t)arg;
 
-	Vallox::convertIoPortMultiPurpose2(value,
-		&damperMotorPosition,
-		&faultSignalRelayClosed,
-		&supplyFanOff,
-		&preHeatingOn,
-		&exhaustFanOff,
-		&fireplaceBoosterClosed);
+	ValloxVariableDescriptor descriptor;
+	readVariableDescriptor(variable, &descriptor);
 
-	if (m_DamperMotorPosition != damperMotorPosition)
+	switch (descriptor.type & VALLOX_DECODER_MASK)
+	{
+	case VALLOX_DECODE_IGNORE:
 	{
-		m_DamperMotorPosition = damperMotorPosition;
-		onPropertyChanged(DamperMotorPositionProperty, m_DamperMotorPosition);
+		// counters, relay states and flags without a property, received on purpose and not decoded
+		break;
 	}
-
-	if (m_FaultSignalRelay != faultSignalRelayClosed)
+	case VALLOX_DECODE_RAW:
 	{
-		m_FaultSignalRelay = faultSignalRelayClosed;
-		onPropertyChanged(FaultSignalRelayProperty, m_FaultSignalRelay);
+		updateProperty((ValloxProperty)descriptor.property, value);
+		break;
 	}
-
-	if (m_SupplyFanOff != supplyFanOff)
+	case VALLOX_DECODE_TEMPERATURE:
+	{
+		int8_t temperature = Vallox::convertTemperature(value);
+		updateProperty((ValloxProperty)descriptor.property, temperature);
+		break;
+	}
+	case VALLOX_DECODE_FAN_SPEED:
+	{
+		uint8_t fanSpeed = Vallox::convertFanSpeed(value);
+		updateProperty((ValloxProperty)descriptor.property, fanSpeed);
+		break;
+	}
+	case VALLOX_DECODE_BITFIELD:
 	{
-		m_SupplyFanOff = supplyFanOff;
-		onPropertyChanged(SupplyFanOffProperty, m_SupplyFanOff);
+		if (descriptor.property != VALLOX_NO_PROPERTY)
+		{
+			updateProperty((ValloxProperty)descriptor.property, value);
+		}
+		updateBitfields(descriptor.firstBitfield, descriptor.bitfieldCount, value);
+		break;
 	}
 
-	if (m_PreHeatingOn != preHeatingOn)
+	// C02 communication starts: no tx allowed!
+	case VALLOX_DECODE_SUSPEND:
 	{
-		m_PreHeatingOn = preHeatingOn;
-		onPropertyChanged(PreHeatingOnProperty, m_PreHeatingOn);
+		onSuspended(true);
+		break;
 	}
 
-	if (m_ExhaustFanOff != exhaustFanOff)
+	// C02 communication ends: tx allowed!
+	case VALLOX_DECODE_RESUME:
 	{
-		m_ExhaustFanOff = exhaustFanOff;
-		onPropertyChanged(ExhaustFanOffProperty, m_ExhaustFanOff);
+		onSuspended(false);
+		break;
 	}
 
-	if (m_FirePlaceBoosterOn != fireplaceBoosterClosed)
+	default:
 	{
-		m_FirePlaceBoosterOn = fireplaceBoosterClosed;
-		onPropertyChanged(FirePlaceBoosterOnProperty, m_FirePlaceBoosterOn);
+		log("Unkown command received");
+		decoded = false;
+		break;
 	}
+	}//switch
+
+	return decoded;
 }
 
-void ValloxSerial::updateCurrentIncomming(int8_t value)
+
+
+void ValloxSerial::updateProperty(ValloxProperty propertyId, int8_t value)
 {
-	if (m_IncommingCurrent != value)
+	VALLOX_PROFILE(ProfileUpdateProperty);
+	uint8_t index = ValloxPropertyStore::indexOf(propertyId);
+	if (index == VALLOX_NO_INDEX)
 	{
-		m_IncommingCurrent = value;
-		onPropertyChanged(IncommingCurrentProperty, m_IncommingCurrent);
+		return;
+	}
+
+	int8_t previousValue = m_Properties.get(index);
+	if (m_Properties.set(index, value))
+	{
+		if (m_pEventQueue)
+		{
+			m_pEventQueue->push(propertyId, previousValue, m_Properties.get(index), now());
+		}
+
+#if VALLOX_SHARED_STORE
+		m_Unpublished = true;
+#endif
+
+		if (m_NotificationMode == NotifyPerProperty)
+		{
+			onPropertyChanged(propertyId, value);
+		}
+		else
+		{
+			m_ChangedProperties.set(index);
+		}
+
+		if (!m_Subscribers.isEmpty())
+		{
+			VALLOX_PROFILE(ProfileSubscriberCallback);
+			m_Subscribers.notify(index, m_Properties, now());
+		}
 	}
 }
 
-void ValloxSerial::updateLastErrorNumber(int8_t value)
+void ValloxSerial::updateBitfields(uint8_t firstBitfield, uint8_t bitfieldCount, uint8_t value)
 {
-	if (m_LastErrorNumber != value)
+	VALLOX_PROFILE(ProfileUpdateBitfields);
+	for (uint8_t i = firstBitfield; i < firstBitfield + bitfieldCount; i++)
 	{
-		m_LastErrorNumber = value;
-		onPropertyChanged(LastErrorNumberProperty, m_LastErrorNumber);
+		ValloxBitfieldDescriptor bitfield;
+		readBitfieldDescriptor(i, &bitfield);
+		updateProperty((ValloxProperty)bitfield.property, (value & bitfield.mask) >> bitfield.shift);
 	}
 }
 
@@ -1407,38 +1646,79 @@ void ValloxSerial::updateLastErrorNumber(int8_t value)
 
 void ValloxSerial::updateEfficiencies()
 {
-	int8_t maxPossible = m_TempInside - m_TempOutside;
+	VALLOX_PROFILE(ProfileUpdateEfficiencies);
+	int8_t tempInside = m_Properties.getValue(TempInsideProperty);
+	int8_t tempOutside = m_Properties.getValue(TempOutsideProperty);
+	int8_t tempExhaust = m_Properties.getValue(TempExhaustProperty);
+	int8_t tempIncomming = m_Properties.getValue(TempIncommingProperty);
+
+	int8_t maxPossible = tempInside - tempOutside;
 	if (maxPossible != 0)
 	{
-		float inEfficiency = (m_TempIncomming - m_TempOutside) * 100.0 / maxPossible;
-		if (m_InEfficiency != (int8_t)inEfficiency)
-		{
-			m_InEfficiency = inEfficiency;
-			onPropertyChanged(InEfficiencyProperty, inEfficiency);
-		}
+		float inEfficiency = (tempIncomming - tempOutside) * 100.0 / maxPossible;
+		updateProperty(InEfficiencyProperty, (int8_t)inEfficiency);
 
-		float outEfficiency = (m_TempInside - m_TempExhaust) * 100.0 / maxPossible;
-		if (m_OutEfficiency != (int8_t)outEfficiency)
-		{
-			m_OutEfficiency = outEfficiency;
-			onPropertyChanged(OutEfficiencyProperty, outEfficiency);
-		}
+		float outEfficiency = (tempInside - tempExhaust) * 100.0 / maxPossible;
+		updateProperty(OutEfficiencyProperty, (int8_t)outEfficiency);
 
-		float averageEfficiency = (m_InEfficiency + m_OutEfficiency) / 2;
-		if (m_AverageEfficiency != (int8_t)averageEfficiency)
-		{
-			m_AverageEfficiency = averageEfficiency;
-			onPropertyChanged(AverageEfficiencyProperty, averageEfficiency);
-		}
+		float averageEfficiency = (m_Properties.getValue(InEfficiencyProperty) + m_Properties.getValue(OutEfficiencyProperty)) / 2;
+		updateProperty(AverageEfficiencyProperty, (int8_t)averageEfficiency);
 	}
 }
 
 
+// hands the properties to the readers on other threads once all properties of a telegram are updated
+void ValloxSerial::publish()
+{
+#if VALLOX_SHARED_STORE
+	if (m_Unpublished)
+	{
+		m_SharedStore.publish(m_Properties);
+		m_Unpublished = false;
+	}
+#endif
+}
+
 void ValloxSerial::onSuspended(bool suspended)
 {
 	if (m_TxSuspended != suspended)
 	{
+		if (suspended)
+		{
+			m_Statistics.suspensions++;
+		}
+		else
+		{
+			uint32_t duration = now() - m_SuspendStart;
+			m_Statistics.suspendedMs += duration;
+			if (duration > m_Statistics.longestSuspensionMs)
+			{
+				m_Statistics.longestSuspensionMs = duration;
+			}
+		}
+
 		m_TxSuspended = suspended;
+		m_SuspendStart = now();
+
+		if (!suspended && m_PollTable.hasPending())
+		{
+			// the polls made meanwhile were dropped and the replies to the others may be lost
+			resendPolls(m_PollTable.restart());
+		}
+#if VALLOX_WRITE_TRANSACTIONS
+		if (!suspended && m_WriteTable.hasPending())
+		{
+			// the writes are sent now, the read backs were dropped
+			uint8_t pending = m_WriteTable.restart(now());
+			for (uint8_t slot = 0; pending != 0; slot++, pending >>= 1)
+			{
+				if (pending & 1)
+				{
+					pollWritten(m_WriteTable.getVariable(slot));
+				}
+			}
+		}
+#endif
 		if (m_SuspendResumeCallbackFunction)
 		{
 			(*m_SuspendResumeCallbackFunction)(suspended);
@@ -1450,10 +1730,43 @@ void ValloxSerial::onPropertyChanged(ValloxProperty propertyId, int8_t value) co
 {
 	if (m_PropertyChangedCallback)
 	{
+		VALLOX_PROFILE(ProfilePropertyCallback);
 		(*m_PropertyChangedCallback)(propertyId, value);
 	}
 }
 
+// reports the changes collected in the batch modes
+void ValloxSerial::onPropertiesChanged()
+{
+	if (!m_ChangedProperties.isEmpty())
+	{
+		// the callback may receive again, so it gets a copy
+		ValloxPropertyMask changedProperties = m_ChangedProperties;
+		m_ChangedProperties.clear();
+
+		if (m_PropertiesChangedCallback)
+		{
+			VALLOX_PROFILE(ProfilePropertyCallback);
+			(*m_PropertiesChangedCallback)(changedProperties, m_Properties);
+		}
+	}
+}
+
+// delivers the changes held back by the minimum interval of a subscriber
+void ValloxSerial::onSubscriptionsPending()
+{
+	if (m_Subscribers.hasPending())
+	{
+		VALLOX_PROFILE(ProfileSubscriberCallback);
+		m_Subscribers.notifyPending(m_Properties, now());
+	}
+}
+
+unsigned long ValloxSerial::now() const
+{
+	return m_ClockFunction ? (*m_ClockFunction)() : 0;
+}
+
 void ValloxSerial::onStartSending() const
 {
 	if (m_StartSendingCallback)
@@ -2,110 +2,95 @@
 #define ValloxSerial_h
 
 #include <ValloxProtocol.h>
+#include <ValloxPropertyStore.h>
+#include <ValloxSubscribers.h>
+#include <ValloxTransmitQueue.h>
+#include <ValloxPollTable.h>
+#include <ValloxWriteTable.h>
+#include <ValloxScheduler.h>
+#include <ValloxTrace.h>
+#include <ValloxSharedStore.h>
+#include <ValloxEventQueue.h>
+#include <ValloxProfiler.h>
 #include <Stream.h>
 #include <inttypes.h>
 
+// a poll without reply is sent again after the timeout (needs a clock)
+#ifndef VALLOX_POLL_TIMEOUT_MS
+#define VALLOX_POLL_TIMEOUT_MS 100
+#endif
+
+#ifndef VALLOX_POLL_RETRIES
+#define VALLOX_POLL_RETRIES 2
+#endif
+
+// a verified write is sent again if the master did not report the value within the timeout (needs a clock)
+#ifndef VALLOX_WRITE_TIMEOUT_MS
+#define VALLOX_WRITE_TIMEOUT_MS 500
+#endif
+
+#ifndef VALLOX_WRITE_RETRIES
+#define VALLOX_WRITE_RETRIES 2
+#endif
+
+// sending is resumed after this time even if the resume of the CO2 sensor communication was missed
+#ifndef VALLOX_SUSPEND_TIMEOUT_MS
+#define VALLOX_SUSPEND_TIMEOUT_MS 5000
+#endif
+
+// minimum time between two polls of the scheduler
+#ifndef VALLOX_SCHEDULE_INTERVAL_MS
+#define VALLOX_SCHEDULE_INTERVAL_MS 1000
+#endif
+
+// telegrams counted by sender/receiver pair and by variable, the other counters are always kept.
+// left out on the Arduino cores unless VALLOX_STATISTICS_TABLES is set to 1.
+#ifndef VALLOX_STATISTICS_TABLES
+#ifdef ARDUINO
+#define VALLOX_STATISTICS_TABLES 0
+#else
+#define VALLOX_STATISTICS_TABLES 1
+#endif
+#endif
+
+#if VALLOX_STATISTICS_TABLES
+// telegrams are counted for this many sender/receiver pairs and variables, a power of two each
+#ifndef VALLOX_STATISTICS_PAIRS
+#ifdef ARDUINO
+#define VALLOX_STATISTICS_PAIRS 8
+#else
+#define VALLOX_STATISTICS_PAIRS 32
+#endif
+#endif
+
+#ifndef VALLOX_STATISTICS_VARIABLES
+#ifdef ARDUINO
+#define VALLOX_STATISTICS_VARIABLES 16
+#else
+#define VALLOX_STATISTICS_VARIABLES 64
+#endif
+#endif
+
+static_assert((VALLOX_STATISTICS_PAIRS & (VALLOX_STATISTICS_PAIRS - 1)) == 0 && VALLOX_STATISTICS_PAIRS <= 128, "VALLOX_STATISTICS_PAIRS must be a power of two up to 128");
+static_assert((VALLOX_STATISTICS_VARIABLES & (VALLOX_STATISTICS_VARIABLES - 1)) == 0 && VALLOX_STATISTICS_VARIABLES <= 128, "VALLOX_STATISTICS_VARIABLES must be a power of two up to 128");
+#endif
+
+// gaps between received telegrams: below 8 ms, 16 ms, ... 512 ms and the rest
+const uint8_t VALLOX_GAP_BUCKETS = 8;
+const uint8_t VALLOX_GAP_FIRST_LIMIT_MS = 8;
+
+// default maximum age in seconds by kind of variable
+const uint16_t VALLOX_MAX_AGE_BROADCAST = 300;	// refreshed by the broadcasts of the master anyway
+const uint16_t VALLOX_MAX_AGE_STATUS = 60;
+const uint16_t VALLOX_MAX_AGE_SETTING = 900;
+
 // uncomment this to reduce footprint.
 //#define MINIMUM_PROPERTIES
 
 extern "C" {
-	enum ValloxProperty
-	{
-		// sensor data 
-		FanSpeedProperty							= 0,  // VALLOX_VARIABLE_FAN_SPEED
-		TempInsideProperty							= 1,  // VALLOX_VARIABLE_TEMP_INSIDE
-		TempOutsideProperty							= 2,  // VALLOX_VARIABLE_TEMP_OUTSIDE
-		TempExhaustProperty							= 3,  // VALLOX_VARIABLE_TEMP_EXHAUST
-		TempIncommingProperty						= 4,  // VALLOX_VARIABLE_TEMP_INCOMMING
-
-		// status bits
-		PowerStateProperty							= 5,  // VALLOX_VARIABLE_SELECT
-		CO2AdjustStateProperty						= 6,  // VALLOX_VARIABLE_SELECT
-		HumidityAdjustStateProperty					= 7,  // VALLOX_VARIABLE_SELECT
-		HeatingStateProperty						= 8,  // VALLOX_VARIABLE_SELECT
-		FilterGuardIndicatorProperty				= 9,  // VALLOX_VARIABLE_SELECT
-		HeatingIndicatorProperty					= 10, // VALLOX_VARIABLE_SELECT
-		FaultIndicatorProperty						= 11, // VALLOX_VARIABLE_SELECT
-		ServiceReminderIndicatorProperty			= 12, // VALLOX_VARIABLE_SELECT
-
-		HumidityProperty							= 13, // VALLOX_VARIABLE_HUMIDITY
-		BasicHumidityLevelProperty					= 14, // VALLOX_VARIABLE_BASIC_HUMIDITY_LEVEL
-		HumiditySensor1Property						= 15, // VALLOX_VARIABLE_HUMIDITY_SENSOR1
-		HumiditySensor2Property						= 16, // VALLOX_VARIABLE_HUMIDITY_SENSOR2
-
-		CO2HighProperty								= 17, // VALLOX_VARIABLE_CO2_HIGH
-		CO2LowProperty								= 18, // VALLOX_VARIABLE_CO2_LOW
-		CO2SetPointHighProperty						= 19, // VALLOX_VARIABLE_CO2_SET_POINT_UPPER
-		CO2SetPointLowProperty						= 20, // VALLOX_VARIABLE_CO2_SET_POINT_LOWER
-
-		FanSpeedMaxProperty							= 21, // VALLOX_VARIABLE_FAN_SPEED_MAX
-		FanSpeedMinProperty							= 22, // VALLOX_VARIABLE_FAN_SPEED_MIN
-		DCFanInputAdjustmentProperty				= 23, // VALLOX_VARIABLE_DC_FAN_INPUT_ADJUSTMENT
-		DCFanOutputAdjustmentProperty				= 24, // VALLOX_VARIABLE_DC_FAN_OUTPUT_ADJUSTMENT
-		InputFanStopThresholdProperty				= 25, // VALLOX_VARIABLE_INPUT_FAN_STOP
-		HeatingSetPointProperty						= 26, // VALLOX_VARIABLE_HEATING_SET_POINT
-		PreHeatingSetPointProperty					= 27, // VALLOX_VARIABLE_PRE_HEATING_SET_POINT
-		HrcBypassThresholdProperty					= 28, // VALLOX_VARIABLE_HRC_BYPASS
-		CellDefrostingThresholdProperty				= 29, // VALLOX_VARIABLE_CELL_DEFROSTING
-
-		// program
-		AdjustmentIntervalMinutesProperty			= 30, // VALLOX_VARIABLE_PROGRAM
-		AutomaticHumidityLevelSeekerStateProperty	= 31, // VALLOX_VARIABLE_PROGRAM
-		BoostSwitchModeProperty						= 32, // VALLOX_VARIABLE_PROGRAM
-		RadiatorTypeProperty						= 33, // VALLOX_VARIABLE_PROGRAM
-		CascadeAdjustProperty						= 34, // VALLOX_VARIABLE_PROGRAM
-
-		// program2
-		MaxSpeedLimitModeProperty					= 35, // VALLOX_VARIABLE_PROGRAM2
-
-		ServiceReminderProperty						= 36, // VALLOX_VARIABLE_SERVICE_REMINDER
-
-		// ioport multi purpose 1
-		PostHeatingOnProperty						= 37, // VALLOX_VARIABLE_IOPORT_MULTI_PURPOSE_1
-
-		// ioport multi purpose 2
-		DamperMotorPositionProperty					= 38, // VALLOX_VARIABLE_IOPORT_MULTI_PURPOSE_2
-		FaultSignalRelayProperty					= 39, // VALLOX_VARIABLE_IOPORT_MULTI_PURPOSE_2
-		SupplyFanOffProperty						= 50, // VALLOX_VARIABLE_IOPORT_MULTI_PURPOSE_2
-		PreHeatingOnProperty						= 41, // VALLOX_VARIABLE_IOPORT_MULTI_PURPOSE_2
-		ExhaustFanOffProperty						= 42, // VALLOX_VARIABLE_IOPORT_MULTI_PURPOSE_2
-		FirePlaceBoosterOnProperty					= 43, // VALLOX_VARIABLE_IOPORT_MULTI_PURPOSE_2
-
-		IncommingCurrentProperty					= 44, // VALLOX_VARIABLE_CURRENT_INCOMMING
-		LastErrorNumberProperty                     = 45, // VALLOX_VARIABLE_LAST_ERROR_NUMBER
-
-
-		// TODO: those variables are to be implemented in future
-		//VALLOX_VARIABLE_IOPORT_FANSPEED_RELAYS
-		//VALLOX_VARIABLE_INSTALLED_CO2_SENSORS
-		//VALLOX_VARIABLE_POST_HEATING_ON_COUNTER
-		//VALLOX_VARIABLE_POST_HEATING_OFF_TIME
-		//VALLOX_VARIABLE_POST_HEATING_TARGET_VALUE
-		//VALLOX_VARIABLE_FLAGS_1
-		//VALLOX_VARIABLE_FLAGS_2
-		//VALLOX_VARIABLE_FLAGS_3
-		//VALLOX_VARIABLE_FLAGS_4
-		//VALLOX_VARIABLE_FLAGS_5
-		//VALLOX_VARIABLE_FLAGS_6
-		//VALLOX_VARIABLE_FIRE_PLACE_BOOSTER_COUNTER
-		//VALLOX_VARIABLE_MAINTENANCE_MONTH_COUNTER
-
-		// calculated  properties
-		InEfficiencyProperty			= 100,
-		OutEfficiencyProperty			= 101,
-		AverageEfficiencyProperty		= 102,
-		
-
-		// virtual properties to be able to poll for this variable
-		SelectStatusProperty			= 200,
-		ProgramProperty					= 201, // VALLOX_VARIABLE_PROGRAM
-		Program2Property				= 202, // VALLOX_VARIABLE_PROGRAM2
-		IoPortMultiPurpose1Property		= 203, // VALLOX_VARIABLE_IOPORT_MULTI_PURPOSE_1
-		IoPortMultiPurpose2Property		= 204, // VALLOX_VARIABLE_IOPORT_MULTI_PURPOSE_2
-	};
-
 	// callback function types
 	typedef void(*PropertyChangedCallbackFunction)(ValloxProperty propertyId, int8_t value);
+	typedef void(*PropertiesChangedCallbackFunction)(const ValloxPropertyMask& changedProperties, const ValloxPropertyStore& properties);
 	typedef void(*StartSendingFunction)();
 	typedef void(*StopSendingFunction)();
 
@@ -114,8 +99,81 @@ extern "C" {
 	typedef void (*TelegramChecksumFailureCallbackFunction)(uint8_t sender, uint8_t receiver, uint8_t command, uint8_t arg, uint8_t checksum);
 	typedef void (*UnexpectedByteReceivedCallbackFunction)(uint8_t receivedByte);
 	typedef void(*SuspendResumeCallbackFunction)(bool suspended);
+
+	typedef unsigned long(*ClockFunction)();	// milliseconds, e.g. millis()
 }
 
+// when property changes are reported
+enum ValloxNotificationMode
+{
+	NotifyPerProperty,	// PropertyChangedCallbackFunction for every single change (default)
+	NotifyPerTelegram,	// PropertiesChangedCallbackFunction once per decoded telegram
+	NotifyPerReceive	// PropertiesChangedCallbackFunction once per receive() or receiveAll() call
+};
+
+#if VALLOX_WRITE_TRANSACTIONS
+// how the setters make sure the master takes a value
+enum ValloxWriteMode
+{
+	WriteUnconfirmed,	// send and forget (default)
+	WriteVerified,		// read the variable back and write again after the timeout until the master holds the value
+	WriteOptimistic		// as verified, but the properties change at once and keep the value until the read back, they are restored if the write never takes
+};
+#endif
+
+struct ValloxPairStatistics
+{
+	uint8_t sender;
+	uint8_t receiver;
+	uint32_t telegrams;
+};
+
+struct ValloxVariableStatistics
+{
+	uint8_t variable;				// VALLOX_VARIABLE_POLL for the poll requests
+	uint32_t telegrams;
+};
+
+// counters maintained while receiving and sending, the timings need a clock
+struct ValloxStatistics
+{
+	uint32_t receivedBytes;
+	uint32_t receivedTelegrams;		// valid checksum, our own echoes included
+	uint32_t checksumFailures;
+	uint32_t unexpectedBytes;		// bytes which did not start a telegram
+	uint32_t skippedBytes;			// bytes dropped while searching for the start of a telegram
+	uint32_t recoveredTelegrams;	// valid telegrams found after bytes had to be skipped
+
+	uint16_t bytesPerSecond;		// received in the last full second
+	uint16_t peakBytesPerSecond;	// 960 is a saturated bus
+	uint32_t gaps[VALLOX_GAP_BUCKETS];	// histogram of the ms between two received telegrams
+
+#if VALLOX_STATISTICS_TABLES
+	// hash tables, entries without telegrams are unused
+	uint8_t pairCount;				// used entries
+	ValloxPairStatistics pairs[VALLOX_STATISTICS_PAIRS];
+	uint32_t otherPairTelegrams;	// telegrams of pairs which did not fit
+	uint8_t variableCount;
+	ValloxVariableStatistics variables[VALLOX_STATISTICS_VARIABLES];
+	uint32_t otherVariableTelegrams;
+#endif
+
+	uint32_t transmittedTelegrams;
+	uint32_t deferredTelegrams;		// telegrams held back as the bus was busy (collisions avoided)
+	uint32_t collisions;			// telegrams whose echo did not come back unchanged
+	uint32_t retransmittedTelegrams;	// retries after collisions
+	uint32_t droppedTelegrams;		// telegrams given up after the last retry
+
+	uint32_t queuedWrites;			// writes waiting in the transmit queue
+	uint32_t coalescedWrites;		// writes which replaced the waiting value of the same variable
+	uint32_t droppedWrites;			// writes lost as the transmit queue was full
+
+	uint32_t suspensions;			// CO2 sensor communications
+	uint32_t suspendedMs;			// total time sending was suspended
+	uint32_t longestSuspensionMs;
+	uint32_t missedResumes;			// suspensions ended by the timeout instead of a resume
+};
+
 
 class ValloxSerial
 {
@@ -127,31 +185,111 @@ public:
 	void setTxSerial(Stream& serial);			// this should be a hardserial to avoid loosing telegrams
 	void setSenderId(uint8_t senderId);			// only neccessary when sending data
 	void setReceiverId(uint8_t receiverId);		// neccessary to select device we should listen to.
+	void setResynchronize(bool resynchronize);	// search telegrams byte by byte instead of dropping 6 bytes on errors
 	int8_t getValue(ValloxProperty propertyId) const;
-
-	void setFanSpeed(uint8_t value) const;		// actor: control fan speed 1-8
-	void setFanSpeedMin(uint8_t value) const;	// actor: control fan speed 1-8 min
-	void setFanSpeedMax(uint8_t value) const;	// actor: control fan speed 1-8 max
-	void setDCFanInputAdjustment(uint8_t value) const;	// actor: control DC input fan adjustment
-	void setDCFanOutputAdjustment(uint8_t value) const;	// actor: control DC output fan adjustment
+	void snapshot(ValloxPropertyStore& store) const;	// copies all properties at once
+#if VALLOX_SHARED_STORE
+	const ValloxSharedStore& getSharedStore() const;	// lock free snapshots for other threads, published after every decoded telegram
+#endif
+	uint8_t changedSince(PropertyChangedCallbackFunction callbackFunction); // calls the function for every property changed since the last call
+	void setNotificationMode(ValloxNotificationMode mode);	// batch modes report all changes of a telegram or receive pass at once
+
+	void setFanSpeed(uint8_t value);		// actor: control fan speed 1-8
+	void setFanSpeedMin(uint8_t value);	// actor: control fan speed 1-8 min
+	void setFanSpeedMax(uint8_t value);	// actor: control fan speed 1-8 max
+	void setDCFanInputAdjustment(uint8_t value);	// actor: control DC input fan adjustment
+	void setDCFanOutputAdjustment(uint8_t value);	// actor: control DC output fan adjustment
 	
-	void setHrcBypassThreshold(int8_t value) const;	// actor: control HRC bypass threshold
-	void setInputFanStopThreshold(int8_t value) const;	// actor: control input fan stop threshold
-	void setHeatingSetPoint(int8_t value) const;	// actor: control heating set point
-	void setPreHeatingSetPoint(int8_t value) const;	// actor: control pre heating set point
-	void setCellDefrostingThreshold(int8_t value) const;	// actor: control cell defrosting threshold (hysteresis 4)
-	void setSelectStatus(int8_t value) const; // actor: set the lower 4 bits of the select status bits.
+	void setHrcBypassThreshold(int8_t value);	// actor: control HRC bypass threshold
+	void setInputFanStopThreshold(int8_t value);	// actor: control input fan stop threshold
+	void setHeatingSetPoint(int8_t value);	// actor: control heating set point
+	void setPreHeatingSetPoint(int8_t value);	// actor: control pre heating set point
+	void setCellDefrostingThreshold(int8_t value);	// actor: control cell defrosting threshold (hysteresis 4)
+	void setSelectStatus(int8_t value); // actor: set the lower 4 bits of the select status bits.
 
 	bool receive();								// this one has to be called in the loop() function.
+	uint16_t receiveAll(uint16_t maxTelegrams = 0, int* pPendingBytes = NULL); // alternative to receive(): decodes all complete telegrams (0 = no limit)
 	void calculateResults();					// this one calculates all efficiency property calculations
-	void poll(ValloxProperty propertyId) const;	// requests a variable from the master. The result will show up in receive
+	void poll(ValloxProperty propertyId);		// requests a variable from the master. The result will show up in receive
+
+	// tracked polls: the callback fires when the master replied or after the last retry timed out.
+	// the timeout runs from the moment the poll is sent and pauses while the bus is suspended.
+	// returns false if the property can not be polled, too many polls are pending or the variable
+	// is pending already with the callback of another caller.
+	bool poll(ValloxProperty propertyId, PollCompletedCallbackFunction callbackFunction, void* pContext = NULL);
+	bool pollVariable(uint8_t variable, PollCompletedCallbackFunction callbackFunction = NULL, void* pContext = NULL);
+	uint8_t pollSet(const ValloxPropertyMask& mask);	// polls every variable of the properties once, returns the number of variables requested
+	void setPollTimeout(uint16_t timeoutMs, uint8_t maxRetries);
+	bool getPollStatistics(uint8_t variable, ValloxPollStatistics* pStatistics) const;	// round trip latency of a recently polled variable
+
+	// keeps the property fresh by polling it when it is older than its maximum age (needs a clock).
+	// values seen on the bus count as fresh, intervals follow how often the value changes and
+	// variables the master does not answer are polled less and less often.
+#if VALLOX_SCHEDULER
+	bool schedule(ValloxProperty propertyId, uint16_t maxAgeSeconds, uint8_t priority = 0);
+	bool schedule(ValloxProperty propertyId);	// maximum age and priority by kind of variable
+	void unschedule(ValloxProperty propertyId);
+	void setScheduleInterval(uint16_t intervalMs);	// bus budget: minimum time between two scheduled polls
+#endif
+
+	void setNonBlockingTransmit(bool nonBlocking);	// queue telegrams instead of waiting until they are sent
+	void tick();								// sends queued telegrams, called by receive() and receiveAll() as well
+	bool isTransmitting() const;
+	uint8_t getQueuedTelegrams() const;
+
+	// non blocking transmit only: wait until the bus was idle for the given number of characters (0 = off).
+	// with echo check our own telegram has to be received unchanged, otherwise it is sent again after a random backoff.
+	void setListenBeforeTalk(uint8_t idleCharacters, bool echoCheck = false, uint8_t maxRetries = 3);
+
+	// writes made while the CO2 sensor communication suspends the bus are sent after the resume,
+	// the latest value of a variable only. Without a resume sending starts again after the timeout (0 = never, needs a clock).
+	void setSuspendTimeout(uint16_t timeoutMs);
+	bool isSuspended() const;
+
+	// write transactions of the setters, confirmed ones need a clock.
+	// the callback reports every confirmed or failed write, the statistics are kept per variable.
+#if VALLOX_WRITE_TRANSACTIONS
+	void setWriteMode(ValloxWriteMode mode);
+	void setWriteTimeout(uint16_t timeoutMs, uint8_t maxRetries);
+#endif
+	bool writeVariable(uint8_t variable, uint8_t value);	// raw value, returns true if it will be confirmed
+#if VALLOX_WRITE_TRANSACTIONS
+	void attachWriteCompleted(WriteCompletedCallbackFunction callbackFunction, void* pContext = NULL);
+	void detachWriteCompleted(WriteCompletedCallbackFunction callbackFunction);
+	bool getWriteStatistics(uint8_t variable, ValloxWriteStatistics* pStatistics) const;
+#endif
+
+	const ValloxStatistics& getStatistics() const;
+	void resetStatistics();
+#if VALLOX_PROFILING
+	ValloxProfiler& getProfiler();		// latency histograms of the receive path and the callbacks
+#endif
 
 	void attachPropertyChanged(PropertyChangedCallbackFunction callbackFunction);
 	void detachPropertyChanged(PropertyChangedCallbackFunction callbackFunction);
+
+	void attachPropertiesChanged(PropertiesChangedCallbackFunction callbackFunction);	// used by the batch notification modes
+	void detachPropertiesChanged(PropertiesChangedCallbackFunction callbackFunction);
+
+	// any number of listeners up to VALLOX_MAX_SUBSCRIBERS, called for every change of the given properties.
+	// a minimum interval between two calls requires a clock.
+	int8_t subscribe(PropertySubscriberFunction callbackFunction, void* pContext, const ValloxPropertyMask& properties, unsigned long minimumIntervalMs = 0);
+	void unsubscribe(int8_t subscription);
+
+	void attachClock(ClockFunction clockFunction);	// defaults to millis() on arduino
+	void detachClock(ClockFunction clockFunction);
 	
 	void attach(StartSendingFunction startSendingCallback, StopSendingFunction stopSendingCallback);
 	void detach(StartSendingFunction startSendingCallback, StopSendingFunction stopSendingCallback);
 
+	// records the raw traffic into the given trace until detached
+	void attachTrace(ValloxTrace* pTrace);
+	void detachTrace(ValloxTrace* pTrace);
+
+	// queues every property change for the application to pop when it suits, in addition to the callbacks
+	void attachEventQueue(ValloxEventQueue* pEventQueue);
+	void detachEventQueue(ValloxEventQueue* pEventQueue);
+
 	// diagnostic callbacks
 	void attachLogger(LogCallbackFunction callbackFunction);
 	void detachLogger(LogCallbackFunction callbackFunction);
@@ -169,60 +307,60 @@ public:
 	void detach(SuspendResumeCallbackFunction callbackFunction);
 
 private:
-	void send(uint8_t variable, uint8_t value, uint8_t destination = VALLOX_ADDRESS_MASTER) const;
-
-	inline void updateFanSpeed(int8_t fanSpeed);
-	inline void updateTempInside(int8_t temperature);
-	inline void updateTempOutside(int8_t temperature);
-	inline void updateTempExhaust(int8_t temperature);
-	inline void updateTempIncomming(int8_t temperature);
-
-	inline void  updateSelectStatus(int8_t select);
-
-	inline void updateHumidity(int8_t humidity);
-	inline void updateBasicHumidityLevel(int8_t value);
-	inline void updateHumiditySensor1(int8_t value);
-	inline void updateHumiditySensor2(int8_t value);
-
-	inline void updateCO2High(int8_t value);
-	inline void updateCO2Low(int8_t value);
-	inline void updateCO2SetPointHigh(int8_t value);
-	inline void updateCO2SetPointLow(int8_t value);
-
-	inline void updateFanSpeedMax(int8_t fanSpeed);
-	inline void updateFanSpeedMin(int8_t fanSpeed);
-	inline void updateDCFanInputAdjustment(int8_t value);
-	inline void updateDCFanOutputAdjustment(int8_t value);
-	inline void updateInputFanStopThreshold(int8_t temperature);
-
-	inline void updateHeatingSetPoint(int8_t temperature);
-	inline void updatePreHeatingSetPoint(int8_t temperature);
-	inline void updateHRCBypassThreshold(int8_t temperature);
-	inline void updateCellDefrostingThreshold(int8_t temperature);
-
-	inline void updateProgram(int8_t program);
-	inline void updateProgram2(int8_t program);
-
-	inline void updateServiceReminder(int8_t value);
-
-	inline void updateMultiPurposeIoPort1(int8_t value);
-	inline void updateMultiPurposeIoPort2(int8_t value);
-	inline void updateCurrentIncomming(int8_t value);
-	inline void updateLastErrorNumber(int8_t value);
-
+	bool send(uint8_t variable, uint8_t value, uint8_t destination = VALLOX_ADDRESS_MASTER, ValloxTransmitPriority priority = TransmitWrite);
+	inline void expirePolls();
+	void resendPolls(uint8_t slots);
+#if VALLOX_WRITE_TRANSACTIONS
+	inline void expireWrites();
+	inline void rewrite(uint8_t slot);
+	void pollWritten(uint8_t variable);
+	inline void restoreProperties(uint8_t slot);
+	inline void onWriteCompleted(uint8_t slot, bool confirmed);
+	static uint8_t getVariableProperties(uint8_t variable, ValloxProperty* pProperties);
+#endif
+#if VALLOX_SCHEDULER
+	inline void pollScheduled();
+#endif
+	inline void transmitNext();
+	inline void preparePollTelegram();
+	inline void transmit(uint8_t variable, uint8_t value, uint8_t destination);
+	inline bool isTransmitComplete() const;
+	inline bool isQueued(uint8_t variable, uint8_t value, uint8_t destination) const;
+	inline void observeBus();
+	inline bool isBusIdle() const;
+	inline bool isTelegramWaiting() const;
+	inline bool checkEcho();
+	inline void backoff();
+
+	inline bool receiveTelegram(bool* pTelegramReceived);
+	inline bool receiveWindow(bool* pTelegramReceived);
+	inline void skipWindowBytes();
+	inline bool processTelegram(uint8_t sender, uint8_t receiver, uint8_t command, uint8_t arg);
+	inline void traceStrayByte(uint8_t value);
+	inline void countTelegram(uint8_t sender, uint8_t receiver, uint8_t variable);
+	inline void updateByteRate();
+
+	inline bool decodeVariable(uint8_t variable, uint8_t arg);
+	inline void updateProperty(ValloxProperty propertyId, int8_t value);
+	inline void updateBitfields(uint8_t firstBitfield, uint8_t bitfieldCount, uint8_t value);
 	inline void updateEfficiencies();
+	inline void publish();
 
 	
 
 	inline void log(const char* message) const;
 	inline void onSuspended(bool suspended);
 	inline void onPropertyChanged(ValloxProperty propertyId, int8_t value) const;
+	inline void onPropertiesChanged();
+	inline void onSubscriptionsPending();
+	inline unsigned long now() const;
 	inline void onStartSending() const;
 	inline void onStopSending() const;
 	inline bool onTelegramReceived(uint8_t sender, uint8_t receiver, uint8_t command, uint8_t arg);
 
 	// callback functions
 	PropertyChangedCallbackFunction m_PropertyChangedCallback;
+	PropertiesChangedCallbackFunction m_PropertiesChangedCallback;
 	StartSendingFunction m_StartSendingCallback;
 	StopSendingFunction m_StopSendingCallback;
 
@@ -231,87 +369,91 @@ private:
 	TelegramChecksumFailureCallbackFunction m_TelegramChecksumFailureCallback;
 	UnexpectedByteReceivedCallbackFunction m_UnexpectedByteReceivedCallbackFunction;
 	SuspendResumeCallbackFunction m_SuspendResumeCallbackFunction;
+	ClockFunction m_ClockFunction;
+	ValloxTrace* m_pTrace;
+	ValloxEventQueue* m_pEventQueue;
 
 	// properties
-	int8_t m_FanSpeed;
-	int8_t m_TempInside;
-	int8_t m_TempOutside;
-	int8_t m_TempExhaust;
-	int8_t m_TempIncomming;
-
-	// status
-	int8_t m_SelectStatus;
-
-	// status bits
-	int8_t m_PowerState;
-	int8_t m_CO2AdjustState;
-	int8_t m_HumidityAdjustState;
-	int8_t m_HeatingState;
-	int8_t m_FilterGuardIndicator;
-	int8_t m_HeatingIndicator;
-	int8_t m_FaultIndicator;
-	int8_t m_ServiceReminderIndicator;
-
-	int8_t m_Humidity;
-	int8_t m_BasicHumidityLevel;
-
-	int8_t m_HumiditySensor1;
-	int8_t m_HumiditySensor2;
-	int8_t m_CO2High;
-	int8_t m_CO2Low;
-	int8_t m_CO2SetPointHigh;
-	int8_t m_CO2SetPointLow;
-
-	int8_t m_FanSpeedMax;
-	int8_t m_FanSpeedMin;
-	int8_t m_DCFanInputAdjustment;
-	int8_t m_DCFanOutputAdjustment;
-	int8_t m_InputFanStopThreshold;
-
-	int8_t m_HeatingSetPoint;
-	int8_t m_PreHeatingSetPoint;
-	int8_t m_HrcBypassThreshold;
-	int8_t m_CellDefrostingThreshold;
-	
-	// program
-	int8_t m_AdjustmentIntervalMinutes;
-	int8_t m_AutomaticHumidityLevelSeekerState;
-	int8_t m_BoostSwitchMode;
-	int8_t m_RadiatorType;
-	int8_t m_CascadeAdjust;
-
-	// program 2
-	int8_t m_MaxSpeedLimitMode;
-
-	int8_t m_ServiceReminder;
-
-	// multi purpose ioport 1
-	int8_t m_PostHeatingOn;
-
-	// multi purpose ioport 2
-	int8_t m_DamperMotorPosition;
-	int8_t m_FaultSignalRelay;
-	int8_t m_SupplyFanOff;
-	int8_t m_PreHeatingOn;
-	int8_t m_ExhaustFanOff;
-	int8_t m_FirePlaceBoosterOn;
-
-	int8_t m_IncommingCurrent;
-	int8_t m_LastErrorNumber;
+	ValloxPropertyStore m_Properties;
+	ValloxNotificationMode m_NotificationMode;
+	ValloxPropertyMask m_ChangedProperties;	// changes not reported yet in the batch modes
+	ValloxSubscribers m_Subscribers;
+#if VALLOX_SHARED_STORE
+	ValloxSharedStore m_SharedStore;
+	bool m_Unpublished;						// properties changed since the last publish
+#endif
+
+	// non blocking transmitter
+	bool m_NonBlockingTransmit;
+	bool m_Transmitting;
+	unsigned long m_TransmitStart;
+	ValloxTransmitQueue m_TransmitQueue;
+
+	// poll correlation
+	ValloxPollTable m_PollTable;
+	uint16_t m_PollTimeout;
+	uint8_t m_PollRetries;
+
+#if VALLOX_WRITE_TRANSACTIONS
+	// write transactions
+	ValloxWriteTable m_WriteTable;
+	ValloxWriteMode m_WriteMode;
+	uint16_t m_WriteTimeout;
+	uint8_t m_WriteRetries;
+	WriteCompletedCallbackFunction m_WriteCompletedCallback;
+	void* m_pWriteCompletedContext;
+#endif
+
+#if VALLOX_SCHEDULER
+	// polling scheduler
+	ValloxScheduler m_Scheduler;
+	uint16_t m_ScheduleInterval;
+	unsigned long m_LastScheduledPoll;
+#endif
+	bool m_Ticking;
+
+	// listen before talk
+	uint16_t m_BusIdleTime;				// ms, 0 = off
+	bool m_EchoCheck;
+	uint8_t m_MaxRetries;
+	unsigned long m_LastBusActivity;
+	int m_ObservedBytes;
+	unsigned long m_BackoffStart;
+	uint16_t m_BackoffTime;
+	uint16_t m_BackoffRandom;
+	ValloxQueuedTelegram m_CurrentTelegram;
+	bool m_CurrentPending;				// m_CurrentTelegram waits for the bus or for a retry
+	bool m_CurrentDeferred;
+	uint8_t m_CurrentRetries;
+	bool m_EchoPending;
+	bool m_EchoReceived;
 
 	bool m_TxSuspended;
-
-	// calculated properties
-	int8_t m_InEfficiency;
-	int8_t m_OutEfficiency;
-	int8_t m_AverageEfficiency;
+	unsigned long m_SuspendStart;
+	uint16_t m_SuspendTimeout;
 
 	// members
 	uint8_t m_ReceiverId;
 	uint8_t m_SenderId;
+	uint8_t m_PollTelegram[VALLOX_LENGTH];	// poll of the master in our name, only the variable and the checksum change
+	uint8_t m_PollChecksum;					// checksum of the poll telegram without the variable
 
 	Stream* m_pRxSerial;
 	Stream* m_pTxSerial;
+
+	// resynchronizing receiver
+	bool m_Resynchronize;
+	bool m_Synchronized;
+	uint8_t m_Window[VALLOX_LENGTH];
+	uint8_t m_WindowLength;
+
+	ValloxStatistics m_Statistics;
+	unsigned long m_LastTelegramTime;
+	unsigned long m_RateStart;
+	uint32_t m_RateBytes;					// received bytes when the current second started
+#if VALLOX_PROFILING
+	mutable ValloxProfiler m_Profiler;		// the const callbacks are measured as well
+#endif
 };
 
 
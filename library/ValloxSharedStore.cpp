@@ -0,0 +1,75 @@
+#include <ValloxSharedStore.h>
+
+#if VALLOX_SHARED_STORE
+
+// the copies use relaxed atomic byte accesses, so a reader racing with the writer reads torn data at worst, which it throws away
+ValloxSharedStore::ValloxSharedStore()
+{
+	ValloxPropertyStore initial;
+	const uint8_t* pSource = (const uint8_t*)&initial;
+	for (uint8_t i = 0; i < sizeof(m_Store); i++)
+	{
+		m_Store[i] = pSource[i];
+	}
+	m_Sequence = 0;
+}
+
+void ValloxSharedStore::publish(const ValloxPropertyStore& store)
+{
+	uint32_t sequence = __atomic_load_n(&m_Sequence, __ATOMIC_RELAXED);
+	__atomic_store_n(&m_Sequence, sequence + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	const uint8_t* pSource = (const uint8_t*)&store;
+	for (uint8_t i = 0; i < sizeof(m_Store); i++)
+	{
+		__atomic_store_n(&m_Store[i], pSource[i], __ATOMIC_RELAXED);
+	}
+
+	__atomic_store_n(&m_Sequence, sequence + 2, __ATOMIC_RELEASE);
+}
+
+// waits while the writer copies
+uint32_t ValloxSharedStore::beginRead() const
+{
+	uint32_t sequence;
+	while ((sequence = __atomic_load_n(&m_Sequence, __ATOMIC_ACQUIRE)) & 1)
+	{
+	}
+	return sequence;
+}
+
+// true if the writer did not publish while we copied
+bool ValloxSharedStore::endRead(uint32_t sequence) const
+{
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	return __atomic_load_n(&m_Sequence, __ATOMIC_RELAXED) == sequence;
+}
+
+void ValloxSharedStore::read(ValloxPropertyStore& store) const
+{
+	uint8_t* pTarget = (uint8_t*)&store;
+	uint32_t sequence;
+	do
+	{
+		sequence = beginRead();
+		for (uint8_t i = 0; i < sizeof(m_Store); i++)
+		{
+			pTarget[i] = __atomic_load_n(&m_Store[i], __ATOMIC_RELAXED);
+		}
+	} while (!endRead(sequence));
+}
+
+int8_t ValloxSharedStore::getValue(ValloxProperty propertyId) const
+{
+	ValloxPropertyStore store;
+	read(store);
+	return store.getValue(propertyId);
+}
+
+uint32_t ValloxSharedStore::getSequence() const
+{
+	return beginRead();
+}
+
+#endif // VALLOX_SHARED_STORE
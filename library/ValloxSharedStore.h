@@ -0,0 +1,52 @@
+// Copy of the property store for readers on other threads.
+//
+// The receiving thread publishes its store once a telegram is decoded
+// completely, so the properties decoded from one variable (e.g. the select
+// status and its bits) or calculated together (the efficiencies) are only
+// ever seen together. The copy is guarded by a sequence lock: the sequence is
+// odd while the writer copies, a reader copies as well and starts again if the
+// sequence was odd or changed meanwhile. Readers never block the receiving
+// thread and do not block each other.
+//
+// Only needed where other threads or cores read the properties, so on the
+// Arduino cores it is left out unless VALLOX_SHARED_STORE is set to 1.
+
+#ifndef ValloxSharedStore_h
+#define ValloxSharedStore_h
+
+#include <ValloxPropertyStore.h>
+#include <inttypes.h>
+
+#ifndef VALLOX_SHARED_STORE
+#ifdef ARDUINO
+#define VALLOX_SHARED_STORE 0
+#else
+#define VALLOX_SHARED_STORE 1
+#endif
+#endif
+
+#if VALLOX_SHARED_STORE
+
+class ValloxSharedStore
+{
+public:
+	ValloxSharedStore();
+
+	void publish(const ValloxPropertyStore& store);		// receiving thread only
+
+	// any thread, a consistent copy of the last published store
+	void read(ValloxPropertyStore& store) const;
+	int8_t getValue(ValloxProperty propertyId) const;
+	uint32_t getSequence() const;		// even, changes with every publish, e.g. to skip unchanged snapshots
+
+private:
+	inline uint32_t beginRead() const;
+	inline bool endRead(uint32_t sequence) const;
+
+	uint32_t m_Sequence;
+	uint8_t m_Store[sizeof(ValloxPropertyStore)];
+};
+
+#endif // VALLOX_SHARED_STORE
+
+#endif // ValloxSharedStore_h
@@ -0,0 +1,164 @@
+#include <ValloxSubscribers.h>
+#include <ValloxPlatform.h>
+
+ValloxSubscribers::ValloxSubscribers()
+{
+	memset(m_Interested, 0, sizeof(m_Interested));
+	m_Used = 0;
+	m_Pending = 0;
+}
+
+int8_t ValloxSubscribers::add(PropertySubscriberFunction callbackFunction, void* pContext, const ValloxPropertyMask& properties, unsigned long minimumInterval)
+{
+	for (uint8_t slot = 0; slot < VALLOX_MAX_SUBSCRIBERS; slot++)
+	{
+		uint8_t slotBit = 1 << slot;
+		if ((m_Used & slotBit) == 0)
+		{
+			Subscriber& subscriber = m_Subscribers[slot];
+			subscriber.callback = callbackFunction;
+			subscriber.pContext = pContext;
+			subscriber.minimumInterval = minimumInterval;
+			subscriber.intervalStart = 0;
+			subscriber.notified.clear();
+			subscriber.pending.clear();
+
+			uint8_t index = 0;
+			while (properties.next(&index))
+			{
+				m_Interested[index] |= slotBit;
+				index++;
+			}
+
+			m_Used |= slotBit;
+			return slot;
+		}
+	}
+
+	return VALLOX_NO_SUBSCRIPTION;
+}
+
+void ValloxSubscribers::remove(int8_t subscription)
+{
+	if (subscription >= 0 && subscription < VALLOX_MAX_SUBSCRIBERS)
+	{
+		uint8_t slotMask = ~(1 << subscription);
+		for (uint8_t index = 0; index < VALLOX_PROPERTY_COUNT; index++)
+		{
+			m_Interested[index] &= slotMask;
+		}
+		m_Used &= slotMask;
+		m_Pending &= slotMask;
+	}
+}
+
+bool ValloxSubscribers::isEmpty() const
+{
+	return m_Used == 0;
+}
+
+bool ValloxSubscribers::hasPending() const
+{
+	return m_Pending != 0;
+}
+
+// ends the interval once it has elapsed, nothing is notified before the first one starts
+bool ValloxSubscribers::isIntervalRunning(Subscriber& subscriber, unsigned long now)
+{
+	// the subtraction is safe when the clock wraps around
+	if (subscriber.minimumInterval == 0 || now - subscriber.intervalStart >= subscriber.minimumInterval)
+	{
+		subscriber.notified.clear();
+	}
+	return !subscriber.notified.isEmpty();
+}
+
+void ValloxSubscribers::markNotified(Subscriber& subscriber, uint8_t index, unsigned long now)
+{
+	if (subscriber.minimumInterval != 0)
+	{
+		if (subscriber.notified.isEmpty())
+		{
+			subscriber.intervalStart = now;
+		}
+		subscriber.notified.set(index);
+	}
+}
+
+void ValloxSubscribers::notify(uint8_t index, const ValloxPropertyStore& properties, unsigned long now)
+{
+	ValloxProperty propertyId = ValloxPropertyStore::propertyAt(index);
+
+	uint8_t slots = m_Interested[index];
+	for (uint8_t slot = 0; slots != 0; slot++, slots >>= 1)
+	{
+		uint8_t slotBit = 1 << slot;
+
+		// a callback may have removed a later subscriber meanwhile
+		if ((slots & 1) && (m_Interested[index] & slotBit))
+		{
+			Subscriber& subscriber = m_Subscribers[slot];
+			if (isIntervalRunning(subscriber, now))
+			{
+				if (subscriber.notified.test(index))
+				{
+					subscriber.pending.set(index);
+					m_Pending |= slotBit;
+					continue;
+				}
+			}
+			else if (m_Pending & slotBit)
+			{
+				// the changes held back go out first, they carry this value if it is one of them
+				bool held = subscriber.pending.test(index);
+				deliverPending(slot, properties, now);
+				if (held || (m_Interested[index] & slotBit) == 0)
+				{
+					continue;
+				}
+			}
+
+			markNotified(subscriber, index, now);
+			(*subscriber.callback)(subscriber.pContext, propertyId, properties.get(index));
+		}
+	}
+}
+
+void ValloxSubscribers::notifyPending(const ValloxPropertyStore& properties, unsigned long now)
+{
+	uint8_t slots = m_Pending;
+	for (uint8_t slot = 0; slots != 0; slot++, slots >>= 1)
+	{
+		if ((slots & 1) && (m_Pending & (1 << slot)) && !isIntervalRunning(m_Subscribers[slot], now))
+		{
+			deliverPending(slot, properties, now);
+		}
+	}
+}
+
+// the held back properties start the next interval
+void ValloxSubscribers::deliverPending(uint8_t slot, const ValloxPropertyStore& properties, unsigned long now)
+{
+	uint8_t slotBit = 1 << slot;
+	Subscriber& subscriber = m_Subscribers[slot];
+
+	// the callback may change properties again, so it works on a copy
+	ValloxPropertyMask pending = subscriber.pending;
+	subscriber.pending.clear();
+	subscriber.notified = pending;
+	subscriber.intervalStart = now;
+	m_Pending &= ~slotBit;
+
+	uint8_t index = 0;
+	while (pending.next(&index))
+	{
+		// skipped when a callback removed the subscriber meanwhile
+		if ((m_Interested[index] & slotBit) == 0)
+		{
+			index++;
+			continue;
+		}
+		(*subscriber.callback)(subscriber.pContext, ValloxPropertyStore::propertyAt(index), properties.get(index));
+		index++;
+	}
+}
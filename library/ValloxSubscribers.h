@@ -0,0 +1,69 @@
+// Fixed size table of property change subscribers.
+//
+// Every subscriber is a callback with a user context, the set of properties
+// it is interested in and an optional minimum interval between two
+// notifications. For every property a bitmask of the interested subscriber
+// slots is kept, so a change only visits the subscribers that want it.
+// With a minimum interval a subscriber gets every property at most once per
+// interval. The interval starts with the first notification, so the first
+// changes after a subscription go through at once. Further changes of a
+// property already notified within the interval are held back and delivered
+// with their latest value once it has elapsed, other properties are not held
+// up by them.
+
+#ifndef ValloxSubscribers_h
+#define ValloxSubscribers_h
+
+#include <ValloxPropertyStore.h>
+#include <inttypes.h>
+
+// maximum number of subscribers, at most 8 as the slots are kept in a byte
+#ifndef VALLOX_MAX_SUBSCRIBERS
+#define VALLOX_MAX_SUBSCRIBERS 4
+#endif
+
+static_assert(VALLOX_MAX_SUBSCRIBERS > 0 && VALLOX_MAX_SUBSCRIBERS <= 8, "VALLOX_MAX_SUBSCRIBERS must be 1..8");
+
+const int8_t VALLOX_NO_SUBSCRIPTION = -1;
+
+extern "C" {
+	typedef void(*PropertySubscriberFunction)(void* pContext, ValloxProperty propertyId, int8_t value);
+}
+
+class ValloxSubscribers
+{
+public:
+	ValloxSubscribers();
+
+	// returns the subscription or VALLOX_NO_SUBSCRIPTION if the table is full
+	int8_t add(PropertySubscriberFunction callbackFunction, void* pContext, const ValloxPropertyMask& properties, unsigned long minimumInterval);
+	void remove(int8_t subscription);
+
+	bool isEmpty() const;
+	bool hasPending() const;
+
+	void notify(uint8_t index, const ValloxPropertyStore& properties, unsigned long now);	// a property changed
+	void notifyPending(const ValloxPropertyStore& properties, unsigned long now);	// delivers held back changes whose interval elapsed
+
+private:
+	struct Subscriber
+	{
+		PropertySubscriberFunction callback;
+		void* pContext;
+		unsigned long minimumInterval;
+		unsigned long intervalStart;
+		ValloxPropertyMask notified;		// properties notified since intervalStart
+		ValloxPropertyMask pending;			// held back until the interval has elapsed
+	};
+
+	inline bool isIntervalRunning(Subscriber& subscriber, unsigned long now);
+	inline void markNotified(Subscriber& subscriber, uint8_t index, unsigned long now);
+	void deliverPending(uint8_t slot, const ValloxPropertyStore& properties, unsigned long now);
+
+	Subscriber m_Subscribers[VALLOX_MAX_SUBSCRIBERS];
+	uint8_t m_Interested[VALLOX_PROPERTY_COUNT];	// subscriber slots per compact property index
+	uint8_t m_Used;									// allocated subscriber slots
+	uint8_t m_Pending;								// slots with held back changes
+};
+
+#endif // ValloxSubscribers_h
@@ -0,0 +1,143 @@
+#include <ValloxTrace.h>
+#include <ValloxPlatform.h>
+
+ValloxTrace::ValloxTrace()
+{
+	clear();
+}
+
+void ValloxTrace::clear()
+{
+	m_Head = 0;
+	m_Count = 0;
+	m_Dropped = 0;
+	m_FirstTime = 0;
+	m_LastTime = 0;
+}
+
+void ValloxTrace::recordTelegram(const uint8_t* pTelegram, bool transmitted, unsigned long now)
+{
+	ValloxTraceRecord& record = append(TraceTelegram | (transmitted ? VALLOX_TRACE_TRANSMITTED : 0), now);
+	memcpy(record.data, pTelegram, VALLOX_LENGTH);
+}
+
+void ValloxTrace::recordChecksumFailure(const uint8_t* pTelegram, unsigned long now)
+{
+	ValloxTraceRecord& record = append(TraceChecksumFailure, now);
+	memcpy(record.data, pTelegram, VALLOX_LENGTH);
+}
+
+void ValloxTrace::recordStrayByte(uint8_t value, unsigned long now)
+{
+	// bytes skipped at once share a record
+	if (m_Count > 0 && now == m_LastTime)
+	{
+		ValloxTraceRecord& last = m_Records[(m_Head + m_Count - 1) % VALLOX_TRACE_SIZE];
+		uint8_t count = (last.info & VALLOX_TRACE_COUNT_MASK) >> VALLOX_TRACE_COUNT_SHIFT;
+		if ((last.info & VALLOX_TRACE_KIND_MASK) == TraceStrayBytes && count < VALLOX_LENGTH)
+		{
+			last.data[count] = value;
+			last.info = TraceStrayBytes | ((count + 1) << VALLOX_TRACE_COUNT_SHIFT);
+			return;
+		}
+	}
+
+	ValloxTraceRecord& record = append(TraceStrayBytes | (1 << VALLOX_TRACE_COUNT_SHIFT), now);
+	memset(record.data, 0, VALLOX_LENGTH);
+	record.data[0] = value;
+}
+
+uint16_t ValloxTrace::size() const
+{
+	return m_Count;
+}
+
+uint32_t ValloxTrace::getDropped() const
+{
+	return m_Dropped;
+}
+
+const ValloxTraceRecord& ValloxTrace::get(uint16_t index) const
+{
+	return m_Records[(m_Head + index) % VALLOX_TRACE_SIZE];
+}
+
+size_t ValloxTrace::dump(Stream& out) const
+{
+	uint8_t header[VALLOX_TRACE_HEADER_LENGTH] =
+	{
+		'V', 'X', 'T', 'R', VALLOX_TRACE_VERSION, sizeof(ValloxTraceRecord),
+		(uint8_t)m_Count, (uint8_t)(m_Count >> 8),
+		(uint8_t)m_FirstTime, (uint8_t)(m_FirstTime >> 8), (uint8_t)(m_FirstTime >> 16), (uint8_t)(m_FirstTime >> 24),
+		(uint8_t)m_Dropped, (uint8_t)(m_Dropped >> 8), (uint8_t)(m_Dropped >> 16), (uint8_t)(m_Dropped >> 24)
+	};
+	size_t written = out.write(header, sizeof(header));
+
+	// the ring may wrap: the part up to the end of the buffer, then the rest from its start
+	uint16_t first = m_Count < VALLOX_TRACE_SIZE - m_Head ? m_Count : VALLOX_TRACE_SIZE - m_Head;
+	written += out.write((const uint8_t*)&m_Records[m_Head], first * sizeof(ValloxTraceRecord));
+	written += out.write((const uint8_t*)&m_Records[0], (m_Count - first) * sizeof(ValloxTraceRecord));
+	return written;
+}
+
+// adds a record, preceded by a gap record if the time since the last one does not fit into the delta byte
+ValloxTraceRecord& ValloxTrace::append(uint8_t info, unsigned long now)
+{
+	unsigned long delta = m_Count > 0 ? now - m_LastTime : 0;
+	if (m_Count == 0)
+	{
+		m_FirstTime = now;
+	}
+	m_LastTime = now;
+
+	if (delta > 0xFF)
+	{
+		ValloxTraceRecord& gap = push();
+		gap.info = TraceGap;
+		gap.delta = 0;
+		gap.data[0] = (uint8_t)delta;
+		gap.data[1] = (uint8_t)(delta >> 8);
+		gap.data[2] = (uint8_t)(delta >> 16);
+		gap.data[3] = (uint8_t)(delta >> 24);
+		gap.data[4] = 0;
+		gap.data[5] = 0;
+		delta = 0;
+	}
+
+	ValloxTraceRecord& record = push();
+	record.info = info;
+	record.delta = (uint8_t)delta;
+	return record;
+}
+
+// the next free record, the oldest one is dropped when the buffer is full
+ValloxTraceRecord& ValloxTrace::push()
+{
+	if (m_Count == VALLOX_TRACE_SIZE)
+	{
+		m_Head = (m_Head + 1) % VALLOX_TRACE_SIZE;
+		m_Count--;
+		m_Dropped++;
+
+		// the next record becomes the first one, so its delta moves into the start time
+		ValloxTraceRecord& oldest = m_Records[m_Head];
+		m_FirstTime += getDelta(oldest);
+		oldest.delta = 0;
+		if ((oldest.info & VALLOX_TRACE_KIND_MASK) == TraceGap)
+		{
+			memset(oldest.data, 0, 4);
+		}
+	}
+
+	return m_Records[(m_Head + m_Count++) % VALLOX_TRACE_SIZE];
+}
+
+unsigned long ValloxTrace::getDelta(const ValloxTraceRecord& record)
+{
+	if ((record.info & VALLOX_TRACE_KIND_MASK) == TraceGap)
+	{
+		return (unsigned long)record.data[0] | ((unsigned long)record.data[1] << 8) |
+			((unsigned long)record.data[2] << 16) | ((unsigned long)record.data[3] << 24);
+	}
+	return record.delta;
+}
@@ -0,0 +1,84 @@
+// Ring buffer of the raw bus traffic for diagnostics.
+//
+// Every received or sent telegram, every telegram with a bad checksum and
+// every stray byte is kept in an 8 byte record together with the time since
+// the previous record. When the buffer is full the oldest records are
+// overwritten. dump() writes the records oldest first as one binary blob:
+//
+//   header  16 bytes  "VXTR", version, record size, record count (uint16),
+//                     time of the first record in ms (uint32), dropped records (uint32)
+//   records 8 bytes   info, delta in ms, 6 data bytes
+//
+// All numbers are little endian. The info byte holds the kind of the record
+// in bits 0-1, the number of stray bytes in bits 2-4 and the transmit flag in
+// bit 7. Gaps of more than 255 ms are stored as a gap record holding the
+// whole delta (uint32) in its data bytes.
+
+#ifndef ValloxTrace_h
+#define ValloxTrace_h
+
+#include <ValloxProtocol.h>
+#include <Stream.h>
+#include <inttypes.h>
+
+// number of records, 8 bytes each
+#ifndef VALLOX_TRACE_SIZE
+#define VALLOX_TRACE_SIZE 32
+#endif
+
+enum ValloxTraceKind
+{
+	TraceTelegram,			// valid telegram
+	TraceChecksumFailure,	// 6 bytes starting with the domain
+	TraceStrayBytes,		// up to 6 bytes outside of telegrams
+	TraceGap				// delta too large for the delta byte
+};
+
+const uint8_t VALLOX_TRACE_KIND_MASK = 0x03;
+const uint8_t VALLOX_TRACE_COUNT_SHIFT = 2;
+const uint8_t VALLOX_TRACE_COUNT_MASK = 0x1C;
+const uint8_t VALLOX_TRACE_TRANSMITTED = 0x80;
+
+const uint8_t VALLOX_TRACE_VERSION = 1;
+const uint8_t VALLOX_TRACE_HEADER_LENGTH = 16;
+
+struct ValloxTraceRecord
+{
+	uint8_t info;
+	uint8_t delta;						// ms since the previous record
+	uint8_t data[VALLOX_LENGTH];
+};
+
+static_assert(sizeof(ValloxTraceRecord) == 8, "trace records must be packed");
+
+class ValloxTrace
+{
+public:
+	ValloxTrace();
+
+	void clear();
+
+	void recordTelegram(const uint8_t* pTelegram, bool transmitted, unsigned long now);
+	void recordChecksumFailure(const uint8_t* pTelegram, unsigned long now);
+	void recordStrayByte(uint8_t value, unsigned long now);
+
+	uint16_t size() const;
+	uint32_t getDropped() const;				// records overwritten since the last clear()
+	const ValloxTraceRecord& get(uint16_t index) const;	// 0 is the oldest record
+
+	size_t dump(Stream& out) const;				// header and records, returns the number of bytes written
+
+private:
+	inline ValloxTraceRecord& append(uint8_t info, unsigned long now);
+	inline ValloxTraceRecord& push();
+	static inline unsigned long getDelta(const ValloxTraceRecord& record);
+
+	ValloxTraceRecord m_Records[VALLOX_TRACE_SIZE];
+	uint16_t m_Head;				// oldest record
+	uint16_t m_Count;
+	uint32_t m_Dropped;
+	unsigned long m_FirstTime;		// time of the oldest record
+	unsigned long m_LastTime;		// time of the newest record
+};
+
+#endif // ValloxTrace_h
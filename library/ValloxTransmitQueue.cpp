@@ -0,0 +1,94 @@
+#include <ValloxTransmitQueue.h>
+
+ValloxTransmitQueue::ValloxTransmitQueue()
+{
+	clear();
+}
+
+void ValloxTransmitQueue::clear()
+{
+	for (uint8_t priority = 0; priority < TransmitPriorityCount; priority++)
+	{
+		m_Rings[priority].head = 0;
+		m_Rings[priority].count = 0;
+	}
+}
+
+bool ValloxTransmitQueue::isEmpty() const
+{
+	return size() == 0;
+}
+
+uint8_t ValloxTransmitQueue::size() const
+{
+	uint8_t count = 0;
+	for (uint8_t priority = 0; priority < TransmitPriorityCount; priority++)
+	{
+		count += m_Rings[priority].count;
+	}
+	return count;
+}
+
+bool ValloxTransmitQueue::isFull(ValloxTransmitPriority priority) const
+{
+	return m_Rings[priority].count == VALLOX_TX_QUEUE_SIZE;
+}
+
+bool ValloxTransmitQueue::push(ValloxTransmitPriority priority, const ValloxQueuedTelegram& telegram)
+{
+	Ring& ring = m_Rings[priority];
+	if (ring.count == VALLOX_TX_QUEUE_SIZE)
+	{
+		return false;
+	}
+
+	ring.telegrams[(ring.head + ring.count) % VALLOX_TX_QUEUE_SIZE] = telegram;
+	ring.count++;
+	return true;
+}
+
+bool ValloxTransmitQueue::replace(ValloxTransmitPriority priority, const ValloxQueuedTelegram& telegram)
+{
+	Ring& ring = m_Rings[priority];
+	for (uint8_t i = 0; i < ring.count; i++)
+	{
+		ValloxQueuedTelegram& queued = ring.telegrams[(ring.head + i) % VALLOX_TX_QUEUE_SIZE];
+		if (queued.variable == telegram.variable && queued.destination == telegram.destination)
+		{
+			queued.value = telegram.value;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool ValloxTransmitQueue::contains(ValloxTransmitPriority priority, const ValloxQueuedTelegram& telegram) const
+{
+	const Ring& ring = m_Rings[priority];
+	for (uint8_t i = 0; i < ring.count; i++)
+	{
+		const ValloxQueuedTelegram& queued = ring.telegrams[(ring.head + i) % VALLOX_TX_QUEUE_SIZE];
+		if (queued.variable == telegram.variable && queued.value == telegram.value && queued.destination == telegram.destination)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+bool ValloxTransmitQueue::pop(ValloxQueuedTelegram* pTelegram)
+{
+	for (uint8_t priority = 0; priority < TransmitPriorityCount; priority++)
+	{
+		Ring& ring = m_Rings[priority];
+		if (ring.count > 0)
+		{
+			*pTelegram = ring.telegrams[ring.head];
+			ring.head = (ring.head + 1) % VALLOX_TX_QUEUE_SIZE;
+			ring.count--;
+			return true;
+		}
+	}
+
+	return false;
+}
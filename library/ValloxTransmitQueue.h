@@ -0,0 +1,57 @@
+// Ring buffers of telegrams waiting to be sent.
+//
+// Writes requested by the user are kept apart from polls, so they are always
+// sent first no matter how many polls are waiting. A write of a variable which
+// is still waiting can replace the queued value, so only the latest one is sent.
+
+#ifndef ValloxTransmitQueue_h
+#define ValloxTransmitQueue_h
+
+#include <inttypes.h>
+
+// telegrams per priority
+#ifndef VALLOX_TX_QUEUE_SIZE
+#define VALLOX_TX_QUEUE_SIZE 8
+#endif
+
+enum ValloxTransmitPriority
+{
+	TransmitWrite,	// user commands
+	TransmitPoll,	// background requests
+	TransmitPriorityCount
+};
+
+struct ValloxQueuedTelegram
+{
+	uint8_t variable;
+	uint8_t value;
+	uint8_t destination;
+};
+
+class ValloxTransmitQueue
+{
+public:
+	ValloxTransmitQueue();
+
+	void clear();
+	bool isEmpty() const;
+	uint8_t size() const;
+	bool isFull(ValloxTransmitPriority priority) const;
+
+	bool push(ValloxTransmitPriority priority, const ValloxQueuedTelegram& telegram);	// returns false if that priority is full
+	bool replace(ValloxTransmitPriority priority, const ValloxQueuedTelegram& telegram);	// returns false if no telegram of that variable waits
+	bool contains(ValloxTransmitPriority priority, const ValloxQueuedTelegram& telegram) const;	// the same telegram waits already
+	bool pop(ValloxQueuedTelegram* pTelegram);		// takes the oldest telegram of the highest priority
+
+private:
+	struct Ring
+	{
+		ValloxQueuedTelegram telegrams[VALLOX_TX_QUEUE_SIZE];
+		uint8_t head;
+		uint8_t count;
+	};
+
+	Ring m_Rings[TransmitPriorityCount];
+};
+
+#endif // ValloxTransmitQueue_h
@@ -0,0 +1,534 @@
+// Descriptor tables driving the decoding of received telegrams.
+//
+// VALLOX_VARIABLES has one entry for every possible variable byte, so the
+// decoder of a telegram is found with a single indexed lookup. An entry names
+// the conversion to apply, the property that receives the result and for bit
+// encoded variables the range of VALLOX_BITFIELDS to extract.
+//
+// Both tables are constant and live in flash on AVR.
+
+#ifndef ValloxVariableTable_h
+#define ValloxVariableTable_h
+
+#include <ValloxPlatform.h>
+#include <ValloxSerial.h>
+
+// decoder in the lower nibble of ValloxVariableDescriptor::type
+const uint8_t VALLOX_DECODER_MASK = 0x0F;
+const uint8_t VALLOX_DECODE_UNKNOWN = 0;		// not part of the protocol: logged and not handled
+const uint8_t VALLOX_DECODE_IGNORE = 1;			// part of the protocol, intentionally not decoded
+const uint8_t VALLOX_DECODE_RAW = 2;			// value is taken as is
+const uint8_t VALLOX_DECODE_TEMPERATURE = 3;	// NTC sensor scale to degree celsius
+const uint8_t VALLOX_DECODE_FAN_SPEED = 4;		// bitmap 0x01..0xFF to fan speed 1-8
+const uint8_t VALLOX_DECODE_BITFIELD = 5;		// raw value (optional) and bit fields
+const uint8_t VALLOX_DECODE_SUSPEND = 6;		// CO2 sensor communication starts
+const uint8_t VALLOX_DECODE_RESUME = 7;			// CO2 sensor communication ends
+
+// flags in the upper nibble of ValloxVariableDescriptor::type
+const uint8_t VALLOX_FLAG_SETTING = 0x10;		// configuration value which rarely changes
+const uint8_t VALLOX_FLAG_BROADCAST = 0x20;		// periodically broadcasted by the master
+const uint8_t VALLOX_FLAG_INDICATORS = 0x40;	// the master owns the upper nibble, a write only sets the lower one
+
+const uint8_t VALLOX_NO_PROPERTY = 0xFF;
+
+struct ValloxVariableDescriptor
+{
+	uint8_t type;			// decoder | flags
+	uint8_t property;		// ValloxProperty receiving the (raw) value or VALLOX_NO_PROPERTY
+	uint8_t firstBitfield;	// index into VALLOX_BITFIELDS
+	uint8_t bitfieldCount;
+};
+
+// one property encoded in some bits of a variable: value = (raw & mask) >> shift
+struct ValloxBitfieldDescriptor
+{
+	uint8_t property;
+	uint8_t mask;
+	uint8_t shift;
+};
+
+enum ValloxBitfieldGroup
+{
+	VALLOX_BITFIELDS_SELECT = 0,
+	VALLOX_BITFIELDS_SELECT_COUNT = 8,
+	VALLOX_BITFIELDS_PROGRAM = VALLOX_BITFIELDS_SELECT + VALLOX_BITFIELDS_SELECT_COUNT,
+	VALLOX_BITFIELDS_PROGRAM_COUNT = 5,
+	VALLOX_BITFIELDS_PROGRAM2 = VALLOX_BITFIELDS_PROGRAM + VALLOX_BITFIELDS_PROGRAM_COUNT,
+	VALLOX_BITFIELDS_PROGRAM2_COUNT = 1,
+	VALLOX_BITFIELDS_IOPORT_MULTI_PURPOSE_1 = VALLOX_BITFIELDS_PROGRAM2 + VALLOX_BITFIELDS_PROGRAM2_COUNT,
+	VALLOX_BITFIELDS_IOPORT_MULTI_PURPOSE_1_COUNT = 1,
+	VALLOX_BITFIELDS_IOPORT_MULTI_PURPOSE_2 = VALLOX_BITFIELDS_IOPORT_MULTI_PURPOSE_1 + VALLOX_BITFIELDS_IOPORT_MULTI_PURPOSE_1_COUNT,
+	VALLOX_BITFIELDS_IOPORT_MULTI_PURPOSE_2_COUNT = 6,
+	VALLOX_BITFIELDS_COUNT = VALLOX_BITFIELDS_IOPORT_MULTI_PURPOSE_2 + VALLOX_BITFIELDS_IOPORT_MULTI_PURPOSE_2_COUNT
+};
+
+static constexpr ValloxBitfieldDescriptor VALLOX_BITFIELDS[VALLOX_BITFIELDS_COUNT] PROGMEM =
+{
+	// VALLOX_VARIABLE_SELECT
+	{ PowerStateProperty, 0x01, 0 },
+	{ CO2AdjustStateProperty, 0x02, 1 },
+	{ HumidityAdjustStateProperty, 0x04, 2 },
+	{ HeatingStateProperty, 0x08, 3 },
+	{ FilterGuardIndicatorProperty, 0x10, 4 },
+	{ HeatingIndicatorProperty, 0x20, 5 },
+	{ FaultIndicatorProperty, 0x40, 6 },
+	{ ServiceReminderIndicatorProperty, 0x80, 7 },
+
+	// VALLOX_VARIABLE_PROGRAM
+	{ AdjustmentIntervalMinutesProperty, 0x0F, 0 },
+	{ AutomaticHumidityLevelSeekerStateProperty, 0x10, 4 },
+	{ BoostSwitchModeProperty, 0x20, 5 },
+	{ RadiatorTypeProperty, 0x40, 6 },
+	{ CascadeAdjustProperty, 0x80, 7 },
+
+	// VALLOX_VARIABLE_PROGRAM2
+	{ MaxSpeedLimitModeProperty, 0x01, 0 },
+
+	// VALLOX_VARIABLE_IOPORT_MULTI_PURPOSE_1
+	{ PostHeatingOnProperty, 0x20, 5 },
+
+	// VALLOX_VARIABLE_IOPORT_MULTI_PURPOSE_2
+	{ DamperMotorPositionProperty, 0x02, 1 },
+	{ FaultSignalRelayProperty, 0x04, 2 },
+	{ SupplyFanOffProperty, 0x08, 3 },
+	{ PreHeatingOnProperty, 0x10, 4 },
+	{ ExhaustFanOffProperty, 0x20, 5 },
+	{ FirePlaceBoosterOnProperty, 0x40, 6 }
+};
+
+#define VALLOX_UNKNOWN_VARIABLE { VALLOX_DECODE_UNKNOWN, VALLOX_NO_PROPERTY, 0, 0 }
+
+// indexed by the variable byte of a telegram
+static constexpr ValloxVariableDescriptor VALLOX_VARIABLES[256] PROGMEM =
+{
+	VALLOX_UNKNOWN_VARIABLE, // 0x00 VALLOX_VARIABLE_POLL
+	VALLOX_UNKNOWN_VARIABLE, // 0x01
+	VALLOX_UNKNOWN_VARIABLE, // 0x02
+	VALLOX_UNKNOWN_VARIABLE, // 0x03
+	VALLOX_UNKNOWN_VARIABLE, // 0x04
+	VALLOX_UNKNOWN_VARIABLE, // 0x05
+	{ VALLOX_DECODE_IGNORE, VALLOX_NO_PROPERTY, 0, 0 }, // 0x06 VALLOX_VARIABLE_IOPORT_FANSPEED_RELAYS
+	{ VALLOX_DECODE_BITFIELD, VALLOX_NO_PROPERTY, VALLOX_BITFIELDS_IOPORT_MULTI_PURPOSE_1, VALLOX_BITFIELDS_IOPORT_MULTI_PURPOSE_1_COUNT }, // 0x07 VALLOX_VARIABLE_IOPORT_MULTI_PURPOSE_1
+	{ VALLOX_DECODE_BITFIELD, VALLOX_NO_PROPERTY, VALLOX_BITFIELDS_IOPORT_MULTI_PURPOSE_2, VALLOX_BITFIELDS_IOPORT_MULTI_PURPOSE_2_COUNT }, // 0x08 VALLOX_VARIABLE_IOPORT_MULTI_PURPOSE_2
+	VALLOX_UNKNOWN_VARIABLE, // 0x09
+	VALLOX_UNKNOWN_VARIABLE, // 0x0A
+	VALLOX_UNKNOWN_VARIABLE, // 0x0B
+	VALLOX_UNKNOWN_VARIABLE, // 0x0C
+	VALLOX_UNKNOWN_VARIABLE, // 0x0D
+	VALLOX_UNKNOWN_VARIABLE, // 0x0E
+	VALLOX_UNKNOWN_VARIABLE, // 0x0F
+	VALLOX_UNKNOWN_VARIABLE, // 0x10
+	VALLOX_UNKNOWN_VARIABLE, // 0x11
+	VALLOX_UNKNOWN_VARIABLE, // 0x12
+	VALLOX_UNKNOWN_VARIABLE, // 0x13
+	VALLOX_UNKNOWN_VARIABLE, // 0x14
+	VALLOX_UNKNOWN_VARIABLE, // 0x15
+	VALLOX_UNKNOWN_VARIABLE, // 0x16
+	VALLOX_UNKNOWN_VARIABLE, // 0x17
+	VALLOX_UNKNOWN_VARIABLE, // 0x18
+	VALLOX_UNKNOWN_VARIABLE, // 0x19
+	VALLOX_UNKNOWN_VARIABLE, // 0x1A
+	VALLOX_UNKNOWN_VARIABLE, // 0x1B
+	VALLOX_UNKNOWN_VARIABLE, // 0x1C
+	VALLOX_UNKNOWN_VARIABLE, // 0x1D
+	VALLOX_UNKNOWN_VARIABLE, // 0x1E
+	VALLOX_UNKNOWN_VARIABLE, // 0x1F
+	VALLOX_UNKNOWN_VARIABLE, // 0x20
+	VALLOX_UNKNOWN_VARIABLE, // 0x21
+	VALLOX_UNKNOWN_VARIABLE, // 0x22
+	VALLOX_UNKNOWN_VARIABLE, // 0x23
+	VALLOX_UNKNOWN_VARIABLE, // 0x24
+	VALLOX_UNKNOWN_VARIABLE, // 0x25
+	VALLOX_UNKNOWN_VARIABLE, // 0x26
+	VALLOX_UNKNOWN_VARIABLE, // 0x27
+	VALLOX_UNKNOWN_VARIABLE, // 0x28
+	{ VALLOX_DECODE_FAN_SPEED | VALLOX_FLAG_BROADCAST, FanSpeedProperty, 0, 0 }, // 0x29 VALLOX_VARIABLE_FAN_SPEED
+	{ VALLOX_DECODE_RAW, HumidityProperty, 0, 0 }, // 0x2A VALLOX_VARIABLE_HUMIDITY
+	{ VALLOX_DECODE_RAW, CO2HighProperty, 0, 0 }, // 0x2B VALLOX_VARIABLE_CO2_HIGH
+	{ VALLOX_DECODE_RAW, CO2LowProperty, 0, 0 }, // 0x2C VALLOX_VARIABLE_CO2_LOW
+	{ VALLOX_DECODE_IGNORE, VALLOX_NO_PROPERTY, 0, 0 }, // 0x2D VALLOX_VARIABLE_INSTALLED_CO2_SENSORS
+	{ VALLOX_DECODE_RAW, IncommingCurrentProperty, 0, 0 }, // 0x2E VALLOX_VARIABLE_CURRENT_INCOMMING
+	{ VALLOX_DECODE_RAW, HumiditySensor1Property, 0, 0 }, // 0x2F VALLOX_VARIABLE_HUMIDITY_SENSOR1
+	{ VALLOX_DECODE_RAW, HumiditySensor2Property, 0, 0 }, // 0x30 VALLOX_VARIABLE_HUMIDITY_SENSOR2
+	VALLOX_UNKNOWN_VARIABLE, // 0x31
+	{ VALLOX_DECODE_TEMPERATURE | VALLOX_FLAG_BROADCAST, TempOutsideProperty, 0, 0 }, // 0x32 VALLOX_VARIABLE_TEMP_OUTSIDE
+	{ VALLOX_DECODE_TEMPERATURE | VALLOX_FLAG_BROADCAST, TempExhaustProperty, 0, 0 }, // 0x33 VALLOX_VARIABLE_TEMP_EXHAUST
+	{ VALLOX_DECODE_TEMPERATURE | VALLOX_FLAG_BROADCAST, TempInsideProperty, 0, 0 }, // 0x34 VALLOX_VARIABLE_TEMP_INSIDE
+	{ VALLOX_DECODE_TEMPERATURE | VALLOX_FLAG_BROADCAST, TempIncommingProperty, 0, 0 }, // 0x35 VALLOX_VARIABLE_TEMP_INCOMMING
+	{ VALLOX_DECODE_RAW, LastErrorNumberProperty, 0, 0 }, // 0x36 VALLOX_VARIABLE_LAST_ERROR_NUMBER
+	VALLOX_UNKNOWN_VARIABLE, // 0x37
+	VALLOX_UNKNOWN_VARIABLE, // 0x38
+	VALLOX_UNKNOWN_VARIABLE, // 0x39
+	VALLOX_UNKNOWN_VARIABLE, // 0x3A
+	VALLOX_UNKNOWN_VARIABLE, // 0x3B
+	VALLOX_UNKNOWN_VARIABLE, // 0x3C
+	VALLOX_UNKNOWN_VARIABLE, // 0x3D
+	VALLOX_UNKNOWN_VARIABLE, // 0x3E
+	VALLOX_UNKNOWN_VARIABLE, // 0x3F
+	VALLOX_UNKNOWN_VARIABLE, // 0x40
+	VALLOX_UNKNOWN_VARIABLE, // 0x41
+	VALLOX_UNKNOWN_VARIABLE, // 0x42
+	VALLOX_UNKNOWN_VARIABLE, // 0x43
+	VALLOX_UNKNOWN_VARIABLE, // 0x44
+	VALLOX_UNKNOWN_VARIABLE, // 0x45
+	VALLOX_UNKNOWN_VARIABLE, // 0x46
+	VALLOX_UNKNOWN_VARIABLE, // 0x47
+	VALLOX_UNKNOWN_VARIABLE, // 0x48
+	VALLOX_UNKNOWN_VARIABLE, // 0x49
+	VALLOX_UNKNOWN_VARIABLE, // 0x4A
+	VALLOX_UNKNOWN_VARIABLE, // 0x4B
+	VALLOX_UNKNOWN_VARIABLE, // 0x4C
+	VALLOX_UNKNOWN_VARIABLE, // 0x4D
+	VALLOX_UNKNOWN_VARIABLE, // 0x4E
+	VALLOX_UNKNOWN_VARIABLE, // 0x4F
+	VALLOX_UNKNOWN_VARIABLE, // 0x50
+	VALLOX_UNKNOWN_VARIABLE, // 0x51
+	VALLOX_UNKNOWN_VARIABLE, // 0x52
+	VALLOX_UNKNOWN_VARIABLE, // 0x53
+	VALLOX_UNKNOWN_VARIABLE, // 0x54
+	{ VALLOX_DECODE_IGNORE, VALLOX_NO_PROPERTY, 0, 0 }, // 0x55 VALLOX_VARIABLE_POST_HEATING_ON_COUNTER
+	{ VALLOX_DECODE_IGNORE, VALLOX_NO_PROPERTY, 0, 0 }, // 0x56 VALLOX_VARIABLE_POST_HEATING_OFF_TIME
+	{ VALLOX_DECODE_IGNORE, VALLOX_NO_PROPERTY, 0, 0 }, // 0x57 VALLOX_VARIABLE_POST_HEATING_TARGET_VALUE
+	VALLOX_UNKNOWN_VARIABLE, // 0x58
+	VALLOX_UNKNOWN_VARIABLE, // 0x59
+	VALLOX_UNKNOWN_VARIABLE, // 0x5A
+	VALLOX_UNKNOWN_VARIABLE, // 0x5B
+	VALLOX_UNKNOWN_VARIABLE, // 0x5C
+	VALLOX_UNKNOWN_VARIABLE, // 0x5D
+	VALLOX_UNKNOWN_VARIABLE, // 0x5E
+	VALLOX_UNKNOWN_VARIABLE, // 0x5F
+	VALLOX_UNKNOWN_VARIABLE, // 0x60
+	VALLOX_UNKNOWN_VARIABLE, // 0x61
+	VALLOX_UNKNOWN_VARIABLE, // 0x62
+	VALLOX_UNKNOWN_VARIABLE, // 0x63
+	VALLOX_UNKNOWN_VARIABLE, // 0x64
+	VALLOX_UNKNOWN_VARIABLE, // 0x65
+	VALLOX_UNKNOWN_VARIABLE, // 0x66
+	VALLOX_UNKNOWN_VARIABLE, // 0x67
+	VALLOX_UNKNOWN_VARIABLE, // 0x68
+	VALLOX_UNKNOWN_VARIABLE, // 0x69
+	VALLOX_UNKNOWN_VARIABLE, // 0x6A
+	VALLOX_UNKNOWN_VARIABLE, // 0x6B
+	{ VALLOX_DECODE_IGNORE, VALLOX_NO_PROPERTY, 0, 0 }, // 0x6C VALLOX_VARIABLE_FLAGS_1
+	{ VALLOX_DECODE_IGNORE, VALLOX_NO_PROPERTY, 0, 0 }, // 0x6D VALLOX_VARIABLE_FLAGS_2
+	{ VALLOX_DECODE_IGNORE, VALLOX_NO_PROPERTY, 0, 0 }, // 0x6E VALLOX_VARIABLE_FLAGS_3
+	{ VALLOX_DECODE_IGNORE, VALLOX_NO_PROPERTY, 0, 0 }, // 0x6F VALLOX_VARIABLE_FLAGS_4
+	{ VALLOX_DECODE_IGNORE, VALLOX_NO_PROPERTY, 0, 0 }, // 0x70 VALLOX_VARIABLE_FLAGS_5
+	{ VALLOX_DECODE_IGNORE, VALLOX_NO_PROPERTY, 0, 0 }, // 0x71 VALLOX_VARIABLE_FLAGS_6
+	VALLOX_UNKNOWN_VARIABLE, // 0x72
+	VALLOX_UNKNOWN_VARIABLE, // 0x73
+	VALLOX_UNKNOWN_VARIABLE, // 0x74
+	VALLOX_UNKNOWN_VARIABLE, // 0x75
+	VALLOX_UNKNOWN_VARIABLE, // 0x76
+	VALLOX_UNKNOWN_VARIABLE, // 0x77
+	VALLOX_UNKNOWN_VARIABLE, // 0x78
+	{ VALLOX_DECODE_IGNORE, VALLOX_NO_PROPERTY, 0, 0 }, // 0x79 VALLOX_VARIABLE_FIRE_PLACE_BOOSTER_COUNTER
+	VALLOX_UNKNOWN_VARIABLE, // 0x7A
+	VALLOX_UNKNOWN_VARIABLE, // 0x7B
+	VALLOX_UNKNOWN_VARIABLE, // 0x7C
+	VALLOX_UNKNOWN_VARIABLE, // 0x7D
+	VALLOX_UNKNOWN_VARIABLE, // 0x7E
+	VALLOX_UNKNOWN_VARIABLE, // 0x7F
+	VALLOX_UNKNOWN_VARIABLE, // 0x80
+	VALLOX_UNKNOWN_VARIABLE, // 0x81
+	VALLOX_UNKNOWN_VARIABLE, // 0x82
+	VALLOX_UNKNOWN_VARIABLE, // 0x83
+	VALLOX_UNKNOWN_VARIABLE, // 0x84
+	VALLOX_UNKNOWN_VARIABLE, // 0x85
+	VALLOX_UNKNOWN_VARIABLE, // 0x86
+	VALLOX_UNKNOWN_VARIABLE, // 0x87
+	VALLOX_UNKNOWN_VARIABLE, // 0x88
+	VALLOX_UNKNOWN_VARIABLE, // 0x89
+	VALLOX_UNKNOWN_VARIABLE, // 0x8A
+	VALLOX_UNKNOWN_VARIABLE, // 0x8B
+	VALLOX_UNKNOWN_VARIABLE, // 0x8C
+	VALLOX_UNKNOWN_VARIABLE, // 0x8D
+	VALLOX_UNKNOWN_VARIABLE, // 0x8E
+	{ VALLOX_DECODE_RESUME, VALLOX_NO_PROPERTY, 0, 0 }, // 0x8F VALLOX_VARIABLE_RESUME
+	VALLOX_UNKNOWN_VARIABLE, // 0x90
+	{ VALLOX_DECODE_SUSPEND, VALLOX_NO_PROPERTY, 0, 0 }, // 0x91 VALLOX_VARIABLE_SUSPEND
+	VALLOX_UNKNOWN_VARIABLE, // 0x92
+	VALLOX_UNKNOWN_VARIABLE, // 0x93
+	VALLOX_UNKNOWN_VARIABLE, // 0x94
+	VALLOX_UNKNOWN_VARIABLE, // 0x95
+	VALLOX_UNKNOWN_VARIABLE, // 0x96
+	VALLOX_UNKNOWN_VARIABLE, // 0x97
+	VALLOX_UNKNOWN_VARIABLE, // 0x98
+	VALLOX_UNKNOWN_VARIABLE, // 0x99
+	VALLOX_UNKNOWN_VARIABLE, // 0x9A
+	VALLOX_UNKNOWN_VARIABLE, // 0x9B
+	VALLOX_UNKNOWN_VARIABLE, // 0x9C
+	VALLOX_UNKNOWN_VARIABLE, // 0x9D
+	VALLOX_UNKNOWN_VARIABLE, // 0x9E
+	VALLOX_UNKNOWN_VARIABLE, // 0x9F
+	VALLOX_UNKNOWN_VARIABLE, // 0xA0
+	VALLOX_UNKNOWN_VARIABLE, // 0xA1
+	VALLOX_UNKNOWN_VARIABLE, // 0xA2
+	{ VALLOX_DECODE_BITFIELD | VALLOX_FLAG_INDICATORS, SelectStatusProperty, VALLOX_BITFIELDS_SELECT, VALLOX_BITFIELDS_SELECT_COUNT }, // 0xA3 VALLOX_VARIABLE_SELECT
+	{ VALLOX_DECODE_TEMPERATURE | VALLOX_FLAG_SETTING, HeatingSetPointProperty, 0, 0 }, // 0xA4 VALLOX_VARIABLE_HEATING_SET_POINT
+	{ VALLOX_DECODE_FAN_SPEED | VALLOX_FLAG_SETTING, FanSpeedMaxProperty, 0, 0 }, // 0xA5 VALLOX_VARIABLE_FAN_SPEED_MAX
+	{ VALLOX_DECODE_RAW | VALLOX_FLAG_SETTING, ServiceReminderProperty, 0, 0 }, // 0xA6 VALLOX_VARIABLE_SERVICE_REMINDER
+	{ VALLOX_DECODE_TEMPERATURE | VALLOX_FLAG_SETTING, PreHeatingSetPointProperty, 0, 0 }, // 0xA7 VALLOX_VARIABLE_PRE_HEATING_SET_POINT
+	{ VALLOX_DECODE_TEMPERATURE | VALLOX_FLAG_SETTING, InputFanStopThresholdProperty, 0, 0 }, // 0xA8 VALLOX_VARIABLE_INPUT_FAN_STOP
+	{ VALLOX_DECODE_FAN_SPEED | VALLOX_FLAG_SETTING, FanSpeedMinProperty, 0, 0 }, // 0xA9 VALLOX_VARIABLE_FAN_SPEED_MIN
+	{ VALLOX_DECODE_BITFIELD | VALLOX_FLAG_SETTING, VALLOX_NO_PROPERTY, VALLOX_BITFIELDS_PROGRAM, VALLOX_BITFIELDS_PROGRAM_COUNT }, // 0xAA VALLOX_VARIABLE_PROGRAM
+	{ VALLOX_DECODE_IGNORE, VALLOX_NO_PROPERTY, 0, 0 }, // 0xAB VALLOX_VARIABLE_MAINTENANCE_MONTH_COUNTER
+	VALLOX_UNKNOWN_VARIABLE, // 0xAC
+	VALLOX_UNKNOWN_VARIABLE, // 0xAD
+	{ VALLOX_DECODE_RAW | VALLOX_FLAG_SETTING, BasicHumidityLevelProperty, 0, 0 }, // 0xAE VALLOX_VARIABLE_BASIC_HUMIDITY_LEVEL
+	{ VALLOX_DECODE_TEMPERATURE | VALLOX_FLAG_SETTING, HrcBypassThresholdProperty, 0, 0 }, // 0xAF VALLOX_VARIABLE_HRC_BYPASS
+	{ VALLOX_DECODE_RAW | VALLOX_FLAG_SETTING, DCFanInputAdjustmentProperty, 0, 0 }, // 0xB0 VALLOX_VARIABLE_DC_FAN_INPUT_ADJUSTMENT
+	{ VALLOX_DECODE_RAW | VALLOX_FLAG_SETTING, DCFanOutputAdjustmentProperty, 0, 0 }, // 0xB1 VALLOX_VARIABLE_DC_FAN_OUTPUT_ADJUSTMENT
+	{ VALLOX_DECODE_TEMPERATURE | VALLOX_FLAG_SETTING, CellDefrostingThresholdProperty, 0, 0 }, // 0xB2 VALLOX_VARIABLE_CELL_DEFROSTING
+	{ VALLOX_DECODE_RAW | VALLOX_FLAG_SETTING, CO2SetPointHighProperty, 0, 0 }, // 0xB3 VALLOX_VARIABLE_CO2_SET_POINT_UPPER
+	{ VALLOX_DECODE_RAW | VALLOX_FLAG_SETTING, CO2SetPointLowProperty, 0, 0 }, // 0xB4 VALLOX_VARIABLE_CO2_SET_POINT_LOWER
+	{ VALLOX_DECODE_BITFIELD | VALLOX_FLAG_SETTING, VALLOX_NO_PROPERTY, VALLOX_BITFIELDS_PROGRAM2, VALLOX_BITFIELDS_PROGRAM2_COUNT }, // 0xB5 VALLOX_VARIABLE_PROGRAM2
+	VALLOX_UNKNOWN_VARIABLE, // 0xB6
+	VALLOX_UNKNOWN_VARIABLE, // 0xB7
+	VALLOX_UNKNOWN_VARIABLE, // 0xB8
+	VALLOX_UNKNOWN_VARIABLE, // 0xB9
+	VALLOX_UNKNOWN_VARIABLE, // 0xBA
+	VALLOX_UNKNOWN_VARIABLE, // 0xBB
+	VALLOX_UNKNOWN_VARIABLE, // 0xBC
+	VALLOX_UNKNOWN_VARIABLE, // 0xBD
+	VALLOX_UNKNOWN_VARIABLE, // 0xBE
+	VALLOX_UNKNOWN_VARIABLE, // 0xBF
+	{ VALLOX_DECODE_IGNORE, VALLOX_NO_PROPERTY, 0, 0 }, // 0xC0 VALLOX_VARIABLE_UNKNOWN
+	VALLOX_UNKNOWN_VARIABLE, // 0xC1
+	VALLOX_UNKNOWN_VARIABLE, // 0xC2
+	VALLOX_UNKNOWN_VARIABLE, // 0xC3
+	VALLOX_UNKNOWN_VARIABLE, // 0xC4
+	VALLOX_UNKNOWN_VARIABLE, // 0xC5
+	VALLOX_UNKNOWN_VARIABLE, // 0xC6
+	VALLOX_UNKNOWN_VARIABLE, // 0xC7
+	VALLOX_UNKNOWN_VARIABLE, // 0xC8
+	VALLOX_UNKNOWN_VARIABLE, // 0xC9
+	VALLOX_UNKNOWN_VARIABLE, // 0xCA
+	VALLOX_UNKNOWN_VARIABLE, // 0xCB
+	VALLOX_UNKNOWN_VARIABLE, // 0xCC
+	VALLOX_UNKNOWN_VARIABLE, // 0xCD
+	VALLOX_UNKNOWN_VARIABLE, // 0xCE
+	VALLOX_UNKNOWN_VARIABLE, // 0xCF
+	VALLOX_UNKNOWN_VARIABLE, // 0xD0
+	VALLOX_UNKNOWN_VARIABLE, // 0xD1
+	VALLOX_UNKNOWN_VARIABLE, // 0xD2
+	VALLOX_UNKNOWN_VARIABLE, // 0xD3
+	VALLOX_UNKNOWN_VARIABLE, // 0xD4
+	VALLOX_UNKNOWN_VARIABLE, // 0xD5
+	VALLOX_UNKNOWN_VARIABLE, // 0xD6
+	VALLOX_UNKNOWN_VARIABLE, // 0xD7
+	VALLOX_UNKNOWN_VARIABLE, // 0xD8
+	VALLOX_UNKNOWN_VARIABLE, // 0xD9
+	VALLOX_UNKNOWN_VARIABLE, // 0xDA
+	VALLOX_UNKNOWN_VARIABLE, // 0xDB
+	VALLOX_UNKNOWN_VARIABLE, // 0xDC
+	VALLOX_UNKNOWN_VARIABLE, // 0xDD
+	VALLOX_UNKNOWN_VARIABLE, // 0xDE
+	VALLOX_UNKNOWN_VARIABLE, // 0xDF
+	VALLOX_UNKNOWN_VARIABLE, // 0xE0
+	VALLOX_UNKNOWN_VARIABLE, // 0xE1
+	VALLOX_UNKNOWN_VARIABLE, // 0xE2
+	VALLOX_UNKNOWN_VARIABLE, // 0xE3
+	VALLOX_UNKNOWN_VARIABLE, // 0xE4
+	VALLOX_UNKNOWN_VARIABLE, // 0xE5
+	VALLOX_UNKNOWN_VARIABLE, // 0xE6
+	VALLOX_UNKNOWN_VARIABLE, // 0xE7
+	VALLOX_UNKNOWN_VARIABLE, // 0xE8
+	VALLOX_UNKNOWN_VARIABLE, // 0xE9
+	VALLOX_UNKNOWN_VARIABLE, // 0xEA
+	VALLOX_UNKNOWN_VARIABLE, // 0xEB
+	VALLOX_UNKNOWN_VARIABLE, // 0xEC
+	VALLOX_UNKNOWN_VARIABLE, // 0xED
+	VALLOX_UNKNOWN_VARIABLE, // 0xEE
+	VALLOX_UNKNOWN_VARIABLE, // 0xEF
+	VALLOX_UNKNOWN_VARIABLE, // 0xF0
+	VALLOX_UNKNOWN_VARIABLE, // 0xF1
+	VALLOX_UNKNOWN_VARIABLE, // 0xF2
+	VALLOX_UNKNOWN_VARIABLE, // 0xF3
+	VALLOX_UNKNOWN_VARIABLE, // 0xF4
+	VALLOX_UNKNOWN_VARIABLE, // 0xF5
+	VALLOX_UNKNOWN_VARIABLE, // 0xF6
+	VALLOX_UNKNOWN_VARIABLE, // 0xF7
+	VALLOX_UNKNOWN_VARIABLE, // 0xF8
+	VALLOX_UNKNOWN_VARIABLE, // 0xF9
+	VALLOX_UNKNOWN_VARIABLE, // 0xFA
+	VALLOX_UNKNOWN_VARIABLE, // 0xFB
+	VALLOX_UNKNOWN_VARIABLE, // 0xFC
+	VALLOX_UNKNOWN_VARIABLE, // 0xFD
+	VALLOX_UNKNOWN_VARIABLE, // 0xFE
+	VALLOX_UNKNOWN_VARIABLE // 0xFF
+};
+
+// the table is positional: make sure every descriptor sits at its variable
+static_assert((VALLOX_VARIABLES[VALLOX_VARIABLE_IOPORT_FANSPEED_RELAYS].type & VALLOX_DECODER_MASK) == VALLOX_DECODE_IGNORE, "descriptor out of place");
+static_assert((VALLOX_VARIABLES[VALLOX_VARIABLE_IOPORT_MULTI_PURPOSE_1].type & VALLOX_DECODER_MASK) == VALLOX_DECODE_BITFIELD, "descriptor out of place");
+static_assert((VALLOX_VARIABLES[VALLOX_VARIABLE_IOPORT_MULTI_PURPOSE_2].type & VALLOX_DECODER_MASK) == VALLOX_DECODE_BITFIELD, "descriptor out of place");
+static_assert((VALLOX_VARIABLES[VALLOX_VARIABLE_FAN_SPEED].type & VALLOX_DECODER_MASK) == VALLOX_DECODE_FAN_SPEED, "descriptor out of place");
+static_assert((VALLOX_VARIABLES[VALLOX_VARIABLE_HUMIDITY].type & VALLOX_DECODER_MASK) == VALLOX_DECODE_RAW, "descriptor out of place");
+static_assert((VALLOX_VARIABLES[VALLOX_VARIABLE_CO2_HIGH].type & VALLOX_DECODER_MASK) == VALLOX_DECODE_RAW, "descriptor out of place");
+static_assert((VALLOX_VARIABLES[VALLOX_VARIABLE_CO2_LOW].type & VALLOX_DECODER_MASK) == VALLOX_DECODE_RAW, "descriptor out of place");
+static_assert((VALLOX_VARIABLES[VALLOX_VARIABLE_INSTALLED_CO2_SENSORS].type & VALLOX_DECODER_MASK) == VALLOX_DECODE_IGNORE, "descriptor out of place");
+static_assert((VALLOX_VARIABLES[VALLOX_VARIABLE_CURRENT_INCOMMING].type & VALLOX_DECODER_MASK) == VALLOX_DECODE_RAW, "descriptor out of place");
+static_assert((VALLOX_VARIABLES[VALLOX_VARIABLE_HUMIDITY_SENSOR1].type & VALLOX_DECODER_MASK) == VALLOX_DECODE_RAW, "descriptor out of place");
+static_assert((VALLOX_VARIABLES[VALLOX_VARIABLE_HUMIDITY_SENSOR2].type & VALLOX_DECODER_MASK) == VALLOX_DECODE_RAW, "descriptor out of place");
+static_assert((VALLOX_VARIABLES[VALLOX_VARIABLE_TEMP_OUTSIDE].type & VALLOX_DECODER_MASK) == VALLOX_DECODE_TEMPERATURE, "descriptor out of place");
+static_assert((VALLOX_VARIABLES[VALLOX_VARIABLE_TEMP_EXHAUST].type & VALLOX_DECODER_MASK) == VALLOX_DECODE_TEMPERATURE, "descriptor out of place");
+static_assert((VALLOX_VARIABLES[VALLOX_VARIABLE_TEMP_INSIDE].type & VALLOX_DECODER_MASK) == VALLOX_DECODE_TEMPERATURE, "descriptor out of place");
+static_assert((VALLOX_VARIABLES[VALLOX_VARIABLE_TEMP_INCOMMING].type & VALLOX_DECODER_MASK) == VALLOX_DECODE_TEMPERATURE, "descriptor out of place");
+static_assert((VALLOX_VARIABLES[VALLOX_VARIABLE_LAST_ERROR_NUMBER].type & VALLOX_DECODER_MASK) == VALLOX_DECODE_RAW, "descriptor out of place");
+static_assert((VALLOX_VARIABLES[VALLOX_VARIABLE_POST_HEATING_ON_COUNTER].type & VALLOX_DECODER_MASK) == VALLOX_DECODE_IGNORE, "descriptor out of place");
+static_assert((VALLOX_VARIABLES[VALLOX_VARIABLE_POST_HEATING_OFF_TIME].type & VALLOX_DECODER_MASK) == VALLOX_DECODE_IGNORE, "descriptor out of place");
+static_assert((VALLOX_VARIABLES[VALLOX_VARIABLE_POST_HEATING_TARGET_VALUE].type & VALLOX_DECODER_MASK) == VALLOX_DECODE_IGNORE, "descriptor out of place");
+static_assert((VALLOX_VARIABLES[VALLOX_VARIABLE_FLAGS_1].type & VALLOX_DECODER_MASK) == VALLOX_DECODE_IGNORE, "descriptor out of place");
+static_assert((VALLOX_VARIABLES[VALLOX_VARIABLE_FLAGS_2].type & VALLOX_DECODER_MASK) == VALLOX_DECODE_IGNORE, "descriptor out of place");
+static_assert((VALLOX_VARIABLES[VALLOX_VARIABLE_FLAGS_3].type & VALLOX_DECODER_MASK) == VALLOX_DECODE_IGNORE, "descriptor out of place");
+static_assert((VALLOX_VARIABLES[VALLOX_VARIABLE_FLAGS_4].type & VALLOX_DECODER_MASK) == VALLOX_DECODE_IGNORE, "descriptor out of place");
+static_assert((VALLOX_VARIABLES[VALLOX_VARIABLE_FLAGS_5].type & VALLOX_DECODER_MASK) == VALLOX_DECODE_IGNORE, "descriptor out of place");
+static_assert((VALLOX_VARIABLES[VALLOX_VARIABLE_FLAGS_6].type & VALLOX_DECODER_MASK) == VALLOX_DECODE_IGNORE, "descriptor out of place");
+static_assert((VALLOX_VARIABLES[VALLOX_VARIABLE_FIRE_PLACE_BOOSTER_COUNTER].type & VALLOX_DECODER_MASK) == VALLOX_DECODE_IGNORE, "descriptor out of place");
+static_assert((VALLOX_VARIABLES[VALLOX_VARIABLE_RESUME].type & VALLOX_DECODER_MASK) == VALLOX_DECODE_RESUME, "descriptor out of place");
+static_assert((VALLOX_VARIABLES[VALLOX_VARIABLE_SUSPEND].type & VALLOX_DECODER_MASK) == VALLOX_DECODE_SUSPEND, "descriptor out of place");
+static_assert((VALLOX_VARIABLES[VALLOX_VARIABLE_SELECT].type & VALLOX_DECODER_MASK) == VALLOX_DECODE_BITFIELD, "descriptor out of place");
+static_assert((VALLOX_VARIABLES[VALLOX_VARIABLE_HEATING_SET_POINT].type & VALLOX_DECODER_MASK) == VALLOX_DECODE_TEMPERATURE, "descriptor out of place");
+static_assert((VALLOX_VARIABLES[VALLOX_VARIABLE_FAN_SPEED_MAX].type & VALLOX_DECODER_MASK) == VALLOX_DECODE_FAN_SPEED, "descriptor out of place");
+static_assert((VALLOX_VARIABLES[VALLOX_VARIABLE_SERVICE_REMINDER].type & VALLOX_DECODER_MASK) == VALLOX_DECODE_RAW, "descriptor out of place");
+static_assert((VALLOX_VARIABLES[VALLOX_VARIABLE_PRE_HEATING_SET_POINT].type & VALLOX_DECODER_MASK) == VALLOX_DECODE_TEMPERATURE, "descriptor out of place");
+static_assert((VALLOX_VARIABLES[VALLOX_VARIABLE_INPUT_FAN_STOP].type & VALLOX_DECODER_MASK) == VALLOX_DECODE_TEMPERATURE, "descriptor out of place");
+static_assert((VALLOX_VARIABLES[VALLOX_VARIABLE_FAN_SPEED_MIN].type & VALLOX_DECODER_MASK) == VALLOX_DECODE_FAN_SPEED, "descriptor out of place");
+static_assert((VALLOX_VARIABLES[VALLOX_VARIABLE_PROGRAM].type & VALLOX_DECODER_MASK) == VALLOX_DECODE_BITFIELD, "descriptor out of place");
+static_assert((VALLOX_VARIABLES[VALLOX_VARIABLE_MAINTENANCE_MONTH_COUNTER].type & VALLOX_DECODER_MASK) == VALLOX_DECODE_IGNORE, "descriptor out of place");
+static_assert((VALLOX_VARIABLES[VALLOX_VARIABLE_BASIC_HUMIDITY_LEVEL].type & VALLOX_DECODER_MASK) == VALLOX_DECODE_RAW, "descriptor out of place");
+static_assert((VALLOX_VARIABLES[VALLOX_VARIABLE_HRC_BYPASS].type & VALLOX_DECODER_MASK) == VALLOX_DECODE_TEMPERATURE, "descriptor out of place");
+static_assert((VALLOX_VARIABLES[VALLOX_VARIABLE_DC_FAN_INPUT_ADJUSTMENT].type & VALLOX_DECODER_MASK) == VALLOX_DECODE_RAW, "descriptor out of place");
+static_assert((VALLOX_VARIABLES[VALLOX_VARIABLE_DC_FAN_OUTPUT_ADJUSTMENT].type & VALLOX_DECODER_MASK) == VALLOX_DECODE_RAW, "descriptor out of place");
+static_assert((VALLOX_VARIABLES[VALLOX_VARIABLE_CELL_DEFROSTING].type & VALLOX_DECODER_MASK) == VALLOX_DECODE_TEMPERATURE, "descriptor out of place");
+static_assert((VALLOX_VARIABLES[VALLOX_VARIABLE_CO2_SET_POINT_UPPER].type & VALLOX_DECODER_MASK) == VALLOX_DECODE_RAW, "descriptor out of place");
+static_assert((VALLOX_VARIABLES[VALLOX_VARIABLE_CO2_SET_POINT_LOWER].type & VALLOX_DECODER_MASK) == VALLOX_DECODE_RAW, "descriptor out of place");
+static_assert((VALLOX_VARIABLES[VALLOX_VARIABLE_PROGRAM2].type & VALLOX_DECODER_MASK) == VALLOX_DECODE_BITFIELD, "descriptor out of place");
+static_assert((VALLOX_VARIABLES[VALLOX_VARIABLE_UNKNOWN].type & VALLOX_DECODER_MASK) == VALLOX_DECODE_IGNORE, "descriptor out of place");
+
+// property -> variable, generated from the decoder tables above so that both directions always agree
+static constexpr bool valloxBitfieldsContain(uint8_t property, uint8_t first, uint8_t count)
+{
+	return count > 0 && (VALLOX_BITFIELDS[first].property == property || valloxBitfieldsContain(property, first + 1, count - 1));
+}
+
+static constexpr bool valloxVariableHolds(uint8_t variable, uint8_t property)
+{
+	return VALLOX_VARIABLES[variable].property == property ||
+		((VALLOX_VARIABLES[variable].type & VALLOX_DECODER_MASK) == VALLOX_DECODE_BITFIELD &&
+			valloxBitfieldsContain(property, VALLOX_VARIABLES[variable].firstBitfield, VALLOX_VARIABLES[variable].bitfieldCount));
+}
+
+static constexpr uint8_t valloxFindPropertyVariable(uint8_t property, uint16_t variable)
+{
+	return variable > 0xFF ? VALLOX_VARIABLE_POLL :
+		valloxVariableHolds((uint8_t)variable, property) ? (uint8_t)variable :
+		valloxFindPropertyVariable(property, variable + 1);
+}
+
+static constexpr uint8_t valloxMaxProperty(uint8_t first, uint8_t second)
+{
+	return first > second ? first : second;
+}
+
+// sensor, status and setting properties have the ids below the calculated ones
+static constexpr uint8_t valloxDecodedProperty(uint8_t property)
+{
+	return property < InEfficiencyProperty ? property : 0;
+}
+
+static constexpr uint8_t valloxLastBitfieldProperty(uint8_t index)
+{
+	return index >= VALLOX_BITFIELDS_COUNT ? 0 :
+		valloxMaxProperty(valloxDecodedProperty(VALLOX_BITFIELDS[index].property), valloxLastBitfieldProperty(index + 1));
+}
+
+static constexpr uint8_t valloxLastVariableProperty(uint16_t variable)
+{
+	return variable > 0xFF ? 0 :
+		valloxMaxProperty(valloxDecodedProperty(VALLOX_VARIABLES[variable].property), valloxLastVariableProperty(variable + 1));
+}
+
+// the highest id decoded from a variable or a bitfield, whatever the numbering of the enumerators is
+const uint8_t VALLOX_LAST_DECODED_PROPERTY = valloxMaxProperty(valloxLastVariableProperty(0), valloxLastBitfieldProperty(0));
+const uint8_t VALLOX_DECODED_PROPERTY_LIMIT = VALLOX_LAST_DECODED_PROPERTY + 1;
+
+template<typename Sequence> struct ValloxPropertyVariableMapping;
+
+template<uint8_t... Indices>
+struct ValloxPropertyVariableMapping<ValloxIndexSequence<Indices...> >
+{
+	static constexpr uint8_t VARIABLES[sizeof...(Indices)] PROGMEM =
+	{
+		valloxFindPropertyVariable(Indices, 1)...
+	};
+};
+
+template<uint8_t... Indices>
+constexpr uint8_t ValloxPropertyVariableMapping<ValloxIndexSequence<Indices...> >::VARIABLES[sizeof...(Indices)];
+
+// indexed by property id, VALLOX_VARIABLE_POLL for unused ids
+typedef ValloxPropertyVariableMapping<ValloxMakeIndexSequence<VALLOX_DECODED_PROPERTY_LIMIT>::Type> ValloxPropertyVariables;
+
+static_assert(ValloxPropertyVariables::VARIABLES[TempInsideProperty] == VALLOX_VARIABLE_TEMP_INSIDE, "property mapping broken");
+static_assert(ValloxPropertyVariables::VARIABLES[ServiceReminderIndicatorProperty] == VALLOX_VARIABLE_SELECT, "property mapping broken");
+static_assert(ValloxPropertyVariables::VARIABLES[SupplyFanOffProperty] == VALLOX_VARIABLE_IOPORT_MULTI_PURPOSE_2, "property mapping broken");
+static_assert(ValloxPropertyVariables::VARIABLES[LastErrorNumberProperty] == VALLOX_VARIABLE_LAST_ERROR_NUMBER, "property mapping broken");
+
+// virtual properties of variables which are not (completely) decoded, indexed by property id - SelectStatusProperty
+static constexpr uint8_t VALLOX_VIRTUAL_PROPERTY_VARIABLES[] PROGMEM =
+{
+	VALLOX_VARIABLE_SELECT,						// SelectStatusProperty
+	VALLOX_VARIABLE_PROGRAM,					// ProgramProperty
+	VALLOX_VARIABLE_PROGRAM2,					// Program2Property
+	VALLOX_VARIABLE_IOPORT_MULTI_PURPOSE_1,		// IoPortMultiPurpose1Property
+	VALLOX_VARIABLE_IOPORT_MULTI_PURPOSE_2,		// IoPortMultiPurpose2Property
+	VALLOX_VARIABLE_IOPORT_FANSPEED_RELAYS,		// IoPortFanSpeedRelaysProperty
+	VALLOX_VARIABLE_INSTALLED_CO2_SENSORS,		// InstalledCO2SensorsProperty
+	VALLOX_VARIABLE_POST_HEATING_ON_COUNTER,	// PostHeatingOnCounterProperty
+	VALLOX_VARIABLE_POST_HEATING_OFF_TIME,		// PostHeatingOffTimeProperty
+	VALLOX_VARIABLE_POST_HEATING_TARGET_VALUE,	// PostHeatingTargetValueProperty
+	VALLOX_VARIABLE_FLAGS_1,					// Flags1Property
+	VALLOX_VARIABLE_FLAGS_2,					// Flags2Property
+	VALLOX_VARIABLE_FLAGS_3,					// Flags3Property
+	VALLOX_VARIABLE_FLAGS_4,					// Flags4Property
+	VALLOX_VARIABLE_FLAGS_5,					// Flags5Property
+	VALLOX_VARIABLE_FLAGS_6,					// Flags6Property
+	VALLOX_VARIABLE_FIRE_PLACE_BOOSTER_COUNTER,	// FirePlaceBoosterCounterProperty
+	VALLOX_VARIABLE_MAINTENANCE_MONTH_COUNTER	// MaintenanceMonthCounterProperty
+};
+
+static_assert(sizeof(VALLOX_VIRTUAL_PROPERTY_VARIABLES) == MaintenanceMonthCounterProperty - SelectStatusProperty + 1, "virtual property missing");
+
+// the variable to poll for a property, VALLOX_VARIABLE_POLL if there is none
+inline uint8_t readPropertyVariable(uint8_t propertyId)
+{
+	if (propertyId < VALLOX_DECODED_PROPERTY_LIMIT)
+	{
+		return pgm_read_byte(&ValloxPropertyVariables::VARIABLES[propertyId]);
+	}
+	if (propertyId >= SelectStatusProperty && propertyId <= MaintenanceMonthCounterProperty)
+	{
+		return pgm_read_byte(&VALLOX_VIRTUAL_PROPERTY_VARIABLES[propertyId - SelectStatusProperty]);
+	}
+	return VALLOX_VARIABLE_POLL;
+}
+
+inline void readVariableDescriptor(uint8_t variable, ValloxVariableDescriptor* pDescriptor)
+{
+	memcpy_P(pDescriptor, &VALLOX_VARIABLES[variable], sizeof(ValloxVariableDescriptor));
+}
+
+// the bits of a variable a write sets, a read back confirms the write if they match
+inline uint8_t readWriteMask(uint8_t variable)
+{
+	return (pgm_read_byte(&VALLOX_VARIABLES[variable].type) & VALLOX_FLAG_INDICATORS) ? 0x0F : 0xFF;
+}
+
+inline void readBitfieldDescriptor(uint8_t index, ValloxBitfieldDescriptor* pDescriptor)
+{
+	memcpy_P(pDescriptor, &VALLOX_BITFIELDS[index], sizeof(ValloxBitfieldDescriptor));
+}
+
+#endif // ValloxVariableTable_h
@@ -0,0 +1,246 @@
+#include <ValloxWriteTable.h>
+#include <ValloxPlatform.h>
+
+#if VALLOX_WRITE_TRANSACTIONS
+
+ValloxWriteTable::ValloxWriteTable()
+{
+	memset(m_Entries, 0, sizeof(m_Entries));
+	m_Used = 0;
+	m_Pending = 0;
+	m_Sent = 0;
+	m_Polled = 0;
+	m_Rejected = 0;
+}
+
+int8_t ValloxWriteTable::find(uint8_t variable) const
+{
+	for (uint8_t slot = 0; slot < VALLOX_MAX_WRITES; slot++)
+	{
+		if ((m_Used & (1 << slot)) && m_Entries[slot].variable == variable)
+		{
+			return slot;
+		}
+	}
+	return -1;
+}
+
+int8_t ValloxWriteTable::start(uint8_t variable, uint8_t value, unsigned long now, bool* pStarted)
+{
+	int8_t slot = find(variable);
+	if (slot >= 0 && (m_Pending & (1 << slot)))
+	{
+		// the new value wins, the values to restore stay those from before the first write
+		Entry& entry = m_Entries[slot];
+		entry.value = value;
+		entry.retries = 0;
+		entry.lastWrite = now;
+		entry.statistics.writes++;
+		clearProgress(slot);
+		*pStarted = false;
+		return slot;
+	}
+
+	if (slot < 0)
+	{
+		// a free entry or the one idle for the longest time
+		unsigned long oldest = 0;
+		for (uint8_t candidate = 0; candidate < VALLOX_MAX_WRITES; candidate++)
+		{
+			uint8_t candidateBit = 1 << candidate;
+			if ((m_Used & candidateBit) == 0)
+			{
+				slot = candidate;
+				break;
+			}
+			if ((m_Pending & candidateBit) == 0 && (slot < 0 || now - m_Entries[candidate].lastWrite > oldest))
+			{
+				slot = candidate;
+				oldest = now - m_Entries[candidate].lastWrite;
+			}
+		}
+
+		if (slot < 0)
+		{
+			*pStarted = false;
+			return -1;
+		}
+
+		memset(&m_Entries[slot].statistics, 0, sizeof(ValloxWriteStatistics));
+		m_Entries[slot].variable = variable;
+		m_Used |= 1 << slot;
+	}
+
+	Entry& entry = m_Entries[slot];
+	entry.value = value;
+	entry.retries = 0;
+	entry.firstWrite = now;
+	entry.lastWrite = now;
+	entry.statistics.writes++;
+	m_Pending |= 1 << slot;
+	clearProgress(slot);
+
+	*pStarted = true;
+	return slot;
+}
+
+bool ValloxWriteTable::hasPending() const
+{
+	return m_Pending != 0;
+}
+
+void ValloxWriteTable::clearProgress(uint8_t slot)
+{
+	uint8_t slotMask = ~(1 << slot);
+	m_Sent &= slotMask;
+	m_Polled &= slotMask;
+	m_Rejected &= slotMask;
+}
+
+void ValloxWriteTable::sent(uint8_t variable)
+{
+	int8_t slot = find(variable);
+	if (slot >= 0 && (m_Pending & (1 << slot)))
+	{
+		m_Sent |= 1 << slot;
+	}
+}
+
+void ValloxWriteTable::polled(uint8_t variable)
+{
+	// a poll which overtook the write reads the old value
+	int8_t slot = find(variable);
+	if (slot >= 0 && (m_Sent & (1 << slot)))
+	{
+		m_Polled |= 1 << slot;
+	}
+}
+
+ValloxWriteResult ValloxWriteTable::received(uint8_t variable, uint8_t value, uint8_t mask, bool readBack, unsigned long now, uint8_t* pSlot)
+{
+	int8_t slot = find(variable);
+	if (slot < 0 || (m_Pending & (1 << slot)) == 0)
+	{
+		return WriteIgnored;
+	}
+
+	*pSlot = slot;
+	if (!readBack || (m_Polled & (1 << slot)) == 0)
+	{
+		return WriteStale;
+	}
+
+	// bits of the variable owned by the master may differ
+	Entry& entry = m_Entries[slot];
+	if (((entry.value ^ value) & mask) == 0)
+	{
+		uint16_t latency = getLatency(slot, now);
+		entry.statistics.confirmations++;
+		entry.statistics.lastLatency = latency;
+		entry.statistics.totalLatency += latency;
+		if (latency > entry.statistics.maxLatency)
+		{
+			entry.statistics.maxLatency = latency;
+		}
+
+		m_Pending &= ~(1 << slot);
+		clearProgress(slot);
+		return WriteConfirmed;
+	}
+
+	m_Rejected |= 1 << slot;
+	return WriteRejected;
+}
+
+uint8_t ValloxWriteTable::expire(unsigned long now, uint16_t timeout, uint8_t maxRetries, uint8_t* pFailed)
+{
+	uint8_t rewrite = 0;
+	*pFailed = 0;
+
+	for (uint8_t slot = 0; slot < VALLOX_MAX_WRITES; slot++)
+	{
+		Entry& entry = m_Entries[slot];
+		uint8_t slotBit = 1 << slot;
+		if ((m_Pending & slotBit) && now - entry.lastWrite >= timeout)
+		{
+			if (entry.retries < maxRetries)
+			{
+				entry.retries++;
+				entry.lastWrite = now;
+				entry.statistics.retries++;
+				clearProgress(slot);
+				rewrite |= slotBit;
+			}
+			else
+			{
+				// stays pending until finished, so the entry can not be reused meanwhile
+				entry.lastWrite = now;
+				entry.statistics.failures++;
+				*pFailed |= slotBit;
+			}
+		}
+	}
+
+	return rewrite;
+}
+
+uint8_t ValloxWriteTable::restart(unsigned long now)
+{
+	for (uint8_t slot = 0; slot < VALLOX_MAX_WRITES; slot++)
+	{
+		if (m_Pending & (1 << slot))
+		{
+			m_Entries[slot].lastWrite = now;
+		}
+	}
+
+	// the read back polls were dropped, the writes are kept
+	m_Polled = 0;
+	m_Rejected = 0;
+	return m_Pending;
+}
+
+void ValloxWriteTable::finish(uint8_t slot)
+{
+	m_Pending &= ~(1 << slot);
+	clearProgress(slot);
+}
+
+uint8_t ValloxWriteTable::getVariable(uint8_t slot) const
+{
+	return m_Entries[slot].variable;
+}
+
+uint8_t ValloxWriteTable::getValue(uint8_t slot) const
+{
+	return m_Entries[slot].value;
+}
+
+bool ValloxWriteTable::isRejected(uint8_t slot) const
+{
+	return (m_Rejected & (1 << slot)) != 0;
+}
+
+uint16_t ValloxWriteTable::getLatency(uint8_t slot, unsigned long now) const
+{
+	return (uint16_t)(now - m_Entries[slot].firstWrite);
+}
+
+int8_t* ValloxWriteTable::getPrevious(uint8_t slot)
+{
+	return m_Entries[slot].previous;
+}
+
+bool ValloxWriteTable::getStatistics(uint8_t variable, ValloxWriteStatistics* pStatistics) const
+{
+	int8_t slot = find(variable);
+	if (slot < 0)
+	{
+		return false;
+	}
+
+	*pStatistics = m_Entries[slot].statistics;
+	return true;
+}
+
+#endif // VALLOX_WRITE_TRANSACTIONS
@@ -0,0 +1,119 @@
+// Writes waiting for their confirmation by the master.
+//
+// After a verified write the variable is read back. The write is confirmed
+// when the master answers the read back poll, sent after the write went out,
+// with the written value. Only the bits a write sets are compared, the master
+// keeps indicators in the others. Other reports of the variable, like
+// broadcasts which were on the wire before the write, do not count. A different value or no
+// answer within the timeout sends it again until the retries are used up. Like the
+// poll table every variable keeps its statistics in its entry until the entry
+// is reused, the least recently used idle entry first. An entry also keeps the
+// values its properties had before an optimistic write, so they can be
+// restored if the write never takes.
+//
+// The sketches on the Arduino cores send and forget, so there the table is
+// left out unless VALLOX_WRITE_TRANSACTIONS is set to 1.
+
+#ifndef ValloxWriteTable_h
+#define ValloxWriteTable_h
+
+#include <inttypes.h>
+
+#ifndef VALLOX_WRITE_TRANSACTIONS
+#ifdef ARDUINO
+#define VALLOX_WRITE_TRANSACTIONS 0
+#else
+#define VALLOX_WRITE_TRANSACTIONS 1
+#endif
+#endif
+
+#if VALLOX_WRITE_TRANSACTIONS
+
+// number of variables written at once, at most 8 as the slots are kept in a byte
+#ifndef VALLOX_MAX_WRITES
+#define VALLOX_MAX_WRITES 4
+#endif
+
+static_assert(VALLOX_MAX_WRITES > 0 && VALLOX_MAX_WRITES <= 8, "VALLOX_MAX_WRITES must be 1..8");
+
+extern "C" {
+	// confirmed is false if the master did not take the value after the last retry, latency is measured from the first write
+	typedef void(*WriteCompletedCallbackFunction)(void* pContext, uint8_t variable, bool confirmed, uint8_t value, uint16_t latencyMs);
+}
+
+// properties decoded from one variable: its raw value and up to 8 bits
+const uint8_t VALLOX_MAX_VARIABLE_PROPERTIES = 9;
+
+// confirmation statistics of a variable, latencies in ms from the first write to the confirmation
+struct ValloxWriteStatistics
+{
+	uint16_t writes;
+	uint16_t confirmations;
+	uint16_t retries;
+	uint16_t failures;		// writes given up after the last retry
+	uint16_t lastLatency;
+	uint16_t maxLatency;
+	uint32_t totalLatency;	// divide by confirmations for the average
+};
+
+enum ValloxWriteResult
+{
+	WriteIgnored,	// no write of that variable is pending
+	WriteStale,		// not the answer to the read back, it may be older than the write
+	WriteConfirmed,
+	WriteRejected	// the master holds another value, written again after the timeout
+};
+
+class ValloxWriteTable
+{
+public:
+	ValloxWriteTable();
+
+	// returns the slot or -1 if all entries are pending. *pStarted is false if a pending write of the variable was replaced.
+	int8_t start(uint8_t variable, uint8_t value, unsigned long now, bool* pStarted);
+
+	bool hasPending() const;
+	void sent(uint8_t variable);		// the write went out
+	void polled(uint8_t variable);		// the read back poll went out
+	// the master reported a value, readBack is true for its answer to our poll, mask has the bits a write sets
+	ValloxWriteResult received(uint8_t variable, uint8_t value, uint8_t mask, bool readBack, unsigned long now, uint8_t* pSlot);
+
+	// returns the slots to write again, *pFailed gets the slots given up after the last retry
+	uint8_t expire(unsigned long now, uint16_t timeout, uint8_t maxRetries, uint8_t* pFailed);
+	uint8_t restart(unsigned long now);		// restarts the timeout of all pending writes and returns their slots
+	void finish(uint8_t slot);				// releases a failed write
+
+	uint8_t getVariable(uint8_t slot) const;
+	uint8_t getValue(uint8_t slot) const;
+	bool isRejected(uint8_t slot) const;	// the last read back showed another value
+	uint16_t getLatency(uint8_t slot, unsigned long now) const;
+	int8_t* getPrevious(uint8_t slot);		// property values before the write
+
+	bool getStatistics(uint8_t variable, ValloxWriteStatistics* pStatistics) const;
+
+private:
+	struct Entry
+	{
+		uint8_t variable;
+		uint8_t value;
+		uint8_t retries;
+		unsigned long firstWrite;
+		unsigned long lastWrite;
+		int8_t previous[VALLOX_MAX_VARIABLE_PROPERTIES];
+		ValloxWriteStatistics statistics;
+	};
+
+	inline int8_t find(uint8_t variable) const;
+	inline void clearProgress(uint8_t slot);
+
+	Entry m_Entries[VALLOX_MAX_WRITES];
+	uint8_t m_Used;		// slots assigned to a variable
+	uint8_t m_Pending;	// slots waiting for a confirmation
+	uint8_t m_Sent;		// pending slots whose write is on the bus
+	uint8_t m_Polled;	// pending slots whose read back poll followed the write
+	uint8_t m_Rejected;	// pending slots whose read back showed another value
+};
+
+#endif // VALLOX_WRITE_TRANSACTIONS
+
+#endif // ValloxWriteTable_h